@@ -32,13 +32,10 @@ void Hwk10_C1_Driver()
   const int polyOrder = 1;
   const int n_gq = 7;
 
-  // Create mesh and FEM structure
-  UniformRectangularMesh2D mesh1 = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny);
-  UniformRectangularMesh2D mesh2 = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny);
-  mesh1.setBoundaryConditions(BC_Type::Dirichlet);
-  mesh2.setBoundaryConditions(BC_Type::Natural);
-  FEM2D<2> uFem = FEM2D<2>(mesh1, polyOrder + 1);
-  FEM2D<1> pFem = FEM2D<1>(mesh2, polyOrder);
+  // Create mesh and FEM structures, velocity and pressure share the mesh but not the boundary conditions
+  UniformRectangularMesh2D mesh = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny, MeshStorage::Implicit);
+  FEM2D<2> uFem = FEM2D<2>(mesh, polyOrder + 1, mesh.boundaryConditions(BC_Type::Dirichlet));
+  FEM2D<1> pFem = FEM2D<1>(mesh, polyOrder, mesh.boundaryConditions(BC_Type::Natural));
 
   // Create equation system
   StokesFluid eq = StokesFluid(uFem, pFem, f1, f2, nu, rho);
@@ -32,13 +32,10 @@ void Hwk10_C2_Driver()
   const int polyOrder = 1;
   const int n_gq = 7;
 
-  // Create mesh and FEM structure
-  UniformRectangularMesh2D mesh1 = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny);
-  UniformRectangularMesh2D mesh2 = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny);
-  mesh1.setBoundaryConditions(BC_Type::Dirichlet);
-  mesh2.setBoundaryConditions(BC_Type::Natural);
-  FEM2D<2> uFem = FEM2D<2>(mesh1, polyOrder + 1);
-  FEM2D<1> pFem = FEM2D<1>(mesh2, polyOrder);
+  // Create mesh and FEM structures, velocity and pressure share the mesh but not the boundary conditions
+  UniformRectangularMesh2D mesh = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny, MeshStorage::Implicit);
+  FEM2D<2> uFem = FEM2D<2>(mesh, polyOrder + 1, mesh.boundaryConditions(BC_Type::Dirichlet));
+  FEM2D<1> pFem = FEM2D<1>(mesh, polyOrder, mesh.boundaryConditions(BC_Type::Natural));
 
   // Create equation system
   StokesFluid eq = StokesFluid(uFem, pFem, f1, f2, nu, rho);
@@ -62,12 +59,15 @@ void Hwk10_C2_Driver()
   // Use Newton's method to find u(x, y) = 0
   const int maxIterations = 100;
   real x = 0.0, y = 0.5;
+  FieldProbe2D<2> probe = FieldProbe2D<2>(uFem);
   for (int n = 0; n < maxIterations; ++n)
   {
+    const FieldSample2D<2> u = probe.evaluate(x, y);
+
     // Compute Jacobian
     Matrix J = Matrix(2);
-    J[0][0] = uFem.evaluate(u1, x, y, 1, 0);  J[0][1] = uFem.evaluate(u1, x, y, 0, 1);
-    J[1][0] = uFem.evaluate(u2, x, y, 1, 0);  J[1][1] = uFem.evaluate(u2, x, y, 0, 1);
+    J[0][0] = u.xDerivative[u1];  J[0][1] = u.yDerivative[u1];
+    J[1][0] = u.xDerivative[u2];  J[1][1] = u.yDerivative[u2];
 
     // Invert matrix
     const real determinant = J[0][0] * J[1][1] - J[0][1] * J[1][0];
@@ -80,8 +80,8 @@ void Hwk10_C2_Driver()
     J /= determinant;
 
     // Update solution
-    const real eps1 = J[0][0] * uFem.evaluate(u1, x, y) + J[0][1] * uFem.evaluate(u2, x, y);
-    const real eps2 = J[1][0] * uFem.evaluate(u1, x, y) + J[1][1] * uFem.evaluate(u2, x, y);
+    const real eps1 = J[0][0] * u.value[u1] + J[0][1] * u.value[u2];
+    const real eps2 = J[1][0] * u.value[u1] + J[1][1] * u.value[u2];
     x -= eps1;
     y -= eps2;
 
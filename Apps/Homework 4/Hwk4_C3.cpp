@@ -12,11 +12,9 @@ static real analyticalSolutionDerivative(real x) { return cosl(x) - x * sinl(x);
 void Hwk4_C3_Driver()
 {
   const real xL = 0, xR = 1;
-  const int p = 2, n_gq = 3;
+  const int n_gq = 3;
 
-  std::ofstream file1("ErrorRegression.csv");
-  std::ofstream file2("DerivativeErrorRegression.csv");
-  for (int n = 10; n < 80; n += 10)
+  ConvergenceStudy study = ConvergenceStudy("Hwk4_C3", { "L2", "H1 seminorm" }, [=](const int n, const int p)
   {
     // Create mesh
     UniformMesh1D mesh = UniformMesh1D(xL, xR, n);
@@ -28,16 +26,17 @@ void Hwk4_C3_Driver()
 
     // Solve system
     equation.update(n_gq);
-    print(FE_Error1DGlobal(fem, analyticalSolution, n_gq, 0));
 
-    // Write regression
-    const real h = (xR - xL) / n;
-    file1 << logl(h) << ", " << logl(FE_Error1DGlobal(fem, analyticalSolution, n_gq, 0)) << std::endl;
-    file2 << logl(h) << ", " << logl(FE_Error1DGlobal(fem, analyticalSolutionDerivative, n_gq, 1)) << std::endl;
-  }
-  file1.close();
-  file2.close();
-  std::cin.get();
-  remove("ErrorRegression.csv");
-  remove("DerivativeErrorRegression.csv");
+    ConvergenceStudy::LevelResult result = ConvergenceStudy::LevelResult();
+    result.h = (xR - xL) / n;
+    result.errors = { FE_Error1DGlobal(fem, analyticalSolution, n_gq, 0), FE_Error1DGlobal(fem, analyticalSolutionDerivative, n_gq, 1) };
+    result.memoryBytes = (size_t)fem.Ng * fem.Ng * sizeof(real);  // Dense system matrix
+    return result;
+  });
+  study.run({ 10, 20, 30, 40, 50, 60, 70 }, { 2 });
+
+  for (const ConvergenceStudy::Level& level : study.levels())
+    print(level.result.errors[0]);
+  study.printSummary();
+  study.writeReport("ConvergenceStudy.json");
 }
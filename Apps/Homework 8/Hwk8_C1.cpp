@@ -24,15 +24,13 @@ void Hwk8_C1_Driver()
   const real x = (A1.x + A2.x + A3.x) / 3;
   const real y = (A1.y + A2.y + A3.y) / 3;
 
-  // Calculate H1 error
-  const real H1_x = FE_Error2DGlobal(u, fem, dfdx, n_gq, 1, 0);
-  const real H1_y = FE_Error2DGlobal(u, fem, dfdy, n_gq, 0, 1);
-  const real H1 = sqrtl(H1_x * H1_x + H1_y * H1_y);
+  // Calculate L2 and H1 errors in one pass
+  const ErrorNorms2D errors = FE_ErrorNorms2D(u, fem, n_gq, f, dfdx, dfdy);
 
   // Print values
   print(fem.evaluate(u, x, y));
   print(fem.evaluate(u, x, y, 1, 0));
   print(fem.evaluate(u, x, y, 0, 1));
-  print(FE_Error2DGlobal(u, fem, f, n_gq, 0, 0));
-  print(H1);
+  print(errors.L2);
+  print(errors.H1Seminorm);
 }
@@ -25,7 +25,7 @@ void Hwk9_C2_Driver()
   const int n_gq = 7;
 
   // Create mesh and FEM structure
-  UniformRectangularMesh2D mesh = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny);
+  UniformRectangularMesh2D mesh = UniformRectangularMesh2D(xMin, xMax, yMin, yMax, nx, ny, MeshStorage::Implicit);
   mesh.setBoundaryConditions(BC_Type::Natural);
   FEM2D<1> fem = FEM2D<1>(mesh, p);
 
@@ -6,6 +6,7 @@
 #include "Meshing/1D/UniformMesh1D.h"
 #include "Meshing/2D/UniformRectangularMesh2D.h"
 #include "Meshing/2D/UnstructuredMesh2D.h"
+#include "Meshing/2D/FieldProbe2D.h"
 
 // Equation systems
 #include "EquationSystems/1D/Elliptic1DABCF.h"
@@ -13,6 +14,7 @@
 #include "EquationSystems/2D/StokesFluid.h"
 
 #include "ErrorAnalysis/ErrorAnalysis.h"
+#include "ErrorAnalysis/ConvergenceStudy.h"
 
 void Interpolation_Driver();
 void Hwk4_C1_Driver();
@@ -17,6 +17,6 @@ void Interpolation_Driver()
     std::string fileName = "Out";
     fileName += std::to_string(p);
     fileName += ".txt";
-    fem.plot(fileName, false, 1000);
+    fem.plot(fileName, 1000);
   }
 }
\ No newline at end of file
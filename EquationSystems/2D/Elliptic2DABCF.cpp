@@ -1,10 +1,12 @@
 #include "Precompilied.h"
 #include "Elliptic2DABCF.h"
+#include "Utilities/TaskGraph.h"
 
 static constexpr int u = 0;
 
-Elliptic2DABCF::Elliptic2DABCF(FEM2D<1>& uFem, real2DFunction aFunc, real2DFunction bFunc, real2DFunction cFunc, real2DFunction fFunc, real2DFunction naturalBoundaryCondition)
-  : fem(uFem), a(aFunc), b(bFunc), c(cFunc), f(fFunc), naturalBC(naturalBoundaryCondition)
+Elliptic2DABCF::Elliptic2DABCF(FEM2D<1>& uFem, real2DFunction aFunc, real2DFunction bFunc, real2DFunction cFunc, real2DFunction fFunc, real2DFunction naturalBoundaryCondition,
+                               const AssemblyMode assembly)
+  : fem(uFem), a(aFunc), b(bFunc), c(cFunc), f(fFunc), naturalBC(naturalBoundaryCondition), assemblyMode(assembly)
 {
 }
 
@@ -15,38 +17,73 @@ int Elliptic2DABCF::neq() const
 
 Vector Elliptic2DABCF::solveSystem(const int n_gq) const
 {
+  if (assemblyMode == AssemblyMode::Condensed)
+    return solveCondensedSystem(n_gq);
+
+  Matrix* M_xx = nullptr;
+  Matrix* M_yy = nullptr;
+  Matrix* M_0x = nullptr;
+  Matrix* M_0y = nullptr;
+  Matrix* M_00 = nullptr;
+  Vector* f_h = nullptr;
+  Vector* bc_n = nullptr;
+  Vector* bc_eM_xx = nullptr;
+  Vector* bc_eM_yy = nullptr;
+  Vector* bc_eM_0x = nullptr;
+  Vector* bc_eM_0y = nullptr;
+  Vector* bc_eM_00 = nullptr;
+  Matrix* A = nullptr;
+  Vector* rhs = nullptr;
+  Vector* solution = nullptr;
+
+  // The operators are independent of each other until they are summed,
+  // so they are assembled concurrently
+  TaskGraph graph("Elliptic2DABCF::solveSystem");
+
   // Create mass matrices and load vector
-  Matrix* M_xx = FE_MassMatrix2D(fem, a, n_gq, 1, 0);
-  Matrix* M_yy = FE_MassMatrix2D(fem, a, n_gq, 0, 1);
-  Matrix* M_0x = FE_MassMatrix2D(fem, b, n_gq, 0, 0, 1, 0);
-  Matrix* M_0y = FE_MassMatrix2D(fem, b, n_gq, 0, 0, 0, 1);
-  Matrix* M_00 = FE_MassMatrix2D(fem, c, n_gq, 0, 0);
-  Vector* f_h = FE_LoadVector2D(fem, f, n_gq, 0, 0);
+  const int assembleM_xx = graph.add("M_xx", [&]() { M_xx = FE_MassMatrix2D(fem, a, n_gq, 1, 0); });
+  const int assembleM_yy = graph.add("M_yy", [&]() { M_yy = FE_MassMatrix2D(fem, a, n_gq, 0, 1); });
+  const int assembleM_0x = graph.add("M_0x", [&]() { M_0x = FE_MassMatrix2D(fem, b, n_gq, 0, 0, 1, 0); });
+  const int assembleM_0y = graph.add("M_0y", [&]() { M_0y = FE_MassMatrix2D(fem, b, n_gq, 0, 0, 0, 1); });
+  const int assembleM_00 = graph.add("M_00", [&]() { M_00 = FE_MassMatrix2D(fem, c, n_gq, 0, 0); });
+  const int assemblef_h = graph.add("f_h", [&]() { f_h = FE_LoadVector2D(fem, f, n_gq, 0, 0); });
 
   // Create boundary vectors
-  Vector* bc_n = constructNaturalBoundaryVector2D(fem, naturalBC, n_gq);
-  Vector* bc_eM_xx = constructEssentialBoundaryVector2D(fem, u, M_xx);
-  Vector* bc_eM_yy = constructEssentialBoundaryVector2D(fem, u, M_yy);
-  Vector* bc_eM_0x = constructEssentialBoundaryVector2D(fem, u, M_0x);
-  Vector* bc_eM_0y = constructEssentialBoundaryVector2D(fem, u, M_0y);
-  Vector* bc_eM_00 = constructEssentialBoundaryVector2D(fem, u, M_00);
+  const int assemblebc_n = graph.add("bc_n", [&]() { bc_n = constructNaturalBoundaryVector2D(fem, naturalBC, n_gq); });
+  const int assemblebc_eM_xx = graph.add("bc_eM_xx", [&]() { bc_eM_xx = constructEssentialBoundaryVector2D(fem, u, M_xx); }, { assembleM_xx });
+  const int assemblebc_eM_yy = graph.add("bc_eM_yy", [&]() { bc_eM_yy = constructEssentialBoundaryVector2D(fem, u, M_yy); }, { assembleM_yy });
+  const int assemblebc_eM_0x = graph.add("bc_eM_0x", [&]() { bc_eM_0x = constructEssentialBoundaryVector2D(fem, u, M_0x); }, { assembleM_0x });
+  const int assemblebc_eM_0y = graph.add("bc_eM_0y", [&]() { bc_eM_0y = constructEssentialBoundaryVector2D(fem, u, M_0y); }, { assembleM_0y });
+  const int assemblebc_eM_00 = graph.add("bc_eM_00", [&]() { bc_eM_00 = constructEssentialBoundaryVector2D(fem, u, M_00); }, { assembleM_00 });
 
   // Remove boundary indices (since we already know the values at those nodes)
-  removeBoundaryIndices(M_xx, fem.boundaryIndices);
-  removeBoundaryIndices(M_yy, fem.boundaryIndices);
-  removeBoundaryIndices(M_0x, fem.boundaryIndices);
-  removeBoundaryIndices(M_0y, fem.boundaryIndices);
-  removeBoundaryIndices(M_00, fem.boundaryIndices);
-  removeBoundaryIndices(f_h, fem.boundaryIndices);
-  removeBoundaryIndices(bc_n, fem.boundaryIndices);
-  removeBoundaryIndices(bc_eM_xx, fem.boundaryIndices);
-  removeBoundaryIndices(bc_eM_yy, fem.boundaryIndices);
-  removeBoundaryIndices(bc_eM_0x, fem.boundaryIndices);
-  removeBoundaryIndices(bc_eM_0y, fem.boundaryIndices);
-  removeBoundaryIndices(bc_eM_00, fem.boundaryIndices);
+  // and sum up operators
+  const int sumMatrices = graph.add("sum matrices", [&]()
+  {
+    removeBoundaryIndices(M_xx, fem.boundaryIndices);
+    removeBoundaryIndices(M_yy, fem.boundaryIndices);
+    removeBoundaryIndices(M_0x, fem.boundaryIndices);
+    removeBoundaryIndices(M_0y, fem.boundaryIndices);
+    removeBoundaryIndices(M_00, fem.boundaryIndices);
+    A = new Matrix(*M_xx + *M_yy + *M_0x + *M_0y + *M_00);
+  }, { assemblebc_eM_xx, assemblebc_eM_yy, assemblebc_eM_0x, assemblebc_eM_0y, assemblebc_eM_00 });
+  const int sumVectors = graph.add("sum vectors", [&]()
+  {
+    removeBoundaryIndices(f_h, fem.boundaryIndices);
+    removeBoundaryIndices(bc_n, fem.boundaryIndices);
+    removeBoundaryIndices(bc_eM_xx, fem.boundaryIndices);
+    removeBoundaryIndices(bc_eM_yy, fem.boundaryIndices);
+    removeBoundaryIndices(bc_eM_0x, fem.boundaryIndices);
+    removeBoundaryIndices(bc_eM_0y, fem.boundaryIndices);
+    removeBoundaryIndices(bc_eM_00, fem.boundaryIndices);
+    rhs = new Vector(*f_h + *bc_n + *bc_eM_xx + *bc_eM_yy + *bc_eM_0x + *bc_eM_0y + *bc_eM_00);
+  }, { assemblef_h, assemblebc_n, assemblebc_eM_xx, assemblebc_eM_yy, assemblebc_eM_0x, assemblebc_eM_0y, assemblebc_eM_00 });
 
   // Solve linear system for coefficients on unknown nodes
-  Vector coefficients = solve(*M_xx + *M_yy + *M_0x + *M_0y + *M_00, *f_h + *bc_n + *bc_eM_xx + *bc_eM_yy + *bc_eM_0x + *bc_eM_0y + *bc_eM_00);
+  graph.add("solve", [&]() { solution = new Vector(solveGlobalSystem(*A, *rhs, n_gq)); }, { sumMatrices, sumVectors });
+
+  graph.run();
+  Vector coefficients = std::move(*solution);
 
   // Add back in boundary indices to coefficient vector
   for (int n = 0; n < fem.boundaryIndices.size(); ++n)
@@ -68,10 +105,233 @@ Vector Elliptic2DABCF::solveSystem(const int n_gq) const
   delete bc_eM_0x;
   delete bc_eM_0y;
   delete bc_eM_00;
+  delete A;
+  delete rhs;
+  delete solution;
 
   return coefficients;
 }
 
+Vector Elliptic2DABCF::solveCondensedSystem(const int n_gq) const
+{
+  const int& p = fem.polynomialOrder;
+  const int numNodes = gauss2DNumNodes(n_gq, integrandDegree2D(c, 2 * p, p));
+  const std::vector<std::array<real, 2>>& refNodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& refWeights = gauss2DWeightsRef(numNodes);
+
+  StaticCondensation2D<1> condensation = StaticCondensation2D<1>(fem);
+  Matrix A = Matrix(condensation.numSkeletonNodes);
+  Vector rhs = Vector(condensation.numSkeletonNodes);
+  dispatchPolynomialOrder(p, [&](auto order)
+  {
+    constexpr int P = decltype(order)::value;
+    using ClassMatrices = std::vector<LocalMatrix<real, RefBasisTable2D<P>::n, RefBasisTable2D<P>::n>>;
+    using ClassVectors = std::vector<LocalArray<real, RefBasisTable2D<P>::n>>;
+    const RefBasisTable2D<P> basis = RefBasisTable2D<P>(p, refNodes, fem.basisType);
+    const int n = basis.numShapes;
+
+    // On elements that are congruent to others, the term of each coefficient that
+    // is constant on them is that of their class scaled by the coefficient
+    const ClassMatrices classM_xx = congruentElementMassMatrices2D<P, P>(fem.mesh, basis, basis, refWeights, 1, 0, 1, 0);
+    const ClassMatrices classM_yy = congruentElementMassMatrices2D<P, P>(fem.mesh, basis, basis, refWeights, 0, 1, 0, 1);
+    const ClassMatrices classM_0x = congruentElementMassMatrices2D<P, P>(fem.mesh, basis, basis, refWeights, 0, 0, 1, 0);
+    const ClassMatrices classM_0y = congruentElementMassMatrices2D<P, P>(fem.mesh, basis, basis, refWeights, 0, 0, 0, 1);
+    const ClassMatrices classM_00 = congruentElementMassMatrices2D<P, P>(fem.mesh, basis, basis, refWeights, 0, 0, 0, 0);
+    const ClassVectors classf_h = congruentElementLoadVectors2D<P>(fem.mesh, basis, refWeights, 0, 0);
+
+    // Elements are processed in batches of RealPack::width, interleaved lane by lane
+    constexpr int W = RealPack::width;
+
+    // Elements of one color share no FE nodes, so they are condensed in parallel
+    for (const std::vector<int>& elements : fem.elementColors)
+      parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+      {
+        std::vector<real> phi = std::vector<real>(numNodes * n * W);
+        std::vector<real> phi_x = std::vector<real>(numNodes * n * W);
+        std::vector<real> phi_y = std::vector<real>(numNodes * n * W);
+        std::vector<real> weights = std::vector<real>(numNodes * W);
+        std::vector<real> termMatrices = std::vector<real>(n * n * W);
+        std::vector<real> termVectors = std::vector<real>(n * W);
+        std::vector<real> locals = std::vector<real>(W * n * n);
+        std::vector<real> localVectors = std::vector<real>(W * n);
+        std::vector<std::array<real, 2>> GLnodes = std::vector<std::array<real, 2>>(W * numNodes);
+        std::vector<real> aValues = std::vector<real>(W * numNodes);
+        std::vector<real> bValues = std::vector<real>(W * numNodes);
+        std::vector<real> cValues = std::vector<real>(W * numNodes);
+        std::vector<real> fValues = std::vector<real>(W * numNodes);
+        for (int c0 = begin; c0 < end; c0 += W)
+        {
+          const int batchSize = std::min(W, end - c0);
+          const int* batch = &elements[c0];
+          ElementGeometry2D geometries[W];
+          int classes[W];
+          GLnodes.resize(batchSize * numNodes);
+          for (int l = 0; l < batchSize; ++l)
+          {
+            geometries[l] = fem.mesh.elementGeometry(batch[l]);
+            classes[l] = fem.mesh.congruenceClass(batch[l]);
+            for (int k = 0; k < numNodes; ++k)
+              GLnodes[l * numNodes + k] = geometries[l].toLocal(refNodes[k][0], refNodes[k][1]);
+            basis.mapToElementInterleaved(geometries[l], 0, 0, l, phi.data());
+            basis.mapToElementInterleaved(geometries[l], 1, 0, l, phi_x.data());
+            basis.mapToElementInterleaved(geometries[l], 0, 1, l, phi_y.data());
+          }
+
+          // Evaluate the coefficients at all quadrature nodes of the batch at once
+          evaluateCoefficientOnElements2D(a, batch, batchSize, GLnodes, aValues);
+          evaluateCoefficientOnElements2D(b, batch, batchSize, GLnodes, bValues);
+          evaluateCoefficientOnElements2D(c, batch, batchSize, GLnodes, cValues);
+          evaluateCoefficientOnElements2D(f, batch, batchSize, GLnodes, fValues);
+
+          // Folds the weights of a coefficient into weights, for the elements of the batch
+          // on which its term is not scaled from that of their class
+          bool computed[W];
+          const auto foldWeights = [&](const std::vector<real>& values)
+          {
+            int numComputed = 0;
+            for (int l = 0; l < batchSize; ++l)
+            {
+              computed[l] = classes[l] < 0 || !isConstantOnElement(&values[l * numNodes], numNodes);
+              if (computed[l])
+                ++numComputed;
+            }
+            for (int l = 0; l < W; ++l)
+              for (int k = 0; k < numNodes; ++k)
+                weights[k * W + l] = l < batchSize && computed[l] ? values[l * numNodes + k] * abs(geometries[l].determinant) * refWeights[k] : 0.0;
+            return numComputed;
+          };
+
+          // Adds the term sum_k value_k * test_i * trial_j of a coefficient to the local matrices
+          const auto addMatrixTerm = [&](const std::vector<real>& values, const real* test, const real* trial, const ClassMatrices& classMatrices)
+          {
+            const int numComputed = foldWeights(values);
+            for (int l = 0; l < batchSize; ++l)
+              if (!computed[l])
+                for (int i = 0; i < n; ++i)
+                  for (int j = 0; j < n; ++j)
+                    locals[(l * n + i) * n + j] += values[l * numNodes] * classMatrices[classes[l]][i][j];
+            if (numComputed == 0)
+              return;
+
+            elementMassMatrices2D<P, P>(test, trial, weights.data(), numNodes, n, n, termMatrices.data());
+            for (int l = 0; l < batchSize; ++l)
+              if (computed[l])
+                for (int i = 0; i < n; ++i)
+                  for (int j = 0; j < n; ++j)
+                    locals[(l * n + i) * n + j] += termMatrices[(i * n + j) * W + l];
+          };
+
+          // Local matrix of all operators, term by term like those of solveSystem
+          std::fill(locals.begin(), locals.end(), 0.0);
+          addMatrixTerm(aValues, phi_x.data(), phi_x.data(), classM_xx);
+          addMatrixTerm(aValues, phi_y.data(), phi_y.data(), classM_yy);
+          addMatrixTerm(bValues, phi.data(), phi_x.data(), classM_0x);
+          addMatrixTerm(bValues, phi.data(), phi_y.data(), classM_0y);
+          addMatrixTerm(cValues, phi.data(), phi.data(), classM_00);
+
+          // Local load vector
+          std::fill(localVectors.begin(), localVectors.end(), 0.0);
+          const int numComputed = foldWeights(fValues);
+          if (numComputed > 0)
+            elementLoadVectors2D<P>(phi.data(), weights.data(), numNodes, n, termVectors.data());
+          for (int l = 0; l < batchSize; ++l)
+            for (int j = 0; j < n; ++j)
+              localVectors[l * n + j] = computed[l] ? termVectors[j * W + l] : fValues[l * numNodes] * classf_h[classes[l]][j];
+
+          for (int l = 0; l < batchSize; ++l)
+            condensation.condense(batch[l], &locals[l * n * n], &localVectors[l * n], A, rhs);
+        }
+      });
+  });
+
+  // Natural boundary conditions only involve vertex and edge nodes, as
+  // interior shape functions vanish on the boundary
+  Vector* bc_n = constructNaturalBoundaryVector2D(fem, naturalBC, n_gq);
+  for (int i = 0; i < condensation.numSkeletonNodes; ++i)
+    rhs[i] += (*bc_n)[i];
+  delete bc_n;
+
+  // Boundary nodes are vertex or edge nodes, so essential boundary
+  // conditions are applied to the reduced system
+  for (int i = 0; i < condensation.numSkeletonNodes; ++i)
+    for (int n = 0; n < (int)fem.boundaryIndices.size(); ++n)
+    {
+      const int& j = fem.boundaryIndices[n];
+      rhs[i] -= A[i][j] * fem.FENodes[j][u];
+    }
+  removeBoundaryIndices(&A, fem.boundaryIndices);
+  removeBoundaryIndices(&rhs, fem.boundaryIndices);
+  Vector skeletonCoefficients = solveGlobalSystem(A, rhs, n_gq);
+
+  // Add back in boundary values, on which the interior nodes depend
+  for (int n = 0; n < (int)fem.boundaryIndices.size(); ++n)
+  {
+    const int& i = fem.boundaryIndices[n];
+    skeletonCoefficients.insert(fem.FENodes[i][u], i);
+  }
+
+  return condensation.recover(skeletonCoefficients);
+}
+
+Matrix* Elliptic2DABCF::assembleOperator(const FEM2D<1>& levelFem, const int n_gq) const
+{
+  Matrix* A = FE_MassMatrix2D(levelFem, a, n_gq, 1, 0);
+  Matrix* operators[4] = { FE_MassMatrix2D(levelFem, a, n_gq, 0, 1),
+                           FE_MassMatrix2D(levelFem, b, n_gq, 0, 0, 1, 0),
+                           FE_MassMatrix2D(levelFem, b, n_gq, 0, 0, 0, 1),
+                           FE_MassMatrix2D(levelFem, c, n_gq, 0, 0) };
+  for (Matrix* M : operators)
+  {
+    for (int i = 0; i < A->rows(); ++i)
+      for (int j = 0; j < A->columns(); ++j)
+        (*A)[i][j] += (*M)[i][j];
+    delete M;
+  }
+  removeBoundaryIndices(A, levelFem.boundaryIndices);
+  return A;
+}
+
+Vector Elliptic2DABCF::solveGlobalSystem(Matrix& A, const Vector& rhs, const int n_gq) const
+{
+  if (!iterativeSolve)
+    return solve(A, rhs);
+
+  // p-multigrid works on all FE nodes, so the reduced system
+  // of a condensed assembly is preconditioned by its diagonal instead
+  std::unique_ptr<PMultigrid2D<1>> multigrid;
+  std::vector<real> inverseDiagonal;
+  Preconditioner preconditioner;
+  if (assemblyMode == AssemblyMode::Condensed)
+  {
+    inverseDiagonal.resize(A.rows());
+    for (int i = 0; i < A.rows(); ++i)
+      inverseDiagonal[i] = 1.0 / A[i][i];
+    preconditioner = [&inverseDiagonal](const Vector& r, Vector& z)
+    {
+      for (int i = 0; i < (int)inverseDiagonal.size(); ++i)
+        z[i] = inverseDiagonal[i] * r[i];
+    };
+  }
+  else
+  {
+    multigrid = std::make_unique<PMultigrid2D<1>>(fem, A, [&](const FEM2D<1>& levelFem) { return assembleOperator(levelFem, n_gq); });
+    preconditioner = [&multigrid](const Vector& r, Vector& z) { multigrid->apply(r, z); };
+  }
+
+  KrylovResult result = solveKrylov(krylovMethod, A, rhs, preconditioner, krylovTolerance, maxKrylovIterations);
+  if (!result.converged)
+    LOG("Krylov solver did not converge", LogLevel::Warning);
+  return std::move(result.x);
+}
+
+void Elliptic2DABCF::useKrylovSolver(const KrylovMethod method, const real tolerance, const int maxIterations)
+{
+  iterativeSolve = true;
+  krylovMethod = method;
+  krylovTolerance = tolerance;
+  maxKrylovIterations = maxIterations;
+}
+
 void Elliptic2DABCF::update(const int n_gq)
 {
   const int& p = fem.polynomialOrder;
@@ -79,7 +339,7 @@ void Elliptic2DABCF::update(const int n_gq)
 
   // Modify finite element solution
   for (int K = 0; K < fem.mesh.size; ++K)
-    for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
+    for (int j = 0; j < numLocalNodes2D(p); ++j)
     {
       ASSERT(!std::isinf(u_h[fem[K][j]]), "FE update results in Infinite value");
       ASSERT(!std::isnan(u_h[fem[K][j]]), "FE update results in NaN");
@@ -1,36 +1,82 @@
 #pragma once
 #include "Precompilied.h"
 #include "EquationSystem2D.h"
+#include "StaticCondensation2D.h"
+#include "PMultigrid2D.h"
+#include "LinearAlgebra/KrylovSolvers.h"
 #include "L2Projection/L2Projection.h"
 
 /*
   Equation class for BVP of the form -div(a*grad(u)) + b*div(u) + cu = f.  With the boundary
   condition u|dOmega_D = g_D.
+
+  With AssemblyMode::Condensed, the interior FE nodes are eliminated element by
+  element before the global solve (see StaticCondensation2D), which for p >= 3
+  shrinks the global system to the vertex and edge nodes.
+
+  By default the global system is solved by LU decomposition.  With
+  useKrylovSolver, it is solved iteratively instead, preconditioned by a
+  p-multigrid V-cycle over the orders p, p - 1, ..., 1 (see PMultigrid2D), or
+  for a condensed assembly by the diagonal of the reduced system.
 */
 class Elliptic2DABCF : public EquationSystem2D
 {
 public:
   Elliptic2DABCF() = delete;
 
-  Elliptic2DABCF(FEM2D<1>& uFem, real2DFunction aFunc, real2DFunction bFunc, real2DFunction cFunc, real2DFunction fFunc, real2DFunction naturalBoundaryCondition);
+  Elliptic2DABCF(FEM2D<1>& uFem, real2DFunction aFunc, real2DFunction bFunc, real2DFunction cFunc, real2DFunction fFunc, real2DFunction naturalBoundaryCondition,
+                 const AssemblyMode assembly = AssemblyMode::Full);
 
   int neq() const override;
 
   /*
     \returns coefficients of FE approximation u_h.
 
-    \param n_gq: Number of Gaussian quadrature nodes.
+    \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
 
     Essential boundary conditions should be enforeced
-    before each call of this function.
+    before each call of this function.  With a condensed assembly, the
+    coefficients of boundary nodes are their prescribed values, otherwise 0.
   */
   Vector solveSystem(const int n_gq) const override;
 
   void update(const int n_gq) override;
 
+  /*
+    Solves the global system with a Krylov method preconditioned by p-multigrid,
+    or with AssemblyMode::Condensed by the diagonal of the reduced system.  The
+    conjugate gradient method requires a symmetric system, so b must be 0 for it.
+
+    \param tolerance: Relative residual at which the iteration stops.
+  */
+  void useKrylovSolver(const KrylovMethod method, const real tolerance = 1e-10, const int maxIterations = 500);
+
 private:
   real2DFunction a, b, c, f;
   real2DFunction naturalBC;
 
   FEM2D<1>& fem;
+  AssemblyMode assemblyMode;
+
+  bool iterativeSolve = false;
+  KrylovMethod krylovMethod = KrylovMethod::BiCGStab;
+  real krylovTolerance = 1e-10;
+  int maxKrylovIterations = 500;
+
+  /*
+    Solves the system with the interior nodes condensed out, see solveSystem.
+  */
+  Vector solveCondensedSystem(const int n_gq) const;
+
+  /*
+    \returns the global matrix of all operators on levelFem, with the rows and
+    columns of boundary nodes removed.  Used for the coarse levels of p-multigrid.
+  */
+  Matrix* assembleOperator(const FEM2D<1>& levelFem, const int n_gq) const;
+
+  /*
+    \returns solution of the global system A * x = rhs, by LU decomposition or
+    by a Krylov method, see useKrylovSolver.  A may be overwritten.
+  */
+  Vector solveGlobalSystem(Matrix& A, const Vector& rhs, const int n_gq) const;
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "Meshing/2D/FEM2D.h"
 #include "Functions/Gauss-LegendreNodes.h"
 #include "Functions/LagrangeShapeFunctions2D.h"
+#include "Functions/Coefficients.h"
+#include "Utilities/TaskScheduler.h"
 
 /*
   Interface for a general 2D boundary value problem equation system.
@@ -45,51 +47,63 @@ Vector* constructEssentialBoundaryVector2D(const FEM2D<N>& fem1, const FEM2D<M>&
   return bc_e;
 }
 
-template<int N>
-Vector* constructNaturalBoundaryVector2D(const FEM2D<N>& fem, real2DFunction naturalBC, const int n_gq)
+template<int N, typename Function>
+Vector* constructNaturalBoundaryVector2D(const FEM2D<N>& fem, const Function& naturalBC, const int n_gq)
 {
   const int& p = fem.polynomialOrder;
+  const int numNodes = n_gq == AutomaticQuadrature ? gauss1DNumNodes(integrandDegree2D(naturalBC, p, p)) : n_gq;
 
   Vector* bc_n = new Vector(fem.Ng);
-  for (int K = 0; K < fem.mesh.size; ++K)
-  {
-    // Find boundary edge if element has one
-    for (int i = 0; i < 3; ++i)
-      for (int j = i + 1; j < 3; ++j)
+
+  // Elements of one color share no FE nodes, so they are assembled in parallel
+  for (const std::vector<int>& elements : fem.elementColors)
+    parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<real> gValues = std::vector<real>(numNodes);
+      for (int c = begin; c < end; ++c)
       {
-        const int I = fem.mesh.connectivityMatrix[K][i];
-        const int J = fem.mesh.connectivityMatrix[K][j];
-        if (fem.mesh.edgeTypeMatrix[I][J] == 1)
-        {
-          ASSERT(fem.mesh.edgeMatrix[I][J] > 0, "Nodes do not form an edge");
-          const int e = fem.mesh.edgeMatrix[I][J] - 1;
+        const int K = elements[c];
 
-          // Check to see if boundary conditions should be applied
-          const MeshNode2D& A1 = fem.mesh.meshNodes[fem.mesh.edgeArray[e][0]];
-          const MeshNode2D& A2 = fem.mesh.meshNodes[fem.mesh.edgeArray[e][1]];
-          ASSERT(A1.BC != BC_Type::Interior && A2.BC != BC_Type::Interior, "Nodes do not form boundary edge");
-          if (A1.BC == BC_Type::Natural || A2.BC == BC_Type::Natural)
+        // Find boundary edge if element has one
+        for (int i = 0; i < 3; ++i)
+          for (int j = i + 1; j < 3; ++j)
           {
-            // Grab 1D quadrature nodes along edge
-            std::vector<std::array<real, 2>> GLnodes = gaussEdgeNodesLocal(fem.mesh, e, n_gq);
-            std::vector<real> GLweights = gaussEdgeWeightsLocal(fem.mesh, e, n_gq);
-
-            for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
+            const int I = fem.mesh.elementNode(K, i);
+            const int J = fem.mesh.elementNode(K, j);
+            if (fem.mesh.edgeType(I, J) == 1)
             {
-              // Calculate inner product between naturalBC and j-th shape function on K
-              real innerProduct = 0.0;
-              for (int i = 0; i < n_gq; ++i)
+              const int e = fem.mesh.edgeIndex(I, J);
+              ASSERT(e >= 0, "Nodes do not form an edge");
+
+              // Check to see if boundary conditions should be applied,
+              // vertices are the first FE nodes and numbered like the mesh nodes
+              const FENode2D<N>& A1 = fem.FENodes[fem.mesh.edgeNode(e, 0)];
+              const FENode2D<N>& A2 = fem.FENodes[fem.mesh.edgeNode(e, 1)];
+              ASSERT(A1.BC != BC_Type::Interior && A2.BC != BC_Type::Interior, "Nodes do not form boundary edge");
+              if (A1.BC == BC_Type::Natural || A2.BC == BC_Type::Natural)
               {
-                const real& x = GLnodes[i][0];
-                const real& y = GLnodes[i][1];
-                const real integrand = naturalBC(x, y) * lagrangeShapeFunction2D(x, y, fem, K, j, 0, 0);
-                innerProduct += GLweights[i] * integrand;
+                // Grab 1D quadrature nodes along edge
+                std::vector<std::array<real, 2>> GLnodes = gaussEdgeNodesLocal(fem.mesh, e, numNodes);
+                std::vector<real> GLweights = gaussEdgeWeightsLocal(fem.mesh, e, numNodes);
+                evaluateCoefficient2D(naturalBC, GLnodes, gValues);
+
+                for (int j = 0; j < numLocalNodes2D(p); ++j)
+                {
+                  // Calculate inner product between naturalBC and j-th shape function on K
+                  real innerProduct = 0.0;
+                  for (int i = 0; i < numNodes; ++i)
+                  {
+                    const real& x = GLnodes[i][0];
+                    const real& y = GLnodes[i][1];
+                    const real integrand = gValues[i] * lagrangeShapeFunction2D(x, y, fem, K, j, 0, 0);
+                    innerProduct += GLweights[i] * integrand;
+                  }
+                  (*bc_n)[fem[K][j]] += innerProduct; // Accumulate to bc_n
+                }
               }
-              (*bc_n)[fem[K][j]] += innerProduct; // Accumulate to bc_n
             }
           }
-        }
       }
-  }
+    });
   return bc_n;
 }
\ No newline at end of file
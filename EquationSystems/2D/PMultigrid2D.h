@@ -0,0 +1,299 @@
+#pragma once
+#include "Precompilied.h"
+#include "Meshing/2D/FEM2D.h"
+#include "LinearAlgebra/Matrix.h"
+#include "LinearAlgebra/Vector.h"
+
+/*
+  p-multigrid preconditioner for the global system of a FEM2D.
+
+  The levels are FEM2D spaces of orders p, p - 1, ..., 1 on the same mesh, with
+  the same basis and boundary conditions.  A function of order q - 1 is also one
+  of order q, so the prolongation from level q - 1 to level q interpolates it
+  exactly at the FE nodes of level q (for a hierarchical basis, this copies the
+  modes the levels share).  Restriction is its transpose.
+
+  Each application of the preconditioner is one V-cycle: block Gauss-Seidel sweeps
+  on each level, forward before the coarse correction and backward after it, with
+  an LU solve at order 1.  The blocks are the FE nodes of each vertex, of each edge
+  and of the interior of each element, which keeps the smoother effective for the
+  strongly coupled nodes of high orders and for hierarchical bases.  For symmetric
+  positive definite systems the preconditioner is then symmetric positive definite
+  as well, so it can be used with conjugate gradients.
+
+  Systems are over the free FE nodes of each level, those that are not boundary
+  nodes, in the order left by EquationSystem2D::removeBoundaryIndices.
+*/
+template<int N>
+class PMultigrid2D
+{
+public:
+  PMultigrid2D() = delete;
+
+  /*
+    \param fineMatrix: System matrix of fem, which must outlive the preconditioner.
+    \param assemble: Callable of a coarser FEM2D that returns its system matrix as a new Matrix*.
+    \param smoothingSteps: Number of block Gauss-Seidel sweeps before and after each coarse correction.
+  */
+  template<typename Assemble>
+  PMultigrid2D(const FEM2D<N>& fem, const Matrix& fineMatrix, const Assemble& assemble, const int smoothingSteps = 2)
+    : numSmoothingSteps(smoothingSteps)
+  {
+    const int& p = fem.polynomialOrder;
+    const BoundaryConditions2D boundaryConditions = fem.boundaryConditions();
+
+    // Debug
+    ASSERT(smoothingSteps >= 0, "Number of smoothing steps must be non-negative");
+
+    levels.resize(p);
+    for (int q = 1; q < p; ++q)
+    {
+      levels[q - 1].fem = std::make_unique<FEM2D<N>>(fem.mesh, q, boundaryConditions, fem.basisType);
+      levels[q - 1].ownedMatrix.reset(assemble(*levels[q - 1].fem));
+      levels[q - 1].A = levels[q - 1].ownedMatrix.get();
+    }
+    levels[p - 1].A = &fineMatrix;
+    for (int q = 2; q <= p; ++q)
+    {
+      const FEM2D<N>& levelFem = q == p ? fem : *levels[q - 1].fem;
+      buildProlongation(levelFem, *levels[q - 2].fem, levels[q - 1]);
+      buildBlocks(levelFem, levels[q - 1]);
+    }
+
+    // LU decomposition of the coarsest level
+    const Matrix& A_1 = *levels[0].A;
+    coarseLU = std::make_unique<Matrix>(A_1.rows());
+    for (int i = 0; i < A_1.rows(); ++i)
+      for (int j = 0; j < A_1.columns(); ++j)
+        (*coarseLU)[i][j] = A_1[i][j];
+    decomposeLU(*coarseLU);
+  }
+
+  /*
+    Computes z = M^-1 r, with one V-cycle starting from z = 0.
+  */
+  void apply(const Vector& r, Vector& z) const
+  {
+    vCycle((int)levels.size() - 1, r, z);
+  }
+
+private:
+  struct Level
+  {
+    std::unique_ptr<FEM2D<N>> fem;        // FE space of a coarser level, nullptr for the finest level
+    std::unique_ptr<Matrix> ownedMatrix;  // System matrix of a coarser level
+    const Matrix* A = nullptr;            // System matrix of the level
+
+    // Prolongation from the next coarser level in compressed row storage, with a row per free FE node
+    std::vector<int> rowStarts;
+    std::vector<int> columns;
+    std::vector<real> values;
+
+    // Free FE nodes of each block of the smoother and the inverse of its diagonal block of A, row-major
+    std::vector<std::vector<int>> blocks;
+    std::vector<std::vector<real>> blockInverses;
+  };
+
+  std::vector<Level> levels;          // levels[q - 1] is of order q
+  std::unique_ptr<Matrix> coarseLU;   // LU decomposition of the system matrix of order 1
+  int numSmoothingSteps;
+
+  /*
+    \returns the index of each FE node among the free nodes, -1 for boundary nodes.
+  */
+  static std::vector<int> freeNodeIndices(const FEM2D<N>& fem)
+  {
+    std::vector<int> indices = std::vector<int>(fem.Ng, 0);
+    for (const int i : fem.boundaryIndices)
+      indices[i] = -1;
+    int numFree = 0;
+    for (int i = 0; i < fem.Ng; ++i)
+      if (indices[i] == 0)
+        indices[i] = numFree++;
+    return indices;
+  }
+
+  /*
+    Builds the prolongation from coarse to fine, both of which are FE spaces on the same mesh.
+  */
+  static void buildProlongation(const FEM2D<N>& fine, const FEM2D<N>& coarse, Level& level)
+  {
+    const int& pf = fine.polynomialOrder;
+    const int& pc = coarse.polynomialOrder;
+    const int nf = numLocalNodes2D(pf);
+    const int nc = numLocalNodes2D(pc);
+
+    // Coarse shape functions in terms of the fine ones on the reference element,
+    // from their values at the fine nodes
+    const std::vector<std::array<real, 2>> refNodes = refLagrangeNodes2D(pf);
+    Matrix V = Matrix(nf);
+    Matrix E = Matrix(nf, nc);
+    for (int i = 0; i < nf; ++i)
+    {
+      evaluateRefBasis2D<DynamicOrder>(fine.basisType, pf, refNodes[i][0], refNodes[i][1], 0, 0, V[i]);
+      evaluateRefBasis2D<DynamicOrder>(coarse.basisType, pc, refNodes[i][0], refNodes[i][1], 0, 0, E[i]);
+    }
+    const Matrix Vinv = inverse(V);
+    Matrix T = Matrix(nf, nc);
+    for (int i = 0; i < nf; ++i)
+      for (int k = 0; k < nf; ++k)
+        for (int j = 0; j < nc; ++j)
+          T[i][j] += Vinv[i][k] * E[k][j];
+
+    // Each fine FE node takes its row from the first element it belongs to
+    std::vector<int> ownerElements = std::vector<int>(fine.Ng, -1);
+    std::vector<int> ownerLocalIndices = std::vector<int>(fine.Ng, -1);
+    for (int K = 0; K < fine.mesh.size; ++K)
+      for (int i = 0; i < nf; ++i)
+        if (ownerElements[fine[K][i]] < 0)
+        {
+          ownerElements[fine[K][i]] = K;
+          ownerLocalIndices[fine[K][i]] = i;
+        }
+
+    const std::vector<int> fineIndices = freeNodeIndices(fine);
+    const std::vector<int> coarseIndices = freeNodeIndices(coarse);
+    level.rowStarts.assign(1, 0);
+    for (int g = 0; g < fine.Ng; ++g)
+    {
+      if (fineIndices[g] < 0)
+        continue;
+
+      const int& K = ownerElements[g];
+      const int& i = ownerLocalIndices[g];
+      for (int j = 0; j < nc; ++j)
+      {
+        const int& h = coarseIndices[coarse[K][j]];
+        const real value = fine.shapeSign(K, i) * T[i][j] * coarse.shapeSign(K, j);
+        if (h >= 0 && abs(value) > TOLERANCE)
+        {
+          level.columns.push_back(h);
+          level.values.push_back(value);
+        }
+      }
+      level.rowStarts.push_back((int)level.columns.size());
+    }
+  }
+
+  /*
+    Groups the free FE nodes of a level into the blocks of the smoother, by the
+    vertex, edge or element interior they belong to, and inverts their diagonal blocks.
+  */
+  static void buildBlocks(const FEM2D<N>& fem, Level& level)
+  {
+    const int& q = fem.polynomialOrder;
+    const int numVertices = fem.mesh.numNodes;
+    const int numSkeletonNodes = numVertices + (q - 1) * fem.mesh.numEdges;
+    const int numInteriorNodes = (q - 1) * (q - 2) / 2;
+
+    // FEM2D numbers the FE nodes by vertex, then by edge and then by element
+    const std::vector<int> freeIndices = freeNodeIndices(fem);
+    std::vector<std::vector<int>> blocks = std::vector<std::vector<int>>(numVertices + fem.mesh.numEdges + fem.mesh.size);
+    for (int g = 0; g < fem.Ng; ++g)
+    {
+      if (freeIndices[g] < 0)
+        continue;
+
+      int block = g;
+      if (g >= numSkeletonNodes)
+        block = numVertices + fem.mesh.numEdges + (g - numSkeletonNodes) / numInteriorNodes;
+      else if (g >= numVertices)
+        block = numVertices + (g - numVertices) / (q - 1);
+      blocks[block].push_back(freeIndices[g]);
+    }
+
+    const Matrix& A = *level.A;
+    for (std::vector<int>& block : blocks)
+    {
+      if (block.empty())
+        continue;
+
+      const int m = (int)block.size();
+      Matrix A_BB = Matrix(m);
+      for (int i = 0; i < m; ++i)
+        for (int j = 0; j < m; ++j)
+          A_BB[i][j] = A[block[i]][block[j]];
+      const Matrix A_BBInv = inverse(A_BB);
+
+      std::vector<real> blockInverse = std::vector<real>(m * m);
+      for (int i = 0; i < m; ++i)
+        for (int j = 0; j < m; ++j)
+          blockInverse[i * m + j] = A_BBInv[i][j];
+      level.blocks.push_back(std::move(block));
+      level.blockInverses.push_back(std::move(blockInverse));
+    }
+  }
+
+  /*
+    One block Gauss-Seidel sweep on Ax = b, forward or backward.
+  */
+  static void blockGaussSeidel(const Level& level, const Vector& b, Vector& x, const bool forward)
+  {
+    const Matrix& A = *level.A;
+    const int n = A.rows();
+    const int numBlocks = (int)level.blocks.size();
+    std::vector<real> residual;
+    for (int k = 0; k < numBlocks; ++k)
+    {
+      const int B = forward ? k : numBlocks - 1 - k;
+      const std::vector<int>& block = level.blocks[B];
+      const real* blockInverse = level.blockInverses[B].data();
+      const int m = (int)block.size();
+
+      residual.assign(m, 0.0);
+      for (int i = 0; i < m; ++i)
+      {
+        const real* row = A[block[i]];
+        real sum = b[block[i]];
+        for (int j = 0; j < n; ++j)
+          sum -= row[j] * x[j];
+        residual[i] = sum;
+      }
+      for (int i = 0; i < m; ++i)
+        for (int j = 0; j < m; ++j)
+          x[block[i]] += blockInverse[i * m + j] * residual[j];
+    }
+  }
+
+  /*
+    Approximately solves the system of level l for b, starting from x = 0.
+  */
+  void vCycle(const int l, const Vector& b, Vector& x) const
+  {
+    if (l == 0)
+    {
+      x = solveLU(*coarseLU, b);
+      return;
+    }
+
+    const Level& level = levels[l];
+    const Matrix& A = *level.A;
+    const int n = A.rows();
+
+    for (int i = 0; i < n; ++i)
+      x[i] = 0.0;
+    for (int s = 0; s < numSmoothingSteps; ++s)
+      blockGaussSeidel(level, b, x, true);
+
+    // Restrict the residual to the coarser level
+    Vector r = Vector(n);
+    multiply(A, x, r);
+    Vector coarseResidual = Vector(levels[l - 1].A->rows());
+    for (int i = 0; i < n; ++i)
+    {
+      const real residual = b[i] - r[i];
+      for (int k = level.rowStarts[i]; k < level.rowStarts[i + 1]; ++k)
+        coarseResidual[level.columns[k]] += level.values[k] * residual;
+    }
+
+    // Coarse correction
+    Vector coarseCorrection = Vector(coarseResidual.size());
+    vCycle(l - 1, coarseResidual, coarseCorrection);
+    for (int i = 0; i < n; ++i)
+      for (int k = level.rowStarts[i]; k < level.rowStarts[i + 1]; ++k)
+        x[i] += level.values[k] * coarseCorrection[level.columns[k]];
+
+    for (int s = 0; s < numSmoothingSteps; ++s)
+      blockGaussSeidel(level, b, x, false);
+  }
+};
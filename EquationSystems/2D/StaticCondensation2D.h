@@ -0,0 +1,163 @@
+#pragma once
+#include "Precompilied.h"
+#include "Meshing/2D/FEM2D.h"
+#include "LinearAlgebra/Matrix.h"
+#include "LinearAlgebra/Vector.h"
+#include "Utilities/TaskScheduler.h"
+
+/*
+  How an equation system assembles its global system.
+
+  Full:      All FE nodes are unknowns of the global system.
+  Condensed: The interior FE nodes of each element are eliminated element by
+             element (see StaticCondensation2D), so that only the vertex and
+             edge nodes are unknowns of the global system.
+*/
+enum class AssemblyMode
+{
+  Full,
+  Condensed
+};
+
+/*
+  Static condensation of the interior FE nodes of a FEM2D.
+
+  For p >= 3 each element has (p - 1)(p - 2) / 2 interior nodes, which only
+  couple to the nodes of their own element.  With the local matrix of an element
+  split into its skeleton (vertex and edge) nodes s and its interior nodes i,
+  the interior unknowns are
+
+    u_i = A_ii^-1 (f_i - A_is u_s),
+
+  so they are eliminated by adding the Schur complement A_ss - A_si A_ii^-1 A_is
+  and the load f_s - A_si A_ii^-1 f_i of each element to a global system for the
+  skeleton nodes only.  Since FEM2D numbers the skeleton nodes first, the reduced
+  system keeps their global indices.  Once it is solved, the interior unknowns are
+  recovered element by element from the stored A_ii^-1 A_is and A_ii^-1 f_i.
+*/
+template<int N>
+class StaticCondensation2D
+{
+public:
+  const FEM2D<N>& fem;
+  const int numSkeletonNodes;   // Number of vertex and edge nodes, the size of the reduced system
+  const int numShapes;          // Number of shape functions per element
+  const int numSkeletonShapes;  // Number of those on vertices and edges, which come first
+
+  StaticCondensation2D() = delete;
+
+  StaticCondensation2D(const FEM2D<N>& FEfem)
+    : fem(FEfem),
+      numSkeletonNodes(FEfem.mesh.numNodes + (FEfem.polynomialOrder - 1) * FEfem.mesh.numEdges),
+      numShapes(numLocalNodes2D(FEfem.polynomialOrder)),
+      numSkeletonShapes(3 * FEfem.polynomialOrder),
+      interiorSolutions(FEfem.mesh.size)
+  {
+  }
+
+  /*
+    Adds the condensed local system of element K to the reduced
+    matrix A and load vector b, both of size numSkeletonNodes.
+
+    local is the numShapes x numShapes local matrix (row-major) and localVector
+    the local load vector of K.  They are taken in the shape functions of the
+    reference element, without the signs of FEM2D::shapeSign, which are applied
+    here.  Elements that share no FE nodes, such as those of one color, may be
+    condensed concurrently.
+  */
+  void condense(const int K, const real* local, const real* localVector, Matrix& A, Vector& b)
+  {
+    const int n = numShapes;
+    const int ns = numSkeletonShapes;
+    const int ni = numShapes - numSkeletonShapes;
+
+    // Debug
+    ASSERT(A.rows() == numSkeletonNodes && A.columns() == numSkeletonNodes, "Matrix must be the size of the reduced system");
+    ASSERT(b.size() == numSkeletonNodes, "Vector must be the size of the reduced system");
+
+    // Solve for the interior nodes, rows of [A_ii^-1 A_is | A_ii^-1 f_i]
+    std::vector<real>& solution = interiorSolutions[K];
+    solution.assign(ni * (ns + 1), 0.0);
+    if (ni > 0)
+    {
+      Matrix A_ii = Matrix(ni);
+      for (int i = 0; i < ni; ++i)
+        for (int j = 0; j < ni; ++j)
+          A_ii[i][j] = local[(ns + i) * n + ns + j];
+      const Matrix A_iiInv = inverse(A_ii);
+
+      for (int i = 0; i < ni; ++i)
+        for (int k = 0; k < ni; ++k)
+        {
+          const real& a = A_iiInv[i][k];
+          const real* row = &local[(ns + k) * n];
+          for (int s = 0; s < ns; ++s)
+            solution[i * (ns + 1) + s] += a * row[s];
+          solution[i * (ns + 1) + ns] += a * localVector[ns + k];
+        }
+    }
+
+    // Schur complement and condensed load
+    for (int r = 0; r < ns; ++r)
+    {
+      const real* row = &local[r * n];
+      const real sign = fem.shapeSign(K, r);
+      const int I = fem[K][r];
+
+      real load = localVector[r];
+      for (int i = 0; i < ni; ++i)
+        load -= row[ns + i] * solution[i * (ns + 1) + ns];
+      b[I] += sign * load; // Accumulate to b
+
+      for (int s = 0; s < ns; ++s)
+      {
+        real entry = row[s];
+        for (int i = 0; i < ni; ++i)
+          entry -= row[ns + i] * solution[i * (ns + 1) + s];
+        A[I][fem[K][s]] += sign * fem.shapeSign(K, s) * entry; // Accumulate to A
+      }
+    }
+  }
+
+  /*
+    \returns the coefficients of all FE nodes, given those of the numSkeletonNodes
+    skeleton nodes.  The interior coefficients are recovered in parallel by back
+    substitution on each element, which requires all elements to have been condensed.
+  */
+  Vector recover(const Vector& skeletonCoefficients) const
+  {
+    const int ns = numSkeletonShapes;
+    const int ni = numShapes - numSkeletonShapes;
+
+    // Debug
+    ASSERT(skeletonCoefficients.size() == numSkeletonNodes, "Vector must be the size of the reduced system");
+
+    Vector coefficients = Vector(fem.Ng);
+    for (int i = 0; i < numSkeletonNodes; ++i)
+      coefficients[i] = skeletonCoefficients[i];
+
+    // Interior nodes belong to one element each
+    parallelFor(0, fem.mesh.size, ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<real> u_s = std::vector<real>(ns);
+      for (int K = begin; K < end; ++K)
+      {
+        const std::vector<real>& solution = interiorSolutions[K];
+        for (int s = 0; s < ns; ++s)
+          u_s[s] = fem.shapeSign(K, s) * skeletonCoefficients[fem[K][s]];
+
+        for (int i = 0; i < ni; ++i)
+        {
+          real u_i = solution[i * (ns + 1) + ns];
+          for (int s = 0; s < ns; ++s)
+            u_i -= solution[i * (ns + 1) + s] * u_s[s];
+          coefficients[fem[K][ns + i]] = u_i;
+        }
+      }
+    });
+    return coefficients;
+  }
+
+private:
+  std::vector<std::vector<real>> interiorSolutions;  // [A_ii^-1 A_is | A_ii^-1 f_i] of each element, row-major
+};
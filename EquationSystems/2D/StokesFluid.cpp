@@ -1,10 +1,10 @@
 #include "Precompilied.h"
 #include "StokesFluid.h"
+#include "Utilities/TaskGraph.h"
 
 static constexpr int u1 = 0;
 static constexpr int u2 = 1;
 static constexpr int p = 0;
-static real identityFunction(real x, real y) { return 1.0; };
 
 StokesFluid::StokesFluid(FEM2D<2>& uFEM, FEM2D<1>& pFEM,
                          real2DFunction f1Func, real2DFunction f2Func,
@@ -25,110 +25,161 @@ int StokesFluid::neq() const
 
 Vector StokesFluid::solveSystem(const int n_gq) const
 {
-  std::function<real(real, real)> rhoInverse = [=](real x, real y) { return 1.0 / rho(x, y); };
+  const auto rhoInverse = makeCoefficient2D([=](real x, real y) { return 1.0 / rho(x, y); });
+
+  Matrix* Muu_xx = nullptr;
+  Matrix* Muu_yy = nullptr;
+  Matrix* Mpu_0x = nullptr;
+  Matrix* Mpu_0y = nullptr;
+  Vector* f_l = nullptr;
+  Vector* f1u_h = nullptr;
+  Vector* f2u_h = nullptr;
+  Vector* bc_u1_eM_xx = nullptr;
+  Vector* bc_u1_eM_yy = nullptr;
+  Vector* bc_u1_eM_0x = nullptr;
+  Vector* bc_u2_eM_xx = nullptr;
+  Vector* bc_u2_eM_yy = nullptr;
+  Vector* bc_u2_eM_0y = nullptr;
+
+  const int Nu_u = uFem.Ng - (int)uFem.boundaryIndices.size();  // Number of unknowns on each component of u
+  const int Nu_p = pFem.Ng - (int)pFem.boundaryIndices.size();  // Number of unknowns on p
+
+  // Full coefficient matrix and boundary vector
+  std::vector<std::vector<real>> M = std::vector<std::vector<real>>();
+  Vector b = Vector(2 * Nu_u + Nu_p + 1);
+  Vector* solution = nullptr;
+
+  // The operators are independent of each other until they are combined
+  // into the full system, so they are assembled concurrently
+  TaskGraph graph("StokesFluid::solveSystem");
 
   // Create mass matrices and load vector
-  Matrix* Muu_xx = FE_MassMatrix2D(uFem, nu, n_gq, 1, 0);
-  Matrix* Muu_yy = FE_MassMatrix2D(uFem, nu, n_gq, 0, 1);
-  Matrix* Mpu_0x = FE_MassMatrix2D(pFem, uFem, rhoInverse, n_gq, 0, 0, 1, 0);
-  Matrix* Mpu_0y = FE_MassMatrix2D(pFem, uFem, rhoInverse, n_gq, 0, 0, 0, 1);
-  Vector* f_l = FE_LoadVector2D(pFem, identityFunction, n_gq, 0, 0);
-  Vector* f1u_h = FE_LoadVector2D(uFem, f1, n_gq, 0, 0);
-  Vector* f2u_h = FE_LoadVector2D(uFem, f2, n_gq, 0, 0);
+  const int assembleMuu_xx = graph.add("Muu_xx", [&]() { Muu_xx = FE_MassMatrix2D(uFem, nu, n_gq, 1, 0); });
+  const int assembleMuu_yy = graph.add("Muu_yy", [&]() { Muu_yy = FE_MassMatrix2D(uFem, nu, n_gq, 0, 1); });
+  const int assembleMpu_0x = graph.add("Mpu_0x", [&]() { Mpu_0x = FE_MassMatrix2D(pFem, uFem, rhoInverse, n_gq, 0, 0, 1, 0); });
+  const int assembleMpu_0y = graph.add("Mpu_0y", [&]() { Mpu_0y = FE_MassMatrix2D(pFem, uFem, rhoInverse, n_gq, 0, 0, 0, 1); });
+  const int assemblef_l = graph.add("f_l", [&]() { f_l = FE_LoadVector2D(pFem, ConstantCoefficient2D(1.0), n_gq, 0, 0); });
+  const int assemblef1u_h = graph.add("f1u_h", [&]() { f1u_h = FE_LoadVector2D(uFem, f1, n_gq, 0, 0); });
+  const int assemblef2u_h = graph.add("f2u_h", [&]() { f2u_h = FE_LoadVector2D(uFem, f2, n_gq, 0, 0); });
 
   // Create boundary vectors
-  Vector* bc_u1_eM_xx = constructEssentialBoundaryVector2D(uFem, u1, Muu_xx);
-  Vector* bc_u1_eM_yy = constructEssentialBoundaryVector2D(uFem, u1, Muu_yy);
-  Vector* bc_u1_eM_0x = constructEssentialBoundaryVector2D(pFem, uFem, u1, Mpu_0x);
-  Vector* bc_u2_eM_xx = constructEssentialBoundaryVector2D(uFem, u2, Muu_xx);
-  Vector* bc_u2_eM_yy = constructEssentialBoundaryVector2D(uFem, u2, Muu_yy);
-  Vector* bc_u2_eM_0y = constructEssentialBoundaryVector2D(pFem, uFem, u2, Mpu_0y);
+  const int assemblebc_u1_eM_xx = graph.add("bc_u1_eM_xx", [&]() { bc_u1_eM_xx = constructEssentialBoundaryVector2D(uFem, u1, Muu_xx); }, { assembleMuu_xx });
+  const int assemblebc_u1_eM_yy = graph.add("bc_u1_eM_yy", [&]() { bc_u1_eM_yy = constructEssentialBoundaryVector2D(uFem, u1, Muu_yy); }, { assembleMuu_yy });
+  const int assemblebc_u1_eM_0x = graph.add("bc_u1_eM_0x", [&]() { bc_u1_eM_0x = constructEssentialBoundaryVector2D(pFem, uFem, u1, Mpu_0x); }, { assembleMpu_0x });
+  const int assemblebc_u2_eM_xx = graph.add("bc_u2_eM_xx", [&]() { bc_u2_eM_xx = constructEssentialBoundaryVector2D(uFem, u2, Muu_xx); }, { assembleMuu_xx });
+  const int assemblebc_u2_eM_yy = graph.add("bc_u2_eM_yy", [&]() { bc_u2_eM_yy = constructEssentialBoundaryVector2D(uFem, u2, Muu_yy); }, { assembleMuu_yy });
+  const int assemblebc_u2_eM_0y = graph.add("bc_u2_eM_0y", [&]() { bc_u2_eM_0y = constructEssentialBoundaryVector2D(pFem, uFem, u2, Mpu_0y); }, { assembleMpu_0y });
+
+  const int allocateM = graph.add("allocate M", [&]()
+  {
+    // Matrix M = Matrix(2 * Nu_u + Nu_p + 1);
+    M.resize(2 * Nu_u + Nu_p + 1);
+    for (int i = 0; i < M.size(); ++i)
+      M[i].resize(2 * Nu_u + Nu_p + 1, 0.0);
+  });
 
   // Remove boundary indices (since we already know the values at those nodes)
-  removeBoundaryIndices(Muu_xx, uFem.boundaryIndices);
-  removeBoundaryIndices(Muu_yy, uFem.boundaryIndices);
-  removeBoundaryIndices(Mpu_0x, pFem.boundaryIndices, uFem.boundaryIndices);
-  removeBoundaryIndices(Mpu_0y, pFem.boundaryIndices, uFem.boundaryIndices);
-  removeBoundaryIndices(f_l, pFem.boundaryIndices);
-  removeBoundaryIndices(f1u_h, uFem.boundaryIndices);
-  removeBoundaryIndices(f2u_h, uFem.boundaryIndices);
-  removeBoundaryIndices(bc_u1_eM_xx, uFem.boundaryIndices);
-  removeBoundaryIndices(bc_u1_eM_yy, uFem.boundaryIndices);
-  removeBoundaryIndices(bc_u1_eM_0x, pFem.boundaryIndices);
-  removeBoundaryIndices(bc_u2_eM_xx, uFem.boundaryIndices);
-  removeBoundaryIndices(bc_u2_eM_yy, uFem.boundaryIndices);
-  removeBoundaryIndices(bc_u2_eM_0y, pFem.boundaryIndices);
-
-  // Construct full coefficient matrix and boundary vector
-  const int Nu_u = uFem.Ng - (int)uFem.boundaryIndices.size();  // Number of unknowns on each component of u
-  const int Nu_p = pFem.Ng - (int)pFem.boundaryIndices.size();  // Number of unknowns on p
+  // and copy operators into their blocks of the full system
+  const int fillMuu = graph.add("Muu blocks", [&]()
+  {
+    removeBoundaryIndices(Muu_xx, uFem.boundaryIndices);
+    removeBoundaryIndices(Muu_yy, uFem.boundaryIndices);
+
+    // Debug
+    ASSERT(Muu_xx->size() == Nu_u, "Matrix is not the correct size");
+    ASSERT(Muu_yy->size() == Nu_u, "Matrix is not the correct size");
+
+    for (int i = 0; i < Nu_u; ++i)
+      for (int j = 0; j < Nu_u; ++j)
+      {
+        M[i][j] = (*Muu_xx)[i][j] + (*Muu_yy)[i][j];
+        M[Nu_u + i][Nu_u + j] = (*Muu_xx)[i][j] + (*Muu_yy)[i][j];
+      }
+    delete Muu_xx;
+    delete Muu_yy;
+  }, { allocateM, assemblebc_u1_eM_xx, assemblebc_u1_eM_yy, assemblebc_u2_eM_xx, assemblebc_u2_eM_yy });
+
+  const int fillMpu = graph.add("Mpu blocks", [&]()
+  {
+    removeBoundaryIndices(Mpu_0x, pFem.boundaryIndices, uFem.boundaryIndices);
+    removeBoundaryIndices(Mpu_0y, pFem.boundaryIndices, uFem.boundaryIndices);
+
+    // Debug
+    ASSERT(Mpu_0x->rows() == Nu_p && Mpu_0x->columns() == Nu_u, "Matrix is not the correct size");
+    ASSERT(Mpu_0y->rows() == Nu_p && Mpu_0x->columns() == Nu_u, "Matrix is not the correct size");
+
+    for (int i = 0; i < Nu_p; ++i)
+      for (int j = 0; j < Nu_u; ++j)
+      {
+        M[2 * Nu_u + i][j] = -1.0 * (*Mpu_0x)[i][j];
+        M[2 * Nu_u + i][Nu_u + j] = -1.0 * (*Mpu_0y)[i][j];
+        M[j][2 * Nu_u + i] = -1.0 * (*Mpu_0x)[i][j];
+        M[Nu_u + j][2 * Nu_u + i] = -1.0 * (*Mpu_0y)[i][j];
+      }
+    delete Mpu_0x;
+    delete Mpu_0y;
+  }, { allocateM, assemblebc_u1_eM_0x, assemblebc_u2_eM_0y });
+
+  const int fillf_l = graph.add("f_l blocks", [&]()
+  {
+    removeBoundaryIndices(f_l, pFem.boundaryIndices);
 
-  // Debug
-  ASSERT(Muu_xx->size() == Nu_u, "Matrix is not the correct size");
-  ASSERT(Muu_yy->size() == Nu_u, "Matrix is not the correct size");
-  ASSERT(Mpu_0x->rows() == Nu_p && Mpu_0x->columns() == Nu_u, "Matrix is not the correct size");
-  ASSERT(Mpu_0y->rows() == Nu_p && Mpu_0x->columns() == Nu_u, "Matrix is not the correct size");
-  ASSERT(f_l->size() == Nu_p, "Vector is not the correct size");
-  ASSERT(f1u_h->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(f2u_h->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(bc_u1_eM_xx->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(bc_u1_eM_yy->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(bc_u1_eM_0x->size() == Nu_p, "Vector is not the correct size");
-  ASSERT(bc_u2_eM_xx->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(bc_u2_eM_yy->size() == Nu_u, "Vector is not the correct size");
-  ASSERT(bc_u2_eM_0y->size() == Nu_p, "Vector is not the correct size");
-
-  // Matrix M = Matrix(2 * Nu_u + Nu_p + 1);
-  std::vector<std::vector<real>> M = std::vector<std::vector<real>>();
-  M.resize(2 * Nu_u + Nu_p + 1);
-  for (int i = 0; i < M.size(); ++i)
-    M[i].resize(2 * Nu_u + Nu_p + 1, 0.0);
+    // Debug
+    ASSERT(f_l->size() == Nu_p, "Vector is not the correct size");
 
-  for (int i = 0; i < Nu_u; ++i)
-    for (int j = 0; j < Nu_u; ++j)
+    for (int i = 0; i < Nu_p; ++i)
     {
-      M[i][j] = (*Muu_xx)[i][j] + (*Muu_yy)[i][j];
-      M[Nu_u + i][Nu_u + j] = (*Muu_xx)[i][j] + (*Muu_yy)[i][j];
+      M[2 * Nu_u + Nu_p][2 * Nu_u + i] = (*f_l)[i];
+      M[2 * Nu_u + i][2 * Nu_u + Nu_p] = (*f_l)[i];
     }
-  delete Muu_xx;
-  delete Muu_yy;
+    delete f_l;
+  }, { allocateM, assemblef_l });
 
-  for (int i = 0; i < Nu_p; ++i)
-    for (int j = 0; j < Nu_u; ++j)
+  const int fillb = graph.add("b", [&]()
+  {
+    removeBoundaryIndices(f1u_h, uFem.boundaryIndices);
+    removeBoundaryIndices(f2u_h, uFem.boundaryIndices);
+    removeBoundaryIndices(bc_u1_eM_xx, uFem.boundaryIndices);
+    removeBoundaryIndices(bc_u1_eM_yy, uFem.boundaryIndices);
+    removeBoundaryIndices(bc_u1_eM_0x, pFem.boundaryIndices);
+    removeBoundaryIndices(bc_u2_eM_xx, uFem.boundaryIndices);
+    removeBoundaryIndices(bc_u2_eM_yy, uFem.boundaryIndices);
+    removeBoundaryIndices(bc_u2_eM_0y, pFem.boundaryIndices);
+
+    // Debug
+    ASSERT(f1u_h->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(f2u_h->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(bc_u1_eM_xx->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(bc_u1_eM_yy->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(bc_u1_eM_0x->size() == Nu_p, "Vector is not the correct size");
+    ASSERT(bc_u2_eM_xx->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(bc_u2_eM_yy->size() == Nu_u, "Vector is not the correct size");
+    ASSERT(bc_u2_eM_0y->size() == Nu_p, "Vector is not the correct size");
+
+    for (int i = 0; i < Nu_u; ++i)
     {
-      M[2 * Nu_u + i][j] = -1.0 * (*Mpu_0x)[i][j];
-      M[2 * Nu_u + i][Nu_u + j] = -1.0 * (*Mpu_0y)[i][j];
-      M[j][2 * Nu_u + i] = -1.0 * (*Mpu_0x)[i][j];
-      M[Nu_u + j][2 * Nu_u + i] = -1.0 * (*Mpu_0y)[i][j];
+      b[i] = (*f1u_h)[i] + (*bc_u1_eM_xx)[i] + (*bc_u1_eM_yy)[i];
+      b[Nu_u + i] = (*f2u_h)[i] + (*bc_u2_eM_xx)[i] + (*bc_u2_eM_yy)[i];
     }
-  delete Mpu_0x;
-  delete Mpu_0y;
-
-  for (int i = 0; i < Nu_p; ++i)
-  {
-    M[2 * Nu_u + Nu_p][2 * Nu_u + i] = (*f_l)[i];
-    M[2 * Nu_u + i][2 * Nu_u + Nu_p] = (*f_l)[i];
-  }
-  delete f_l;
-
-  Vector b = Vector(2 * Nu_u + Nu_p + 1);
-  for (int i = 0; i < Nu_u; ++i)
-  {
-    b[i] = (*f1u_h)[i] + (*bc_u1_eM_xx)[i] + (*bc_u1_eM_yy)[i];
-    b[Nu_u + i] = (*f2u_h)[i] + (*bc_u2_eM_xx)[i] + (*bc_u2_eM_yy)[i];
-  }
-  delete bc_u1_eM_xx;
-  delete bc_u1_eM_yy;
-  delete bc_u2_eM_xx;
-  delete bc_u2_eM_yy;
-
-  for (int i = 0; i < Nu_p; ++i)
-    b[2 * Nu_u + i] = -1.0 * ((*bc_u1_eM_0x)[i] + (*bc_u2_eM_0y)[i]);
-  delete bc_u1_eM_0x;
-  delete bc_u2_eM_0y;
+    for (int i = 0; i < Nu_p; ++i)
+      b[2 * Nu_u + i] = -1.0 * ((*bc_u1_eM_0x)[i] + (*bc_u2_eM_0y)[i]);
+
+    delete f1u_h;
+    delete f2u_h;
+    delete bc_u1_eM_xx;
+    delete bc_u1_eM_yy;
+    delete bc_u1_eM_0x;
+    delete bc_u2_eM_xx;
+    delete bc_u2_eM_yy;
+    delete bc_u2_eM_0y;
+  }, { assemblef1u_h, assemblef2u_h, assemblebc_u1_eM_xx, assemblebc_u1_eM_yy, assemblebc_u1_eM_0x, assemblebc_u2_eM_xx, assemblebc_u2_eM_yy, assemblebc_u2_eM_0y });
 
   // Solve linear system for coefficients on unknown nodes
-  Vector coefficients = solve(M, b);
+  graph.add("solve", [&]() { solution = new Vector(solve(M, b)); }, { fillMuu, fillMpu, fillf_l, fillb });
+
+  graph.run();
+  Vector coefficients = std::move(*solution);
+  delete solution;
 
   // Add back in boundary indices to coefficient vector
   for (int n = 0; n < uFem.boundaryIndices.size(); ++n)
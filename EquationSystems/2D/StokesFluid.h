@@ -21,7 +21,7 @@ public:
   /*
     \returns coefficients of FE approximation u_h.
 
-    \param n_gq: Number of Gaussian quadrature nodes.
+    \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
 
     Essential boundary conditions should be enforeced
     before each call of this function.
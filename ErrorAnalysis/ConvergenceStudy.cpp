@@ -0,0 +1,218 @@
+#include "Precompilied.h"
+#include "ConvergenceStudy.h"
+#include "Utilities/TaskScheduler.h"
+
+/*
+  Writes a number as JSON, which has no representation for NaN or infinity.
+*/
+static void writeJsonNumber(std::ostream& stream, const real value)
+{
+  if (std::isfinite(value))
+    stream << value;
+  else
+    stream << "null";
+}
+
+/*
+  Writes a string as JSON, escaping quotes, backslashes and control characters.
+*/
+static void writeJsonString(std::ostream& stream, const std::string& value)
+{
+  static constexpr char hexDigits[] = "0123456789abcdef";
+
+  stream << "\"";
+  for (const char character : value)
+    switch (character)
+    {
+    case '"':
+      stream << "\\\"";
+      break;
+    case '\\':
+      stream << "\\\\";
+      break;
+    case '\n':
+      stream << "\\n";
+      break;
+    case '\t':
+      stream << "\\t";
+      break;
+    default:
+      if ((unsigned char)character < 0x20)
+        stream << "\\u00" << hexDigits[character >> 4] << hexDigits[character & 0xf];
+      else
+        stream << character;
+    }
+  stream << "\"";
+}
+
+ConvergenceStudy::ConvergenceStudy(const std::string& studyName, const std::vector<std::string>& normNames, Problem problem)
+  : name(studyName),
+    norms(normNames),
+    solve(problem)
+{
+}
+
+void ConvergenceStudy::run(const std::vector<int>& refinements, const std::vector<int>& polynomialOrders)
+{
+  orders = polynomialOrders;
+  std::sort(orders.begin(), orders.end());
+  orders.erase(std::unique(orders.begin(), orders.end()), orders.end());
+
+  std::vector<int> sortedRefinements = refinements;
+  std::sort(sortedRefinements.begin(), sortedRefinements.end());
+
+  // Levels are created in the order of levels()
+  results.clear();
+  for (const int p : orders)
+    for (const int n : sortedRefinements)
+    {
+      Level level = Level();
+      level.refinement = n;
+      level.polynomialOrder = p;
+      results.push_back(level);
+    }
+
+  // Start the most expensive levels first, so that the small ones fill in the gaps at the end
+  std::vector<int> schedule = std::vector<int>(results.size());
+  for (int i = 0; i < (int)schedule.size(); ++i)
+    schedule[i] = i;
+  std::stable_sort(schedule.begin(), schedule.end(), [this](const int i, const int j)
+  {
+    return (real)results[i].refinement * results[i].polynomialOrder > (real)results[j].refinement * results[j].polynomialOrder;
+  });
+
+  TaskGroup group;
+  for (const int i : schedule)
+    group.run([this, i]()
+    {
+      Level& level = results[i];
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      level.result = solve(level.refinement, level.polynomialOrder);
+      level.seconds = std::chrono::duration<real>(std::chrono::steady_clock::now() - start).count();
+
+      ASSERT(level.result.errors.size() == norms.size(), "Problem must return one error per norm");
+    });
+  group.wait();
+}
+
+const std::vector<ConvergenceStudy::Level>& ConvergenceStudy::levels() const
+{
+  return results;
+}
+
+real ConvergenceStudy::rate(const int normIndex, const int polynomialOrder) const
+{
+  ASSERT(normIndex >= 0 && normIndex < (int)norms.size(), "Norm index out of range");
+
+  // Least squares fit of log(error) = rate * log(h) + constant
+  int numPoints = 0;
+  real sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+  for (const Level& level : results)
+  {
+    const real& error = level.result.errors[normIndex];
+    if (level.polynomialOrder != polynomialOrder || !(error > 0.0) || !(level.result.h > 0.0))
+      continue;
+
+    const real x = log(level.result.h);
+    const real y = log(error);
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    ++numPoints;
+  }
+
+  const real denominator = numPoints * sumXX - sumX * sumX;
+  if (numPoints < 2 || denominator == 0.0)
+    return std::nan("");
+  return (numPoints * sumXY - sumX * sumY) / denominator;
+}
+
+void ConvergenceStudy::writeReport(std::ostream& stream) const
+{
+  const std::streamsize precision = stream.precision(17);
+
+  stream << "{\n";
+  stream << "  \"study\": ";
+  writeJsonString(stream, name);
+  stream << ",\n";
+  stream << "  \"threads\": " << numThreads() << ",\n";
+  stream << "  \"norms\": [";
+  for (int i = 0; i < (int)norms.size(); ++i)
+  {
+    stream << (i > 0 ? ", " : "");
+    writeJsonString(stream, norms[i]);
+  }
+  stream << "],\n";
+
+  stream << "  \"levels\": [\n";
+  for (int l = 0; l < (int)results.size(); ++l)
+  {
+    const Level& level = results[l];
+    stream << "    { \"refinement\": " << level.refinement
+           << ", \"order\": " << level.polynomialOrder
+           << ", \"h\": ";
+    writeJsonNumber(stream, level.result.h);
+    stream << ", \"errors\": [";
+    for (int i = 0; i < (int)level.result.errors.size(); ++i)
+    {
+      stream << (i > 0 ? ", " : "");
+      writeJsonNumber(stream, level.result.errors[i]);
+    }
+    stream << "], \"seconds\": " << level.seconds
+           << ", \"memoryBytes\": " << level.result.memoryBytes << " }"
+           << (l + 1 < (int)results.size() ? "," : "") << "\n";
+  }
+  stream << "  ],\n";
+
+  stream << "  \"rates\": [\n";
+  for (int o = 0; o < (int)orders.size(); ++o)
+  {
+    stream << "    { \"order\": " << orders[o] << ", \"rates\": [";
+    for (int i = 0; i < (int)norms.size(); ++i)
+    {
+      stream << (i > 0 ? ", " : "");
+      writeJsonNumber(stream, rate(i, orders[o]));
+    }
+    stream << "] }" << (o + 1 < (int)orders.size() ? "," : "") << "\n";
+  }
+  stream << "  ]\n";
+  stream << "}\n";
+
+  stream.precision(precision);
+}
+
+void ConvergenceStudy::writeReport(const std::string& fileName) const
+{
+  std::ofstream file(fileName);
+  if (!file)
+    LOG("Could not open \"" + fileName + "\" for writing", LogLevel::Error);
+  writeReport(file);
+  file.close();
+}
+
+void ConvergenceStudy::printSummary(std::ostream& stream) const
+{
+  for (const int p : orders)
+  {
+    stream << name << ", p = " << p << std::endl;
+    stream << "  h";
+    for (const std::string& norm : norms)
+      stream << ", " << norm;
+    stream << std::endl;
+
+    for (const Level& level : results)
+      if (level.polynomialOrder == p)
+      {
+        stream << "  " << level.result.h;
+        for (const real error : level.result.errors)
+          stream << ", " << error;
+        stream << std::endl;
+      }
+
+    stream << "  rate";
+    for (int i = 0; i < (int)norms.size(); ++i)
+      stream << ", " << rate(i, p);
+    stream << std::endl;
+  }
+}
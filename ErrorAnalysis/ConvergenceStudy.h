@@ -0,0 +1,88 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Runs a problem on a series of refinement levels and polynomial orders
+  and estimates the observed rate of convergence of each error norm.
+
+  The problem is any function that sets up and solves a 1D or 2D problem
+  for a given refinement (typically the number of elements per direction)
+  and polynomial order, and returns the mesh size h together with the
+  errors in each of the norms of the study.  Since levels are independent,
+  they are run concurrently on the TaskScheduler, the most expensive ones
+  first, so the study takes about as long as its largest level.  The problem
+  function must therefore be safe to call concurrently.
+
+  Rates are the least squares slopes of log(error) against log(h) over all
+  levels of the same polynomial order.
+*/
+class ConvergenceStudy
+{
+public:
+  /*
+    What the problem function reports for one level.
+  */
+  struct LevelResult
+  {
+    real h = 0.0;                // Mesh size
+    std::vector<real> errors{};  // One per norm of the study, in the same order
+    size_t memoryBytes = 0;      // Memory used by the level, as estimated by the problem (optional)
+  };
+
+  /*
+    A level of the study, after it has been run.
+  */
+  struct Level
+  {
+    int refinement = 0;
+    int polynomialOrder = 0;
+    LevelResult result{};
+    real seconds = 0.0;          // Wall time taken by the problem function
+  };
+
+  using Problem = std::function<LevelResult(int, int)>;
+
+  ConvergenceStudy() = delete;
+
+  /*
+    \param normNames: Names of the error norms returned by the problem, e.g. { "L2", "H1" }.
+    \param problem: Function of (refinement, polynomialOrder) that solves the problem on one level.
+  */
+  ConvergenceStudy(const std::string& studyName, const std::vector<std::string>& normNames, Problem problem);
+
+  /*
+    Runs the problem for every combination of the given refinements and polynomial orders.
+    Results of previous runs are discarded.
+  */
+  void run(const std::vector<int>& refinements, const std::vector<int>& polynomialOrders);
+
+  /*
+    \returns all levels of the last run, ordered by polynomial order and then by refinement.
+  */
+  const std::vector<Level>& levels() const;
+
+  /*
+    \returns the observed rate of convergence of a norm for a polynomial order,
+    or NaN if there are fewer than two levels of that order.
+  */
+  real rate(const int normIndex, const int polynomialOrder) const;
+
+  /*
+    Writes the levels and rates of the last run as JSON.
+  */
+  void writeReport(std::ostream& stream) const;
+  void writeReport(const std::string& fileName) const;
+
+  /*
+    Prints a table of errors and rates for each polynomial order.
+    Timings are left out, so that the summary is reproducible.
+  */
+  void printSummary(std::ostream& stream = std::cout) const;
+
+private:
+  std::string name;
+  std::vector<std::string> norms;
+  Problem solve;
+  std::vector<Level> results{};
+  std::vector<int> orders{};
+};
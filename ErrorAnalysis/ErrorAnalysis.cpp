@@ -14,21 +14,16 @@ real FE_AbsoluteError1D(const real x, const int elementIndex, const FEM1D& fem,
 
 void plotAbsoluteError1D(const FEM1D& fem, real1DFunction f, const int n, const int derivativeOrder)
 {
-  const int& LEFT = 0, RIGHT = fem.polynomialOrder;
+  plotAbsoluteError1D("Out.txt", fem, f, n, derivativeOrder);
+  waitAndRemove("Out.txt");
+}
 
-  std::ofstream file("Out.txt");
-  for (int K = 0; K < fem.meshSize; ++K)
-    for (int i = 0; i < n; ++i)
-    {
-      const real& xL = fem(K, LEFT).x;
-      const real& xR = fem(K, RIGHT).x;
-      const real x = xL + i * (xR - xL) / n;
-
-      file << x << ", " << FE_AbsoluteError1D(x, K, fem, f, derivativeOrder) << std::endl;
-    }
-  file.close();
-  std::cin.get();
-  remove("Out.txt");
+void plotAbsoluteError1D(const std::string& fileName, const FEM1D& fem, real1DFunction f, const int n, const int derivativeOrder)
+{
+  fem.writeElementSamples(fileName, n, derivativeOrder, [f](TextChunk& chunk, const real x, const real u)
+  {
+    chunk.writeLine({ x, abs(f(x) - u) });
+  });
 }
 
 real FE_Error1DLocal(const int elementIndex, const FEM1D& fem, real1DFunction f, const int n_gq, const int derivativeOrder)
@@ -3,6 +3,7 @@
 #include "Meshing/1D/FEM1D.h"
 #include "Meshing/2D/FEM2D.h"
 #include "Functions/Gauss-LegendreNodes.h"
+#include "ErrorNorms2D.h"
 
 /*
   \returns absolute error between FE interpolation and analytical function f.
@@ -18,7 +19,8 @@ real FE_AbsoluteError1D(const real x, const int elementIndex, const FEM1D& fem,
 
 /*
   Outputs a file called "Out.txt" that when graphed gives the
-  absolute error between FE interpolation and analytical function f.
+  absolute error between FE interpolation and analytical function f,
+  and waits for the user to press a key before removing it.
 
   \param f: Analytical function to compare to.
 
@@ -29,6 +31,12 @@ real FE_AbsoluteError1D(const real x, const int elementIndex, const FEM1D& fem,
 */
 void plotAbsoluteError1D(const FEM1D& fem, real1DFunction f, const int n, const int derivativeOrder);
 
+/*
+  Same as above, but writes to the given file and returns immediately.
+  The file is left on disk.  f is called concurrently.
+*/
+void plotAbsoluteError1D(const std::string& fileName, const FEM1D& fem, real1DFunction f, const int n, const int derivativeOrder);
+
 /*
   \returns the L2 norm of the absolute error over a given element.  Integration done
   using Gaussian quadrature.
@@ -82,7 +90,8 @@ real FE_AbsoluteError2D(const int varIndex,
 
 /*
   Outputs a file called "Plot.txt" that when graphed gives the
-  absolute error between FE interpolation and analytical function f.
+  absolute error between FE interpolation and analytical function f,
+  and waits for the user to press a key before removing it.
 
   \param f: Analytical function to compare to.
 
@@ -91,41 +100,27 @@ real FE_AbsoluteError2D(const int varIndex,
   Note: This function does NOT cacluate the derivatives of f.  Must pass in the derivative manually.
 */
 template<int N>
-void plotAbsoluteError2D(const FEM2D<N>& fem, real2DFunction f, const int n, const int xDerivativeOrder, const int yDerivativeOrder)
+void plotAbsoluteError2D(const int varIndex, const FEM2D<N>& fem, real2DFunction f, const int n, const int xDerivativeOrder, const int yDerivativeOrder)
 {
-  std::ofstream file("Plot.txt");
+  plotAbsoluteError2D("Plot.txt", varIndex, fem, f, n, xDerivativeOrder, yDerivativeOrder);
+  waitAndRemove("Plot.txt");
+}
 
-  for (int K = 0; K < fem.mesh.size; ++K)
+/*
+  Same as above, but writes to the given file and returns immediately.
+  The file is left on disk.  f is called concurrently.
+*/
+template<int N>
+void plotAbsoluteError2D(const std::string& fileName, const int varIndex, const FEM2D<N>& fem, real2DFunction f, const int n, const int xDerivativeOrder, const int yDerivativeOrder)
+{
+  // Debug
+  ASSERT(varIndex >= 0, "Variable index must be non-negative");
+  ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+
+  fem.writeElementSamples(fileName, n, xDerivativeOrder, yDerivativeOrder, [f, varIndex](TextChunk& chunk, const real x, const real y, const real* values)
   {
-    const MeshNode2D& A1 = fem.mesh(K, 0);
-    const MeshNode2D& A2 = fem.mesh(K, 1);
-    const MeshNode2D& A3 = fem.mesh(K, 2);
-
-    // Create transformation matrix
-    Matrix B = Matrix(2);
-    B[0][0] = A2.x - A1.x;
-    B[0][1] = A3.x - A1.x;
-    B[1][0] = A2.y - A1.y;
-    B[1][1] = A3.y - A1.y;
-
-    for (int i = 0; i <= n; ++i)
-      for (int j = 0; j <= n - i; ++j)
-      {
-        // Create reference points
-        const real tx = (real)i / n;
-        const real ty = (real)j / n;
-
-        // Transform points from reference domain to element K
-        const real x = B[0][0] * tx + B[0][1] * ty + A1.x;
-        const real y = B[1][0] * tx + B[1][1] * ty + A1.y;
-
-        file << x << ", " << y << ", " << FE_AbsoluteError2D(x, y, K, fem, f, xDerivativeOrder, yDerivativeOrder) << std::endl;
-      }
-  }
-  file.close();
-  std::cout << "Data written to \"Plot.txt\".  Press any key to continue" << std::endl;
-  std::cin.get();
-  remove("Plot.txt");
+    chunk.writeLine({ x, y, abs(f(x, y) - values[varIndex]) });
+  });
 }
 
 /*
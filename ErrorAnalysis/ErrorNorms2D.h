@@ -0,0 +1,208 @@
+#pragma once
+#include "Precompilied.h"
+#include "Meshing/2D/FEM2D.h"
+#include "Functions/Gauss-LegendreNodes.h"
+#include "Functions/Coefficients.h"
+#include "Functions/ElementCoefficient2D.h"
+#include "Functions/ElementKernels2D.h"
+#include "Utilities/TaskScheduler.h"
+
+/*
+  Norms of the error e = u - u_h between an analytical solution u and
+  one variable of a FEM2D, over the whole domain and per element.
+
+  Norms that were not requested are left at zero and their per-element arrays empty.
+*/
+struct ErrorNorms2D
+{
+  real L2 = 0.0;          // ||e||_L2
+  real H1Seminorm = 0.0;  // ||grad(e)||_L2
+  real H1 = 0.0;          // sqrt(||e||_L2^2 + ||grad(e)||_L2^2)
+  real energy = 0.0;      // sqrt(integral of a * |grad(e)|^2 + c * e^2)
+
+  // The same norms restricted to each element, for use as error indicators
+  std::vector<real> elementL2{};
+  std::vector<real> elementH1Seminorm{};
+  std::vector<real> elementEnergy{};
+};
+
+/*
+  Computes the requested error norms in a single parallel pass over the
+  elements.  Shape functions are tabulated once at the quadrature nodes of
+  the reference triangle, and each of the analytical functions is evaluated
+  once per quadrature node, so all norms together cost about as much as one.
+
+  Element contributions are summed in a fixed pairwise tree (see parallelReduce),
+  which is both accurate and independent of the number of threads.
+
+  The analytical functions and coefficients may be any callables of (x, y)
+  or batch coefficients (see Functions/Coefficients.h).
+
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
+  \param computeGradient: If true, dudx and dudy are used to compute the
+  H1 seminorm and H1 norm, otherwise they are not evaluated.
+  \param computeEnergy: If true, a and c are used to compute the energy norm,
+  otherwise they are not evaluated.  Requires computeGradient.
+*/
+template<int N, typename U, typename Ux, typename Uy, typename A, typename C>
+ErrorNorms2D FE_ErrorNorms2D(const int varIndex, const FEM2D<N>& fem, const int n_gq,
+                             const U& u, const Ux& dudx, const Uy& dudy, const A& a, const C& c,
+                             const bool computeGradient, const bool computeEnergy)
+{
+  // Automatic quadrature integrates the squared error as if u were a polynomial of one degree more than the shape functions
+  const int numNodes = gauss2DNumNodes(n_gq, 2 * (fem.polynomialOrder + 1));
+  const std::vector<std::array<real, 2>>& refNodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& refWeights = gauss2DWeightsRef(numNodes);
+
+  // Debug
+  ASSERT(varIndex >= 0, "Variable index must be non-negative");
+  ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+  ASSERT(computeGradient || !computeEnergy, "Energy norm requires the gradient");
+
+  ErrorNorms2D norms = ErrorNorms2D();
+  norms.elementL2.resize(fem.mesh.size);
+  if (computeGradient)
+    norms.elementH1Seminorm.resize(fem.mesh.size);
+  if (computeEnergy)
+    norms.elementEnergy.resize(fem.mesh.size);
+
+  // Squared norms summed over a range of elements
+  struct Sums
+  {
+    real L2;
+    real H1Seminorm;
+    real energy;
+  };
+
+  const Sums sums = dispatchPolynomialOrder(fem.polynomialOrder, [&](auto order)
+  {
+    constexpr int P = decltype(order)::value;
+    const RefBasisTable2D<P> basis = RefBasisTable2D<P>(fem.polynomialOrder, refNodes, fem.basisType);
+
+    return parallelReduce(0, fem.mesh.size, ElementGrainSize, Sums{ 0.0, 0.0, 0.0 }, [&](const int begin, const int end)
+    {
+      std::vector<typename RefBasisTable2D<P>::Row> phi = basis.makeTable();
+      std::vector<typename RefBasisTable2D<P>::Row> phi_x = basis.makeTable();
+      std::vector<typename RefBasisTable2D<P>::Row> phi_y = basis.makeTable();
+      std::vector<std::array<real, 2>> GLnodes = std::vector<std::array<real, 2>>(numNodes);
+      std::vector<real> uValues = std::vector<real>(numNodes);
+      std::vector<real> uxValues = std::vector<real>(numNodes);
+      std::vector<real> uyValues = std::vector<real>(numNodes);
+      std::vector<real> aValues = std::vector<real>(numNodes);
+      std::vector<real> cValues = std::vector<real>(numNodes);
+      LocalArray<real, RefBasisTable2D<P>::n> coefficients = LocalArray<real, RefBasisTable2D<P>::n>(basis.numShapes);
+
+      Sums rangeSums = Sums{ 0.0, 0.0, 0.0 };
+      for (int K = begin; K < end; ++K)
+      {
+        const ElementGeometry2D geometry = fem.mesh.elementGeometry(K);
+        for (int k = 0; k < numNodes; ++k)
+          GLnodes[k] = geometry.toLocal(refNodes[k][0], refNodes[k][1]);
+        for (int j = 0; j < basis.numShapes; ++j)
+          coefficients[j] = fem.shapeSign(K, j) * fem(K, j)[varIndex];
+
+        evaluateCoefficient2D(u, GLnodes, uValues);
+        basis.mapToElement(geometry, 0, 0, phi);
+        if (computeGradient)
+        {
+          evaluateCoefficient2D(dudx, GLnodes, uxValues);
+          evaluateCoefficient2D(dudy, GLnodes, uyValues);
+          basis.mapToElement(geometry, 1, 0, phi_x);
+          basis.mapToElement(geometry, 0, 1, phi_y);
+        }
+        if (computeEnergy)
+        {
+          evaluateCoefficientOnElements2D(a, &K, 1, GLnodes, aValues);
+          evaluateCoefficientOnElements2D(c, &K, 1, GLnodes, cValues);
+        }
+
+        Sums local = Sums{ 0.0, 0.0, 0.0 };
+        for (int k = 0; k < numNodes; ++k)
+        {
+          const real w = abs(geometry.determinant) * refWeights[k];
+
+          real uh = 0.0;
+          for (int j = 0; j < basis.numShapes; ++j)
+            uh += coefficients[j] * phi[k][j];
+          const real e = uValues[k] - uh;
+          local.L2 += w * e * e;
+
+          if (computeGradient)
+          {
+            real uh_x = 0.0;
+            real uh_y = 0.0;
+            for (int j = 0; j < basis.numShapes; ++j)
+            {
+              uh_x += coefficients[j] * phi_x[k][j];
+              uh_y += coefficients[j] * phi_y[k][j];
+            }
+            const real e_x = uxValues[k] - uh_x;
+            const real e_y = uyValues[k] - uh_y;
+            local.H1Seminorm += w * (e_x * e_x + e_y * e_y);
+
+            if (computeEnergy)
+              local.energy += w * (aValues[k] * (e_x * e_x + e_y * e_y) + cValues[k] * e * e);
+          }
+        }
+
+        norms.elementL2[K] = sqrt(local.L2);
+        if (computeGradient)
+          norms.elementH1Seminorm[K] = sqrt(local.H1Seminorm);
+        if (computeEnergy)
+          norms.elementEnergy[K] = sqrt(local.energy);
+
+        rangeSums.L2 += local.L2;
+        rangeSums.H1Seminorm += local.H1Seminorm;
+        rangeSums.energy += local.energy;
+      }
+      return rangeSums;
+    },
+    [](const Sums& left, const Sums& right)
+    {
+      return Sums{ left.L2 + right.L2, left.H1Seminorm + right.H1Seminorm, left.energy + right.energy };
+    });
+  });
+
+  norms.L2 = sqrt(sums.L2);
+  if (computeGradient)
+  {
+    norms.H1Seminorm = sqrt(sums.H1Seminorm);
+    norms.H1 = sqrt(sums.L2 + sums.H1Seminorm);
+  }
+  if (computeEnergy)
+    norms.energy = sqrt(sums.energy);
+  return norms;
+}
+
+/*
+  Computes the L2 error norm of one variable of a FEM2D.
+  See the general version of FE_ErrorNorms2D above.
+*/
+template<int N, typename U>
+ErrorNorms2D FE_ErrorNorms2D(const int varIndex, const FEM2D<N>& fem, const int n_gq, const U& u)
+{
+  const ConstantCoefficient2D zero = ConstantCoefficient2D(0.0);
+  return FE_ErrorNorms2D(varIndex, fem, n_gq, u, zero, zero, zero, zero, false, false);
+}
+
+/*
+  Computes the L2, H1 seminorm and H1 error norms of one variable of a FEM2D.
+  See the general version of FE_ErrorNorms2D above.
+*/
+template<int N, typename U, typename Ux, typename Uy>
+ErrorNorms2D FE_ErrorNorms2D(const int varIndex, const FEM2D<N>& fem, const int n_gq, const U& u, const Ux& dudx, const Uy& dudy)
+{
+  const ConstantCoefficient2D zero = ConstantCoefficient2D(0.0);
+  return FE_ErrorNorms2D(varIndex, fem, n_gq, u, dudx, dudy, zero, zero, true, false);
+}
+
+/*
+  Computes all error norms of one variable of a FEM2D, the energy norm being
+  the one of the operator -div(a grad u) + c u.
+  See the general version of FE_ErrorNorms2D above.
+*/
+template<int N, typename U, typename Ux, typename Uy, typename A, typename C>
+ErrorNorms2D FE_ErrorNorms2D(const int varIndex, const FEM2D<N>& fem, const int n_gq, const U& u, const Ux& dudx, const Uy& dudy, const A& a, const C& c)
+{
+  return FE_ErrorNorms2D(varIndex, fem, n_gq, u, dudx, dudy, a, c, true, true);
+}
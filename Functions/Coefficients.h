@@ -0,0 +1,139 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Base class for coefficients that evaluate a whole batch of points
+  in one call.  Derived classes must provide
+
+    void evaluate(const std::array<real, 2>* points, const int numPoints, real* values) const;
+
+  which writes the value of the coefficient at points[k] into values[k].
+
+  Assembly routines evaluate coefficients once per quadrature point
+  through this interface, so this is the place to put vectorized (SIMD)
+  or otherwise expensive coefficients, such as ones built from
+  transcendental functions.
+
+  Assembly is multithreaded, so evaluate may be called concurrently
+  from several threads and must not modify shared state.
+*/
+struct BatchCoefficient2D
+{
+};
+
+/*
+  Adapter that allows any pointwise callable (real2DFunction, lambda,
+  std::function, ...) to be used as a batch coefficient.
+*/
+template<typename Function>
+struct PointwiseCoefficient2D : public BatchCoefficient2D
+{
+  Function f;
+
+  PointwiseCoefficient2D(Function function)
+    : f(function)
+  {
+  }
+
+  void evaluate(const std::array<real, 2>* points, const int numPoints, real* values) const
+  {
+    for (int k = 0; k < numPoints; ++k)
+      values[k] = f(points[k][0], points[k][1]);
+  }
+};
+
+/*
+  A coefficient that takes the same value everywhere.
+*/
+struct ConstantCoefficient2D : public BatchCoefficient2D
+{
+  real value;
+
+  ConstantCoefficient2D(const real constant)
+    : value(constant)
+  {
+  }
+
+  void evaluate(const std::array<real, 2>*, const int numPoints, real* values) const
+  {
+    for (int k = 0; k < numPoints; ++k)
+      values[k] = value;
+  }
+};
+
+/*
+  Wraps a pointwise callable in a batch coefficient.
+*/
+template<typename Function>
+PointwiseCoefficient2D<Function> makeCoefficient2D(Function f)
+{
+  return PointwiseCoefficient2D<Function>(f);
+}
+
+/*
+  Evaluates the coefficient "a" at each of the given points.
+
+  Batch coefficients are handed the entire array of points at once,
+  any other callable is treated as a pointwise function of (x, y).
+  values must have room for at least points.size() entries.
+*/
+template<typename Coefficient>
+std::enable_if_t<std::is_base_of<BatchCoefficient2D, Coefficient>::value>
+evaluateCoefficient2D(const Coefficient& a, const std::vector<std::array<real, 2>>& points, std::vector<real>& values)
+{
+  ASSERT(values.size() >= points.size(), "Not enough room to store coefficient values");
+  a.evaluate(points.data(), (int)points.size(), values.data());
+}
+template<typename Function>
+std::enable_if_t<!std::is_base_of<BatchCoefficient2D, Function>::value>
+evaluateCoefficient2D(const Function& a, const std::vector<std::array<real, 2>>& points, std::vector<real>& values)
+{
+  ASSERT(values.size() >= points.size(), "Not enough room to store coefficient values");
+  for (int k = 0; k < (int)points.size(); ++k)
+    values[k] = a(points[k][0], points[k][1]);
+}
+
+/*
+  Evaluates the coefficient "a" at the points of a batch of elements,
+  where points holds the same number of points on each of the given elements,
+  one element after another.
+
+  Coefficients that are stored per element provide an overload of
+  this that reads their values without looking at the points.
+*/
+template<typename Coefficient>
+void evaluateCoefficientOnElements2D(const Coefficient& a, const int*, const int,
+                                     const std::vector<std::array<real, 2>>& points, std::vector<real>& values)
+{
+  evaluateCoefficient2D(a, points, values);
+}
+
+/*
+  \returns the polynomial degree of the coefficient "a", which assembly uses to
+  select a quadrature rule (see AutomaticQuadrature in Functions/Gauss-LegendreNodes.h),
+  or UnknownCoefficientDegree if "a" is not known to be a polynomial.
+
+  Coefficients that are polynomials provide an overload of this.
+*/
+constexpr int UnknownCoefficientDegree = -1;
+
+template<typename Function>
+int coefficientDegree2D(const Function&)
+{
+  return UnknownCoefficientDegree;
+}
+inline int coefficientDegree2D(const ConstantCoefficient2D&)
+{
+  return 0;
+}
+
+/*
+  Evaluates a 1D coefficient at each of the given points.
+*/
+template<typename Function>
+void evaluateCoefficient1D(const Function& a, const std::vector<real>& points, std::vector<real>& values)
+{
+  ASSERT(values.size() >= points.size(), "Not enough room to store coefficient values");
+  for (int k = 0; k < (int)points.size(); ++k)
+    values[k] = a(points[k]);
+}
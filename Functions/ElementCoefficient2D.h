@@ -0,0 +1,76 @@
+#pragma once
+#include "Precompilied.h"
+#include "Coefficients.h"
+#include "Meshing/2D/Mesh2D.h"
+
+/*
+  A coefficient that is constant on each element of a mesh, stored as
+  one value per element.  Meant for multi-material problems, where the
+  value usually comes from the region tag of the element.
+
+  Assembly reads the value of each element straight from memory, and since
+  the coefficient is constant on each element, element matrices of congruent
+  elements are scaled rather than integrated (see Mesh2D::congruenceClass).
+  At any other point the coefficient takes the value of the element that
+  contains it.
+*/
+struct ElementCoefficient2D : public BatchCoefficient2D
+{
+  const Mesh2D& mesh;
+  std::vector<real> values;  // Value of the coefficient on each element
+
+  ElementCoefficient2D(const Mesh2D& coefficientMesh, const std::vector<real>& elementValues)
+    : mesh(coefficientMesh),
+      values(elementValues)
+  {
+    ASSERT((int)values.size() == mesh.size, "Coefficient must have one value per element");
+  }
+
+  void evaluate(const std::array<real, 2>* points, const int numPoints, real* pointValues) const
+  {
+    for (int k = 0; k < numPoints; ++k)
+    {
+      const int K = mesh.locate(points[k][0], points[k][1]);
+      ASSERT(K >= 0, "Point is not inside the mesh");
+      pointValues[k] = values[K];
+    }
+  }
+};
+
+/*
+  \returns the coefficient that takes the value regionValues[r] on all elements of region r.
+*/
+inline ElementCoefficient2D regionCoefficient2D(const Mesh2D& mesh, const std::vector<real>& regionValues)
+{
+  std::vector<real> elementValues = std::vector<real>(mesh.size);
+  for (int K = 0; K < mesh.size; ++K)
+  {
+    const int region = mesh.elementRegion(K);
+    ASSERT(region >= 0 && region < (int)regionValues.size(), "No value given for region of element");
+    elementValues[K] = regionValues[region];
+  }
+  return ElementCoefficient2D(mesh, elementValues);
+}
+
+/*
+  Reads the values of an element coefficient on a batch of elements,
+  see evaluateCoefficientOnElements2D in Coefficients.h.
+*/
+inline void evaluateCoefficientOnElements2D(const ElementCoefficient2D& a, const int* elements, const int numElements,
+                                            const std::vector<std::array<real, 2>>& points, std::vector<real>& values)
+{
+  ASSERT(values.size() >= points.size(), "Not enough room to store coefficient values");
+
+  const int numPoints = (int)points.size() / numElements;
+  for (int l = 0; l < numElements; ++l)
+    for (int k = 0; k < numPoints; ++k)
+      values[l * numPoints + k] = a.values[elements[l]];
+}
+
+/*
+  Element coefficients are constant on each element, see coefficientDegree2D in Coefficients.h.
+*/
+inline int coefficientDegree2D(const ElementCoefficient2D&)
+{
+  return 0;
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include "Precompilied.h"
+#include "ReferenceBasis2D.h"
+#include "Meshing/2D/Mesh2D.h"
+#include "Utilities/LocalArray.h"
+#include "LinearAlgebra/SmallGemm.h"
+
+/*
+  Evaluates the specified derivative of all shape functions of order P
+  on an element at the reference point (tx, ty), storing them in values.
+
+  Derivatives orders must be at most one in total.
+*/
+template<int P>
+void evaluateShapeFunctions2D(const BasisType basisType, const int polynomialOrder,
+                              const ElementGeometry2D& geometry,
+                              const real tx, const real ty,
+                              const int xDerivativeOrder, const int yDerivativeOrder,
+                              real* values)
+{
+  if (xDerivativeOrder == 0 && yDerivativeOrder == 0)
+    evaluateRefBasis2D<P>(basisType, polynomialOrder, tx, ty, 0, 0, values);
+  else if (xDerivativeOrder + yDerivativeOrder == 1)
+  {
+    const int numShapes = numLocalNodes2D(polynomialOrder);
+    LocalArray<real, RefLagrangeBasis2D<P>::numShapes> dtx = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>(numShapes);
+    LocalArray<real, RefLagrangeBasis2D<P>::numShapes> dty = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>(numShapes);
+    evaluateRefBasis2D<P>(basisType, polynomialOrder, tx, ty, 1, 0, dtx.data());
+    evaluateRefBasis2D<P>(basisType, polynomialOrder, tx, ty, 0, 1, dty.data());
+
+    // Chain rule through inverse of affine map
+    const int c = yDerivativeOrder;
+    for (int j = 0; j < numShapes; ++j)
+      values[j] = geometry.Binv[0][c] * dtx[j] + geometry.Binv[1][c] * dty[j];
+  }
+  else
+    LOG("Derivative order not implemented", LogLevel::Error);
+}
+
+/*
+  Shape functions of order P and their first derivatives,
+  tabulated at a set of points on the reference triangle.
+
+  Since the reference values do not depend on the element, a table is built
+  once per assembly and mapped onto each element with the element's geometry.
+  The shape functions are Lagrange ones unless another basis type is given.
+*/
+template<int P>
+struct RefBasisTable2D
+{
+  static constexpr int n = RefLagrangeBasis2D<P>::numShapes;
+  using Row = LocalArray<real, n>;
+
+  const int polynomialOrder;
+  const int numShapes;
+  const int numPoints;
+  std::vector<Row> values;  // values[k][j] is the j-th shape function at the k-th point
+  std::vector<Row> dtx;     // Derivative with respect to tx
+  std::vector<Row> dty;     // Derivative with respect to ty
+
+  RefBasisTable2D(const int order, const std::vector<std::array<real, 2>>& refPoints, const BasisType basisType = BasisType::Lagrange)
+    : polynomialOrder(order),
+      numShapes(numLocalNodes2D(order)),
+      numPoints((int)refPoints.size()),
+      values(refPoints.size(), Row(numLocalNodes2D(order))),
+      dtx(refPoints.size(), Row(numLocalNodes2D(order))),
+      dty(refPoints.size(), Row(numLocalNodes2D(order)))
+  {
+    ASSERT(P == DynamicOrder || P == order, "Polynomial order does not match table");
+
+    for (int k = 0; k < numPoints; ++k)
+    {
+      const real& tx = refPoints[k][0];
+      const real& ty = refPoints[k][1];
+      evaluateRefBasis2D<P>(basisType, order, tx, ty, 0, 0, values[k].data());
+      evaluateRefBasis2D<P>(basisType, order, tx, ty, 1, 0, dtx[k].data());
+      evaluateRefBasis2D<P>(basisType, order, tx, ty, 0, 1, dty[k].data());
+    }
+  }
+
+  /*
+    \returns an empty table of the correct dimensions, to be filled by mapToElement.
+  */
+  std::vector<Row> makeTable() const
+  {
+    return std::vector<Row>(numPoints, Row(numShapes));
+  }
+
+  /*
+    Writes the specified derivative of the shape functions on an element
+    at each of the tabulated points into table.
+
+    Derivatives orders must be at most one in total.
+  */
+  void mapToElement(const ElementGeometry2D& geometry,
+                    const int xDerivativeOrder, const int yDerivativeOrder,
+                    std::vector<Row>& table) const
+  {
+    if (xDerivativeOrder == 0 && yDerivativeOrder == 0)
+    {
+      for (int k = 0; k < numPoints; ++k)
+        for (int j = 0; j < numShapes; ++j)
+          table[k][j] = values[k][j];
+    }
+    else if (xDerivativeOrder + yDerivativeOrder == 1)
+    {
+      // Chain rule through inverse of affine map
+      const int c = yDerivativeOrder;
+      const real& cx = geometry.Binv[0][c];
+      const real& cy = geometry.Binv[1][c];
+      for (int k = 0; k < numPoints; ++k)
+        for (int j = 0; j < numShapes; ++j)
+          table[k][j] = cx * dtx[k][j] + cy * dty[k][j];
+    }
+    else
+      LOG("Derivative order not implemented", LogLevel::Error);
+  }
+
+  /*
+    Same as mapToElement, but writes into lane "lane" of an interleaved
+    numPoints x numShapes table, as used by the microkernels in
+    LinearAlgebra/SmallGemm.h.  table must hold numPoints * numShapes * RealPack::width entries.
+  */
+  void mapToElementInterleaved(const ElementGeometry2D& geometry,
+                               const int xDerivativeOrder, const int yDerivativeOrder,
+                               const int lane, real* table) const
+  {
+    constexpr int W = RealPack::width;
+    if (xDerivativeOrder == 0 && yDerivativeOrder == 0)
+    {
+      for (int k = 0; k < numPoints; ++k)
+        for (int j = 0; j < numShapes; ++j)
+          table[(k * numShapes + j) * W + lane] = values[k][j];
+    }
+    else if (xDerivativeOrder + yDerivativeOrder == 1)
+    {
+      // Chain rule through inverse of affine map
+      const int c = yDerivativeOrder;
+      const real& cx = geometry.Binv[0][c];
+      const real& cy = geometry.Binv[1][c];
+      for (int k = 0; k < numPoints; ++k)
+        for (int j = 0; j < numShapes; ++j)
+          table[(k * numShapes + j) * W + lane] = cx * dtx[k][j] + cy * dty[k][j];
+    }
+    else
+      LOG("Derivative order not implemented", LogLevel::Error);
+  }
+};
+
+/*
+  Computes the local mass matrix on an element,
+
+    local[i][j] = sum_k w[k] * phi1[k][i] * phi2[k][j],
+
+  where w holds the quadrature weights already multiplied by the coefficient.
+*/
+template<int P1, int P2>
+void elementMassMatrix2D(const std::vector<typename RefBasisTable2D<P1>::Row>& phi1,
+                         const std::vector<typename RefBasisTable2D<P2>::Row>& phi2,
+                         const real* w,
+                         LocalMatrix<real, RefBasisTable2D<P1>::n, RefBasisTable2D<P2>::n>& local)
+{
+  local.setZero();
+  for (int k = 0; k < (int)phi1.size(); ++k)
+    for (int i = 0; i < local.rows(); ++i)
+    {
+      const real wi = w[k] * phi1[k][i];
+      for (int j = 0; j < local.columns(); ++j)
+        local[i][j] += wi * phi2[k][j];
+    }
+}
+
+/*
+  Computes the local load vector on an element,
+
+    local[j] = sum_k w[k] * phi[k][j],
+
+  where w holds the quadrature weights already multiplied by the function.
+*/
+template<int P>
+void elementLoadVector2D(const std::vector<typename RefBasisTable2D<P>::Row>& phi,
+                         const real* w,
+                         LocalArray<real, RefBasisTable2D<P>::n>& local)
+{
+  for (int j = 0; j < local.size(); ++j)
+    local[j] = 0.0;
+  for (int k = 0; k < (int)phi.size(); ++k)
+    for (int j = 0; j < local.size(); ++j)
+      local[j] += w[k] * phi[k][j];
+}
+
+/*
+  Computes the local mass matrices of a batch of RealPack::width elements
+  at once as B1^T * W * B2, where B1 and B2 hold the shape functions at the
+  quadrature points and W the weights already multiplied by the coefficient.
+
+  All arguments are interleaved over the elements of the batch
+  (see LinearAlgebra/SmallGemm.h).  Lanes that do not correspond to an
+  element should be given zero weights.
+*/
+template<int P1, int P2>
+void elementMassMatrices2D(const real* phi1, const real* phi2, const real* w,
+                           const int numPoints, const int numShapes1, const int numShapes2,
+                           real* local)
+{
+  interleavedGemmTWN<RefBasisTable2D<P1>::n, RefBasisTable2D<P2>::n>(phi1, w, phi2, local, numPoints, numShapes1, numShapes2);
+}
+
+/*
+  Computes the local load vectors of a batch of RealPack::width elements
+  at once as B^T * w.  Follows the same conventions as elementMassMatrices2D.
+*/
+template<int P>
+void elementLoadVectors2D(const real* phi, const real* w,
+                          const int numPoints, const int numShapes,
+                          real* local)
+{
+  interleavedGemvTW<RefBasisTable2D<P>::n>(phi, w, local, numPoints, numShapes);
+}
+
+/*
+  \returns whether a coefficient takes the same value at all numPoints
+  quadrature points of an element.  Quadrature then gives exactly that value
+  times the element matrix for a unit coefficient.
+*/
+inline bool isConstantOnElement(const real* values, const int numPoints)
+{
+  for (int k = 1; k < numPoints; ++k)
+    if (values[k] != values[0])
+      return false;
+  return true;
+}
+
+/*
+  \returns the local mass matrix for a unit coefficient on each congruence
+  class of elements of the mesh (see Mesh2D::congruenceClass).
+*/
+template<int P1, int P2>
+std::vector<LocalMatrix<real, RefBasisTable2D<P1>::n, RefBasisTable2D<P2>::n>>
+congruentElementMassMatrices2D(const Mesh2D& mesh,
+                               const RefBasisTable2D<P1>& basis1, const RefBasisTable2D<P2>& basis2,
+                               const std::vector<real>& refWeights,
+                               const int xDerivativeOrder1, const int yDerivativeOrder1,
+                               const int xDerivativeOrder2, const int yDerivativeOrder2)
+{
+  using Local = LocalMatrix<real, RefBasisTable2D<P1>::n, RefBasisTable2D<P2>::n>;
+
+  std::vector<typename RefBasisTable2D<P1>::Row> phi1 = basis1.makeTable();
+  std::vector<typename RefBasisTable2D<P2>::Row> phi2 = basis2.makeTable();
+  std::vector<real> weights = std::vector<real>(basis1.numPoints);
+  std::vector<Local> matrices;
+  for (int c = 0; c < mesh.numCongruenceClasses(); ++c)
+  {
+    const ElementGeometry2D geometry = mesh.elementGeometry(mesh.congruenceClassElement(c));
+    basis1.mapToElement(geometry, xDerivativeOrder1, yDerivativeOrder1, phi1);
+    basis2.mapToElement(geometry, xDerivativeOrder2, yDerivativeOrder2, phi2);
+    for (int k = 0; k < basis1.numPoints; ++k)
+      weights[k] = abs(geometry.determinant) * refWeights[k];
+
+    Local local = Local(basis1.numShapes, basis2.numShapes);
+    elementMassMatrix2D<P1, P2>(phi1, phi2, weights.data(), local);
+    matrices.push_back(local);
+  }
+  return matrices;
+}
+
+/*
+  \returns the local load vector for a unit function on each congruence
+  class of elements of the mesh (see Mesh2D::congruenceClass).
+*/
+template<int P>
+std::vector<LocalArray<real, RefBasisTable2D<P>::n>>
+congruentElementLoadVectors2D(const Mesh2D& mesh,
+                              const RefBasisTable2D<P>& basis,
+                              const std::vector<real>& refWeights,
+                              const int xDerivativeOrder, const int yDerivativeOrder)
+{
+  using Local = LocalArray<real, RefBasisTable2D<P>::n>;
+
+  std::vector<typename RefBasisTable2D<P>::Row> phi = basis.makeTable();
+  std::vector<real> weights = std::vector<real>(basis.numPoints);
+  std::vector<Local> vectors;
+  for (int c = 0; c < mesh.numCongruenceClasses(); ++c)
+  {
+    const ElementGeometry2D geometry = mesh.elementGeometry(mesh.congruenceClassElement(c));
+    basis.mapToElement(geometry, xDerivativeOrder, yDerivativeOrder, phi);
+    for (int k = 0; k < basis.numPoints; ++k)
+      weights[k] = abs(geometry.determinant) * refWeights[k];
+
+    Local local = Local(basis.numShapes);
+    elementLoadVector2D<P>(phi, weights.data(), local);
+    vectors.push_back(local);
+  }
+  return vectors;
+}
@@ -72,6 +72,32 @@ static const std::vector<real> gauss1DWeights7 = { 0.1294849661688696932706,
 
 
 
+static const std::vector<std::array<real, 2>> gauss2DNodes1 = { { 3.333333333333333e-01, 3.333333333333333e-01 } };
+
+static const std::vector<real> gauss2DWeights1 = { 5.000000000000000e-01 };
+
+static const std::vector<std::array<real, 2>> gauss2DNodes3 = { { 1.666666666666667e-01, 1.666666666666667e-01 },
+                                                                { 6.666666666666667e-01, 1.666666666666667e-01 },
+                                                                { 1.666666666666667e-01, 6.666666666666667e-01 } };
+
+static const std::vector<real> gauss2DWeights3 = { 1.666666666666667e-01,
+                                                   1.666666666666667e-01,
+                                                   1.666666666666667e-01 };
+
+static const std::vector<std::array<real, 2>> gauss2DNodes6 = { { 4.459484909159650e-01, 4.459484909159650e-01 },
+                                                                { 1.081030181680700e-01, 4.459484909159650e-01 },
+                                                                { 4.459484909159650e-01, 1.081030181680700e-01 },
+                                                                { 9.157621350977101e-02, 9.157621350977101e-02 },
+                                                                { 8.168475729804580e-01, 9.157621350977101e-02 },
+                                                                { 9.157621350977101e-02, 8.168475729804580e-01 } };
+
+static const std::vector<real> gauss2DWeights6 = { 1.116907948390055e-01,
+                                                   1.116907948390055e-01,
+                                                   1.116907948390055e-01,
+                                                   5.497587182766100e-02,
+                                                   5.497587182766100e-02,
+                                                   5.497587182766100e-02 };
+
 static const std::vector<std::array<real, 2>> gauss2DNodes7 = { { 1.012865073234563e-01, 1.012865073234563e-01 },
                                                                 { 7.974269853530872e-01, 1.012865073234563e-01 },
                                                                 { 1.012865073234563e-01, 7.974269853530872e-01},
@@ -88,6 +114,311 @@ static const std::vector<real> gauss2DWeights7 = { 6.296959027241358e-02,
                                                    6.619707639425308e-02,
                                                    1.125000000000000e-01 };
 
+static const std::vector<std::array<real, 2>> gauss2DNodes12 = { { 6.308901449150200e-02, 6.308901449150200e-02 },
+                                                                 { 8.738219710169960e-01, 6.308901449150200e-02 },
+                                                                 { 6.308901449150200e-02, 8.738219710169960e-01 },
+                                                                 { 2.492867451709100e-01, 2.492867451709100e-01 },
+                                                                 { 5.014265096581800e-01, 2.492867451709100e-01 },
+                                                                 { 2.492867451709100e-01, 5.014265096581800e-01 },
+                                                                 { 5.314504984481700e-02, 3.103524510337840e-01 },
+                                                                 { 3.103524510337840e-01, 5.314504984481700e-02 },
+                                                                 { 5.314504984481700e-02, 6.365024991213990e-01 },
+                                                                 { 6.365024991213990e-01, 5.314504984481700e-02 },
+                                                                 { 3.103524510337840e-01, 6.365024991213990e-01 },
+                                                                 { 6.365024991213990e-01, 3.103524510337840e-01 } };
+
+static const std::vector<real> gauss2DWeights12 = { 2.542245318510350e-02,
+                                                    2.542245318510350e-02,
+                                                    2.542245318510350e-02,
+                                                    5.839313786318950e-02,
+                                                    5.839313786318950e-02,
+                                                    5.839313786318950e-02,
+                                                    4.142553780918700e-02,
+                                                    4.142553780918700e-02,
+                                                    4.142553780918700e-02,
+                                                    4.142553780918700e-02,
+                                                    4.142553780918700e-02,
+                                                    4.142553780918700e-02 };
+
+static const std::vector<std::array<real, 2>> gauss2DNodes16 = { { 3.333333333333333e-01, 3.333333333333333e-01 },
+                                                                 { 4.592925882927230e-01, 4.592925882927230e-01 },
+                                                                 { 8.141482341455397e-02, 4.592925882927230e-01 },
+                                                                 { 4.592925882927230e-01, 8.141482341455397e-02 },
+                                                                 { 1.705693077517600e-01, 1.705693077517600e-01 },
+                                                                 { 6.588613844964800e-01, 1.705693077517600e-01 },
+                                                                 { 1.705693077517600e-01, 6.588613844964800e-01 },
+                                                                 { 5.054722831703100e-02, 5.054722831703100e-02 },
+                                                                 { 8.989055433659380e-01, 5.054722831703100e-02 },
+                                                                 { 5.054722831703100e-02, 8.989055433659380e-01 },
+                                                                 { 8.394777409958001e-03, 2.631128296346380e-01 },
+                                                                 { 2.631128296346380e-01, 8.394777409958001e-03 },
+                                                                 { 8.394777409958001e-03, 7.284923929554040e-01 },
+                                                                 { 7.284923929554040e-01, 8.394777409958001e-03 },
+                                                                 { 2.631128296346380e-01, 7.284923929554040e-01 },
+                                                                 { 7.284923929554040e-01, 2.631128296346380e-01 } };
+
+static const std::vector<real> gauss2DWeights16 = { 7.215780383889350e-02,
+                                                    4.754581713364250e-02,
+                                                    4.754581713364250e-02,
+                                                    4.754581713364250e-02,
+                                                    5.160868526735900e-02,
+                                                    5.160868526735900e-02,
+                                                    5.160868526735900e-02,
+                                                    1.622924881159900e-02,
+                                                    1.622924881159900e-02,
+                                                    1.622924881159900e-02,
+                                                    1.361515708721750e-02,
+                                                    1.361515708721750e-02,
+                                                    1.361515708721750e-02,
+                                                    1.361515708721750e-02,
+                                                    1.361515708721750e-02,
+                                                    1.361515708721750e-02 };
+
+
+
+/*
+  A quadrature rule that is computed rather than tabulated.
+*/
+struct ComputedRule
+{
+  std::vector<real> nodes1D;
+  std::vector<std::array<real, 2>> nodes2D;
+  std::vector<real> weights;
+};
+
+/*
+  Computes the eigenvalues of the symmetric tridiagonal matrix with the given
+  diagonal and off-diagonal (offDiagonal[i] couples rows i and i + 1), along with the
+  first components of its normalized eigenvectors, with the implicit QL algorithm.
+  Both vectors are overwritten, the eigenvalues end up in diagonal.
+*/
+static void symmetricTridiagonalEigen(std::vector<real>& diagonal, std::vector<real>& offDiagonal, std::vector<real>& firstComponents)
+{
+  std::vector<real>& d = diagonal;
+  std::vector<real>& e = offDiagonal;
+  std::vector<real>& z = firstComponents;
+  const int n = (int)d.size();
+
+  z.assign(n, 0.0);
+  z[0] = 1.0;
+  e.resize(n);
+  e[n - 1] = 0.0;
+  for (int l = 0; l < n; ++l)
+  {
+    int iteration = 0;
+    int m;
+    do
+    {
+      // Look for a small off-diagonal element to split the matrix
+      for (m = l; m < n - 1; ++m)
+        if (abs(e[m]) <= std::numeric_limits<real>::epsilon() * (abs(d[m]) + abs(d[m + 1])))
+          break;
+
+      if (m != l)
+      {
+        if (iteration++ == 60)
+          LOG("Eigenvalue iteration did not converge", LogLevel::Error);
+
+        // Wilkinson shift
+        real g = (d[l + 1] - d[l]) / (2 * e[l]);
+        real r = hypot(g, 1.0);
+        g = d[m] - d[l] + e[l] / (g + (g >= 0 ? r : -r));
+
+        real s = 1.0;
+        real c = 1.0;
+        real p = 0.0;
+        int i;
+        for (i = m - 1; i >= l; --i)
+        {
+          const real f = s * e[i];
+          const real b = c * e[i];
+          r = hypot(f, g);
+          e[i + 1] = r;
+          if (r == 0.0)
+          {
+            // Underflow, start over on the remaining submatrix
+            d[i + 1] -= p;
+            e[m] = 0.0;
+            break;
+          }
+          s = f / r;
+          c = g / r;
+          g = d[i + 1] - p;
+          r = (d[i] - g) * s + 2 * c * b;
+          p = s * r;
+          d[i + 1] = g + p;
+          g = c * r - b;
+
+          // Rotate the first components of the eigenvectors along
+          const real zi = z[i + 1];
+          z[i + 1] = s * z[i] + c * zi;
+          z[i] = c * z[i] - s * zi;
+        }
+        if (r == 0.0 && i >= l)
+          continue;
+        d[l] -= p;
+        e[l] = g;
+        e[m] = 0.0;
+      }
+    } while (m != l);
+  }
+}
+
+/*
+  Computes the n-point Gauss-Jacobi rule for the weight (1 - t)^alpha * (1 + t)^beta
+  on [-1, 1] with the Golub-Welsch algorithm: the nodes are the eigenvalues of the
+  Jacobi matrix of the three-term recurrence of the orthogonal polynomials, and the
+  weights are the squared first components of its eigenvectors times the integral of the weight.
+*/
+static void gaussJacobi1D(const int numNodes, const real alpha, const real beta, std::vector<real>& nodes, std::vector<real>& weights)
+{
+  const int& n = numNodes;
+  const real ab = alpha + beta;
+
+  // Jacobi matrix of the monic Jacobi polynomials
+  std::vector<real> diagonal = std::vector<real>(n);
+  std::vector<real> offDiagonal = std::vector<real>(n);
+  diagonal[0] = (beta - alpha) / (ab + 2);
+  for (int k = 1; k < n; ++k)
+  {
+    const real s = 2 * k + ab;
+    diagonal[k] = (beta * beta - alpha * alpha) / (s * (s + 2));
+    offDiagonal[k - 1] = sqrt(4 * k * (k + alpha) * (k + beta) * (k + ab) / (s * s * (s + 1) * (s - 1)));
+  }
+
+  std::vector<real> firstComponents;
+  symmetricTridiagonalEigen(diagonal, offDiagonal, firstComponents);
+
+  const real mu0 = pow(2.0, ab + 1) * tgamma(alpha + 1) * tgamma(beta + 1) / tgamma(ab + 2);
+  std::vector<int> order = std::vector<int>(n);
+  for (int i = 0; i < n; ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](const int i, const int j) { return diagonal[i] < diagonal[j]; });
+
+  nodes.resize(n);
+  weights.resize(n);
+  for (int i = 0; i < n; ++i)
+  {
+    nodes[i] = diagonal[order[i]];
+    weights[i] = mu0 * firstComponents[order[i]] * firstComponents[order[i]];
+  }
+}
+
+/*
+  \returns the cached rule for numNodes, computing it with compute on first use.
+  Cached rules are never moved or freed, so references to them stay valid.
+*/
+template<typename Compute>
+static const ComputedRule& cachedRule(std::vector<std::unique_ptr<ComputedRule>>& cache, const int numNodes, const Compute& compute)
+{
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if ((int)cache.size() <= numNodes)
+    cache.resize(numNodes + 1);
+  if (!cache[numNodes])
+  {
+    cache[numNodes] = std::make_unique<ComputedRule>();
+    compute(*cache[numNodes]);
+  }
+  return *cache[numNodes];
+}
+
+static std::vector<std::unique_ptr<ComputedRule>> gauss1DCache;
+static std::vector<std::unique_ptr<ComputedRule>> gaussLobatto1DCache;
+static std::vector<std::unique_ptr<ComputedRule>> gauss2DCache;
+
+static const ComputedRule& gauss1DComputed(const int numNodes)
+{
+  return cachedRule(gauss1DCache, numNodes, [numNodes](ComputedRule& rule)
+  {
+    gaussJacobi1D(numNodes, 0.0, 0.0, rule.nodes1D, rule.weights);
+
+    // Symmetrize, so that odd rules have an exact node at 0
+    for (int i = 0; i < numNodes / 2; ++i)
+    {
+      const int j = numNodes - 1 - i;
+      const real node = (rule.nodes1D[j] - rule.nodes1D[i]) / 2;
+      const real weight = (rule.weights[i] + rule.weights[j]) / 2;
+      rule.nodes1D[i] = -node;
+      rule.nodes1D[j] = node;
+      rule.weights[i] = weight;
+      rule.weights[j] = weight;
+    }
+    if (numNodes % 2 == 1)
+      rule.nodes1D[numNodes / 2] = 0.0;
+  });
+}
+
+/*
+  The interior nodes of the n-point Gauss-Lobatto rule are the zeros of P'_{n-1},
+  which are the nodes of the (n - 2)-point Gauss-Jacobi rule with alpha = beta = 1.
+  The weights are 2 / (n(n - 1) P_{n-1}(t)^2).
+*/
+static const ComputedRule& gaussLobatto1DComputed(const int numNodes)
+{
+  return cachedRule(gaussLobatto1DCache, numNodes, [numNodes](ComputedRule& rule)
+  {
+    const int& n = numNodes;
+    std::vector<real> interiorNodes;
+    std::vector<real> interiorWeights;
+    if (n > 2)
+      gaussJacobi1D(n - 2, 1.0, 1.0, interiorNodes, interiorWeights);
+
+    rule.nodes1D.push_back(-1.0);
+    for (const real t : interiorNodes)
+      rule.nodes1D.push_back(t);
+    rule.nodes1D.push_back(1.0);
+
+    // Symmetrize, so that odd rules have an exact node at 0
+    for (int i = 0; i < n / 2; ++i)
+    {
+      const real node = (rule.nodes1D[n - 1 - i] - rule.nodes1D[i]) / 2;
+      rule.nodes1D[i] = -node;
+      rule.nodes1D[n - 1 - i] = node;
+    }
+    if (n % 2 == 1)
+      rule.nodes1D[n / 2] = 0.0;
+
+    for (const real t : rule.nodes1D)
+    {
+      // (k + 1) P_{k+1} = (2k + 1) t P_k - k P_{k-1}
+      real P = t;
+      real P_previous = 1.0;
+      for (int k = 1; k < n - 1; ++k)
+      {
+        const real P_next = ((2 * k + 1) * t * P - k * P_previous) / (k + 1);
+        P_previous = P;
+        P = P_next;
+      }
+      rule.weights.push_back(2.0 / (n * (n - 1) * P * P));
+    }
+  });
+}
+
+/*
+  \returns the rule with n^2 nodes on the reference triangle obtained by collapsing
+  the square [0, 1]^2 onto it through (u, v) -> (u, (1 - u) * v).  The Jacobian 1 - u
+  is absorbed into a Gauss-Jacobi rule in u, so the rule is exact up to degree 2n - 1.
+*/
+static const ComputedRule& gauss2DCollapsed(const int numNodes, const int n)
+{
+  return cachedRule(gauss2DCache, numNodes, [n](ComputedRule& rule)
+  {
+    std::vector<real> s, ws, t, wt;
+    gaussJacobi1D(n, 1.0, 0.0, s, ws);
+    gaussJacobi1D(n, 0.0, 0.0, t, wt);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+      {
+        const real u = (1 + s[i]) / 2;
+        const real v = (1 + t[j]) / 2;
+        rule.nodes2D.push_back({ u, (1 - u) * v });
+        rule.weights.push_back(ws[i] * wt[j] / 8);
+      }
+  });
+}
+
 
 const std::vector<real>& gauss1DNodesRef(const int numNodes)
 {
@@ -108,8 +439,7 @@ const std::vector<real>& gauss1DNodesRef(const int numNodes)
   case 7:
     return gauss1DNodes7;
   default:
-    LOG("Number of nodes not supported", LogLevel::Error);
-    return nullVec;
+    return gauss1DComputed(numNodes).nodes1D;
   }
 }
 
@@ -132,11 +462,17 @@ const std::vector<real>& gauss1DWeightsRef(const int numNodes)
   case 7:
     return gauss1DWeights7;
   default:
-    LOG("Number of nodes not supported", LogLevel::Error);
-    return nullVec;
+    return gauss1DComputed(numNodes).weights;
   }
 }
 
+int gauss1DNumNodes(const int degree)
+{
+  ASSERT(degree >= 0, "Degree must be non-negative");
+
+  return std::max(2, (degree + 2) / 2);
+}
+
 std::vector<real> gauss1DNodesLocal(const Mesh1D& mesh, const int elementIndex, const int numNodes)
 {
   const real& a = mesh(elementIndex, EdgeType::Left).x;
@@ -161,36 +497,116 @@ std::vector<real> gauss1DWeightsLocal(const Mesh1D& mesh, const int elementIndex
   return localWeights;
 }
 
+const std::vector<real>& gaussLobatto1DNodesRef(const int numNodes)
+{
+  ASSERT(numNodes > 1, "Number of nodes must be greater than 1");
 
+  return gaussLobatto1DComputed(numNodes).nodes1D;
+}
 
-const std::vector<std::array<real, 2>>& gauss2DNodesRef(const int numNodes)
+const std::vector<real>& gaussLobatto1DWeightsRef(const int numNodes)
 {
   ASSERT(numNodes > 1, "Number of nodes must be greater than 1");
 
+  return gaussLobatto1DComputed(numNodes).weights;
+}
+
+
+
+/*
+  \returns the number of nodes per direction of the collapsed rule with numNodes nodes,
+  or 0 if there is none.
+*/
+static int collapsedNodesPerDirection(const int numNodes)
+{
+  const int n = (int)std::lround(sqrt((real)numNodes));
+  return n >= 5 && n * n == numNodes ? n : 0;
+}
+
+const std::vector<std::array<real, 2>>& gauss2DNodesRef(const int numNodes)
+{
+  ASSERT(numNodes > 0, "Number of nodes must be positive");
+
   switch (numNodes)
   {
+  case 1:
+    return gauss2DNodes1;
+  case 3:
+    return gauss2DNodes3;
+  case 6:
+    return gauss2DNodes6;
   case 7:
     return gauss2DNodes7;
+  case 12:
+    return gauss2DNodes12;
+  case 16:
+    return gauss2DNodes16;
   default:
-    LOG("Number of nodes not supported", LogLevel::Error);
-    return nullVec2D;
+    if (collapsedNodesPerDirection(numNodes) == 0)
+    {
+      LOG("Number of nodes not supported", LogLevel::Error);
+      return nullVec2D;
+    }
+    return gauss2DCollapsed(numNodes, collapsedNodesPerDirection(numNodes)).nodes2D;
   }
 }
 
 const std::vector<real>& gauss2DWeightsRef(const int numNodes)
 {
-  ASSERT(numNodes > 1, "Number of nodes must be greater than 1");
+  ASSERT(numNodes > 0, "Number of nodes must be positive");
 
   switch (numNodes)
   {
+  case 1:
+    return gauss2DWeights1;
+  case 3:
+    return gauss2DWeights3;
+  case 6:
+    return gauss2DWeights6;
   case 7:
     return gauss2DWeights7;
+  case 12:
+    return gauss2DWeights12;
+  case 16:
+    return gauss2DWeights16;
   default:
-    LOG("Number of nodes not supported", LogLevel::Error);
-    return nullVec;
+    if (collapsedNodesPerDirection(numNodes) == 0)
+    {
+      LOG("Number of nodes not supported", LogLevel::Error);
+      return nullVec;
+    }
+    return gauss2DCollapsed(numNodes, collapsedNodesPerDirection(numNodes)).weights;
   }
 }
 
+int gauss2DNumNodes(const int degree)
+{
+  ASSERT(degree >= 0, "Degree must be non-negative");
+
+  if (degree <= 1)
+    return 1;
+  else if (degree == 2)
+    return 3;
+  else if (degree <= 4)
+    return 6;
+  else if (degree == 5)
+    return 7;
+  else if (degree == 6)
+    return 12;
+  else if (degree <= 8)
+    return 16;
+  else
+  {
+    const int n = (degree + 2) / 2;
+    return n * n;
+  }
+}
+
+int gauss2DNumNodes(const int n_gq, const int integrandDegree)
+{
+  return n_gq == AutomaticQuadrature ? gauss2DNumNodes(integrandDegree) : n_gq;
+}
+
 std::vector<std::array<real, 2>> gauss2DNodesLocal(const Mesh2D& mesh, const int elementIndex, const int numNodes)
 {
   const int& K = elementIndex;
@@ -246,8 +662,8 @@ std::vector<real> gauss2DWeightsLocal(const Mesh2D& mesh, const int elementIndex
 
 std::vector<std::array<real, 2>> gaussEdgeNodesLocal(const Mesh2D& mesh, const int edgeIndex, const int numNodes)
 {
-  const MeshNode2D& A1 = mesh.meshNodes[mesh.edgeArray[edgeIndex][0]];
-  const MeshNode2D& A2 = mesh.meshNodes[mesh.edgeArray[edgeIndex][1]];
+  const MeshNode2D A1 = mesh.node(mesh.edgeNode(edgeIndex, 0));
+  const MeshNode2D A2 = mesh.node(mesh.edgeNode(edgeIndex, 1));
   const std::vector<real>& t = gauss1DNodesRef(numNodes);
 
   std::vector<std::array<real,2>> localNodes = std::vector<std::array<real,2>>(numNodes);
@@ -261,8 +677,8 @@ std::vector<std::array<real, 2>> gaussEdgeNodesLocal(const Mesh2D& mesh, const i
 
 std::vector<real> gaussEdgeWeightsLocal(const Mesh2D& mesh, const int edgeIndex, const int numNodes)
 {
-  const MeshNode2D& A1 = mesh.meshNodes[mesh.edgeArray[edgeIndex][0]];
-  const MeshNode2D& A2 = mesh.meshNodes[mesh.edgeArray[edgeIndex][1]];
+  const MeshNode2D A1 = mesh.node(mesh.edgeNode(edgeIndex, 0));
+  const MeshNode2D A2 = mesh.node(mesh.edgeNode(edgeIndex, 1));
   const std::vector<real>& w = gauss1DWeightsRef(numNodes);
 
   std::vector<real> localWeights = std::vector<real>(numNodes);
@@ -3,21 +3,80 @@
 #include "Meshing/1D/Mesh1D.h"
 #include "Meshing/2D/Mesh2D.h"
 #include "LinearAlgebra/Matrix.h"
+#include "Functions/Coefficients.h"
 
+/*
+  Value of n_gq that has the assembly routines select the cheapest
+  quadrature rule that is exact for the degree of their integrand.
+*/
+constexpr int AutomaticQuadrature = 0;
+
+/*
+  Nodes of the Gauss-Legendre rule with the specified number of nodes on [-1, 1].
+  Rules with more than 7 nodes are computed on first use and cached.
+*/
 const std::vector<real>& gauss1DNodesRef(const int numNodes);
 
 const std::vector<real>& gauss1DWeightsRef(const int numNodes);
 
+/*
+  \returns the number of nodes of the smallest Gauss-Legendre rule that
+  integrates polynomials of the specified degree exactly.
+*/
+int gauss1DNumNodes(const int degree);
+
 std::vector<real> gauss1DNodesLocal(const Mesh1D& mesh, const int elementIndex, const int numNodes);
 
 std::vector<real> gauss1DWeightsLocal(const Mesh1D& mesh, const int elementIndex, const int numNodes);
 
+/*
+  Nodes of the Gauss-Lobatto rule with the specified number of nodes on [-1, 1],
+  which includes both endpoints and is exact up to degree 2 * numNodes - 3.
+  Rules are computed on first use and cached.
+*/
+const std::vector<real>& gaussLobatto1DNodesRef(const int numNodes);
+
+const std::vector<real>& gaussLobatto1DWeightsRef(const int numNodes);
+
 
 
+/*
+  Nodes of a quadrature rule on the reference triangle, with weights summing to 1/2.
+
+  Rules with 1, 3, 6, 7, 12 and 16 nodes are the symmetric rules of Dunavant
+  (with positive weights), exact up to degree 1, 2, 4, 5, 6 and 8.  Rules with n^2 nodes,
+  n >= 5, are collapsed products of n-point Gauss-Jacobi and Gauss-Legendre rules,
+  exact up to degree 2n - 1, which are computed on first use and cached.
+*/
 const std::vector<std::array<real, 2>>& gauss2DNodesRef(const int numNodes);
 
 const std::vector<real>& gauss2DWeightsRef(const int numNodes);
 
+/*
+  \returns the number of nodes of the cheapest rule in gauss2DNodesRef that
+  integrates polynomials of the specified degree exactly.
+*/
+int gauss2DNumNodes(const int degree);
+
+/*
+  \returns n_gq, or if it is AutomaticQuadrature, the number of nodes of
+  the cheapest rule that is exact for an integrand of the specified degree.
+*/
+int gauss2DNumNodes(const int n_gq, const int integrandDegree);
+
+/*
+  \returns the degree of the product of the coefficient "a" with shape functions
+  of total degree shapeDegree.  Coefficients of unknown degree (see coefficientDegree2D)
+  are taken to be of degree polynomialOrder, which keeps the quadrature error
+  at the order of the discretization error.
+*/
+template<typename Function>
+int integrandDegree2D(const Function& a, const int shapeDegree, const int polynomialOrder)
+{
+  const int degree = coefficientDegree2D(a);
+  return shapeDegree + (degree == UnknownCoefficientDegree ? polynomialOrder : degree);
+}
+
 std::vector<std::array<real, 2>> gauss2DNodesLocal(const Mesh2D& mesh, const int elementIndex, const int numNodes);
 
 std::vector<real> gauss2DWeightsLocal(const Mesh2D& mesh, const int elementIndex, const int numNodes);
@@ -0,0 +1,109 @@
+#include "Precompilied.h"
+#include "ReferenceBasis2D.h"
+
+/*
+  Evaluates the Legendre polynomials P_0, ..., P_n at u in [-1, 1],
+  along with their first and second derivatives.
+*/
+static void evaluateLegendre(const int n, const real u, real* P, real* dP, real* d2P)
+{
+  P[0] = 1.0;
+  dP[0] = 0.0;
+  d2P[0] = 0.0;
+  if (n > 0)
+  {
+    P[1] = u;
+    dP[1] = 1.0;
+    d2P[1] = 0.0;
+  }
+
+  // (k + 1) P_{k+1} = (2k + 1) u P_k - k P_{k-1}, differentiated once and twice
+  for (int k = 1; k < n; ++k)
+  {
+    P[k + 1] = ((2 * k + 1) * u * P[k] - k * P[k - 1]) / (k + 1);
+    dP[k + 1] = ((2 * k + 1) * (u * dP[k] + P[k]) - k * dP[k - 1]) / (k + 1);
+    d2P[k + 1] = ((2 * k + 1) * (u * d2P[k] + 2 * dP[k]) - k * d2P[k - 1]) / (k + 1);
+  }
+}
+
+void evaluateRefHierarchicalBasis2D(const int polynomialOrder, const real tx, const real ty,
+                                    const int xDerivativeOrder, const int yDerivativeOrder,
+                                    real* values)
+{
+  const int& p = polynomialOrder;
+  const int derivativeOrder = xDerivativeOrder + yDerivativeOrder;
+
+  // Debug
+  ASSERT(p > 0, "Polynomial order must be positive");
+  ASSERT(xDerivativeOrder >= 0 && yDerivativeOrder >= 0, "Derivative orders must be non-negative");
+
+  if (p > MaxPolynomialOrder2D)
+    LOG("Polynomial order not supported", LogLevel::Error);
+  if (derivativeOrder > 1)
+    LOG("Derivative order not implemented", LogLevel::Error);
+
+  // Barycentric coordinates and their (constant) derivatives in the direction c
+  const real lambda[3] = { 1 - tx - ty, tx, ty };
+  const real grad[3][2] = { { -1, -1 }, { 1, 0 }, { 0, 1 } };
+  const int c = yDerivativeOrder;
+
+  // Each shape function is a product of factors, of which we keep the value f and derivative df,
+  // and the requested derivative of the product follows from the product rule
+  const auto result = [derivativeOrder](const real f, const real df, const real g, const real dg)
+  {
+    return derivativeOrder == 0 ? f * g : df * g + f * dg;
+  };
+
+  // Vertex modes are the barycentric coordinates
+  for (int a = 0; a < 3; ++a)
+    values[a] = derivativeOrder == 0 ? lambda[a] : grad[a][c];
+
+  // Edge modes of order k = 2, ..., p on the edge from vertex a to vertex b are
+  // lambda_a * lambda_b * 4P'_{k-1}(lambda_b - lambda_a) / (k(k - 1)), which are the
+  // integrated Legendre polynomials along the edge and vanish on the other two edges
+  static constexpr int edgeA[3] = { 0, 1, 0 };
+  static constexpr int edgeB[3] = { 1, 2, 2 };
+  real P[MaxPolynomialOrder2D + 1];
+  real dP[MaxPolynomialOrder2D + 1];
+  real d2P[MaxPolynomialOrder2D + 1];
+  for (int e = 0; e < 3; ++e)
+  {
+    const int& a = edgeA[e];
+    const int& b = edgeB[e];
+    const real s = lambda[b] - lambda[a];
+    const real ds = grad[b][c] - grad[a][c];
+    const real q = lambda[a] * lambda[b];
+    const real dq = grad[a][c] * lambda[b] + lambda[a] * grad[b][c];
+    evaluateLegendre(p - 1, s, P, dP, d2P);
+
+    for (int k = 2; k <= p; ++k)
+    {
+      const real scale = 4.0 / (k * (k - 1));
+      values[3 + e * (p - 1) + k - 2] = result(q, dq, scale * dP[k - 1], scale * d2P[k - 1] * ds);
+    }
+  }
+  if (p < 3)
+    return;
+
+  // Bubble modes are lambda_0 * lambda_1 * lambda_2 * P_{i-1}(lambda_1 - lambda_0) * P_{j-1}(2lambda_2 - 1)
+  // for i, j >= 1 and i + j <= p - 1, ordered by their degree i + j + 1 and then by j
+  real Q[MaxPolynomialOrder2D + 1];
+  real dQ[MaxPolynomialOrder2D + 1];
+  evaluateLegendre(p - 3, lambda[1] - lambda[0], P, dP, d2P);
+  evaluateLegendre(p - 3, 2 * lambda[2] - 1, Q, dQ, d2P);
+  const real du = grad[1][c] - grad[0][c];
+  const real dv = 2 * grad[2][c];
+  const real bubble = lambda[0] * lambda[1] * lambda[2];
+  const real dBubble = grad[0][c] * lambda[1] * lambda[2] + lambda[0] * grad[1][c] * lambda[2] + lambda[0] * lambda[1] * grad[2][c];
+
+  int j = 3 * p;
+  for (int d = 2; d <= p - 1; ++d)
+    for (int n = 1; n < d; ++n)
+    {
+      const int m = d - n;
+      const real f = P[m - 1] * Q[n - 1];
+      const real df = dP[m - 1] * du * Q[n - 1] + P[m - 1] * dQ[n - 1] * dv;
+      values[j] = result(bubble, dBubble, f, df);
+      ++j;
+    }
+}
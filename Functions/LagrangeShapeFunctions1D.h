@@ -4,7 +4,7 @@
 
 /*
   Calculates a 1D Lagrange shape function for an element K 
-  using equally spaced local nodes.
+  using the local FE nodes of K (see NodeDistribution1D).
 
   \param element: The index of an element within fem.
   \param node: The index of a node within the given element.
@@ -13,7 +13,7 @@ real lagrangeShapeFunction1D(const real x, const FEM1D& fem, const int element,
 
 /*
   Recursively calculates the nth derivative of the j-th Lagrange
-  basis polynomial for p + 1 equally spaced local nodes on [-1, 1].
+  basis polynomial for p + 1 local nodes on [-1, 1].
   Formula found here: https://en.wikipedia.org/wiki/Lagrange_polynomial#Derivatives
 
   \param t: The result when x is mapped onto [-1, 1].
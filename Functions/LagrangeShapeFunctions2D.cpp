@@ -14,9 +14,182 @@ real refLagrangePolynomial2D(const real tx, const real ty,
   case 2:
     return refDegree2LagrangePolynomial2D(tx, ty, j, xDerivativeOrder, yDerivativeOrder);
   default:
+  {
+    ASSERT(j >= 0 && j < numLocalNodes2D(polynomialOrder), "Shape index must be less than the number of shape functions");
+
+    real values[numLocalNodes2D(MaxPolynomialOrder2D)];
+    RefLagrangeBasis2D<DynamicOrder>::evaluate(polynomialOrder, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+    return values[j];
+  }
+  }
+}
+
+/*
+  \returns the index of the product P_a(2tx - 1) * P_b(2ty - 1) of Legendre polynomials
+  in the ordering (a, b) = (0, 0), (1, 0), (0, 1), (2, 0), (1, 1), (0, 2), ...
+*/
+static constexpr int productIndex2D(const int a, const int b)
+{
+  return (a + b) * (a + b + 1) / 2 + b;
+}
+
+/*
+  Evaluates the derivative of the given order of the Legendre polynomials
+  P_0, ..., P_n at t in [0, 1], shifted from [-1, 1] through 2t - 1.
+*/
+static void evaluateShiftedLegendre(const int n, const real t, const int derivativeOrder, real* values)
+{
+  const real u = 2 * t - 1;
+
+  // Differentiating (k + 1) P_{k+1} = (2k + 1) u P_k - k P_{k-1} d times gives
+  // (k + 1) P_{k+1}^(d) = (2k + 1) (u P_k^(d) + d P_k^(d-1)) - k P_{k-1}^(d)
+  real previous[MaxPolynomialOrder2D + 1];
+  for (int k = 0; k <= n; ++k)
+    previous[k] = 0.0;
+  for (int d = 0; d <= derivativeOrder; ++d)
+  {
+    values[0] = d == 0 ? 1.0 : 0.0;
+    if (n > 0)
+      values[1] = d == 0 ? u : (d == 1 ? 1.0 : 0.0);
+    for (int k = 1; k < n; ++k)
+      values[k + 1] = ((2 * k + 1) * (u * values[k] + d * previous[k]) - k * values[k - 1]) / (k + 1);
+    if (d < derivativeOrder)
+      for (int k = 0; k <= n; ++k)
+        previous[k] = values[k];
+  }
+
+  // Chain rule through the shift
+  const real scale = pow(2.0, derivativeOrder);
+  for (int k = 0; k <= n; ++k)
+    values[k] *= scale;
+}
+
+/*
+  Evaluates the derivatives of the products P_a(2tx - 1) * P_b(2ty - 1), a + b <= polynomialOrder,
+  which span the polynomials of that order.  Unlike plain monomials, they keep the
+  Vandermonde matrix of the reference nodes well conditioned at high order.
+*/
+static void evaluateLegendreProducts2D(const int polynomialOrder, const real tx, const real ty,
+                                       const int xDerivativeOrder, const int yDerivativeOrder,
+                                       real* values)
+{
+  real xValues[MaxPolynomialOrder2D + 1];
+  real yValues[MaxPolynomialOrder2D + 1];
+  evaluateShiftedLegendre(polynomialOrder, tx, xDerivativeOrder, xValues);
+  evaluateShiftedLegendre(polynomialOrder, ty, yDerivativeOrder, yValues);
+
+  for (int d = 0; d <= polynomialOrder; ++d)
+    for (int b = 0; b <= d; ++b)
+      values[productIndex2D(d - b, b)] = xValues[d - b] * yValues[b];
+}
+
+/*
+  Coefficients of the Lagrange shape functions of one polynomial order in the basis of
+  evaluateLegendreProducts2D, coefficients[m * numShapes + j] being that of product m
+  in shape function j.
+*/
+struct RefLagrangeCoefficients2D
+{
+  int numShapes;
+  std::vector<real> coefficients;
+};
+
+/*
+  Inverts the Vandermonde matrix V[i][m] = (product m at node i) of the reference nodes.
+*/
+static std::unique_ptr<RefLagrangeCoefficients2D> computeRefLagrangeCoefficients2D(const int polynomialOrder)
+{
+  const std::vector<std::array<real, 2>> nodes = refLagrangeNodes2D(polynomialOrder);
+  const int n = (int)nodes.size();
+
+  Matrix V = Matrix(n);
+  for (int i = 0; i < n; ++i)
+    evaluateLegendreProducts2D(polynomialOrder, nodes[i][0], nodes[i][1], 0, 0, V[i]);
+  const Matrix Vinv = inverse(V);
+
+  // Shape function j takes the value 1 at node j, so its coefficients are column j of the inverse
+  std::unique_ptr<RefLagrangeCoefficients2D> table = std::make_unique<RefLagrangeCoefficients2D>();
+  table->numShapes = n;
+  table->coefficients.resize(n * n);
+  for (int m = 0; m < n; ++m)
+    for (int j = 0; j < n; ++j)
+      table->coefficients[m * n + j] = Vinv[m][j];
+  return table;
+}
+
+/*
+  \returns the coefficients of the shape functions of the given order, computing them on first use.
+*/
+static const RefLagrangeCoefficients2D& refLagrangeCoefficients2D(const int polynomialOrder)
+{
+  static std::atomic<const RefLagrangeCoefficients2D*> tables[MaxPolynomialOrder2D + 1] = {};
+  static std::unique_ptr<RefLagrangeCoefficients2D> ownedTables[MaxPolynomialOrder2D + 1];
+  static std::mutex mutex;
+
+  // Debug
+  ASSERT(polynomialOrder > 0, "Polynomial order must be positive");
+
+  if (polynomialOrder > MaxPolynomialOrder2D)
     LOG("Polynomial order not supported", LogLevel::Error);
-    return NAN;
+
+  const RefLagrangeCoefficients2D* table = tables[polynomialOrder].load(std::memory_order_acquire);
+  if (table == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ownedTables[polynomialOrder])
+    {
+      ownedTables[polynomialOrder] = computeRefLagrangeCoefficients2D(polynomialOrder);
+      tables[polynomialOrder].store(ownedTables[polynomialOrder].get(), std::memory_order_release);
+    }
+    table = ownedTables[polynomialOrder].get();
   }
+  return *table;
+}
+
+std::vector<std::array<real, 2>> refLagrangeNodes2D(const int polynomialOrder)
+{
+  const int& p = polynomialOrder;
+
+  // Debug
+  ASSERT(p > 0, "Polynomial order must be positive");
+
+  const std::array<real, 2> vertices[3] = { { 0.0, 0.0 }, { 1.0, 0.0 }, { 0.0, 1.0 } };
+  const int edges[3][2] = { { 0, 1 }, { 1, 2 }, { 0, 2 } };
+
+  std::vector<std::array<real, 2>> nodes = std::vector<std::array<real, 2>>(vertices, vertices + 3);
+  for (int e = 0; e < 3; ++e)
+    for (int l = 0; l < p - 1; ++l)
+    {
+      const real t = (l + 1.0) / p;
+      const std::array<real, 2>& A1 = vertices[edges[e][0]];
+      const std::array<real, 2>& A2 = vertices[edges[e][1]];
+      nodes.push_back({ (1.0 - t) * A1[0] + t * A2[0], (1.0 - t) * A1[1] + t * A2[1] });
+    }
+  for (int i = 0; i < p - 2; ++i)
+    for (int j = 0; j < p - 2 - i; ++j)
+      nodes.push_back({ (i + 1.0) / p, (j + 1.0) / p });
+  return nodes;
+}
+
+void evaluateRefLagrangeBasis2D(const int polynomialOrder, const real tx, const real ty,
+                                const int xDerivativeOrder, const int yDerivativeOrder,
+                                real* values)
+{
+  const RefLagrangeCoefficients2D& table = refLagrangeCoefficients2D(polynomialOrder);
+  const int& n = table.numShapes;
+
+  real products[numLocalNodes2D(MaxPolynomialOrder2D)];
+  evaluateLegendreProducts2D(polynomialOrder, tx, ty, xDerivativeOrder, yDerivativeOrder, products);
+
+  for (int j = 0; j < n; ++j)
+    values[j] = 0.0;
+  for (int m = 0; m < n; ++m)
+    if (products[m] != 0.0)
+    {
+      const real* row = &table.coefficients[m * n];
+      for (int j = 0; j < n; ++j)
+        values[j] += products[m] * row[j];
+    }
 }
 
 real refDegree1LagrangePolynomial2D(const real tx, const real ty,
@@ -233,7 +406,7 @@ void plotRefLagrangePolynomial(const int degree, const int shapeIndex, const int
         f = refDegree2LagrangePolynomial2D(x, y, shapeIndex, xDerivativeOrder, yDerivativeOder);
         break;
       default:
-        LOG("Polynomial degree not implemented", LogLevel::Error);
+        f = refLagrangePolynomial2D(x, y, degree, shapeIndex, xDerivativeOrder, yDerivativeOder);
       }
 
       file << x << ", " << y << ", " << f << std::endl;
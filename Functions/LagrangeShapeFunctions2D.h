@@ -1,41 +1,9 @@
 #pragma once
 #include "Precompilied.h"
+#include "ReferenceBasis2D.h"
 #include "Meshing/2D/FEM2D.h"
 #include "LinearAlgebra/Matrix.h"
 
-/*
-  Calculates a p-th degree Lagrange polynomial on the
-  reference triangle [(0, 0), (0, 1), (1, 0)].
-
-  \param tx: Result when x is mapped onto reference domain
-  \param ty: Result when y is mapped onto reference domain
-*/
-real refLagrangePolynomial2D(const real tx, const real ty,
-                             const int polynomialOrder, const int shapeIndex,
-                             const int xDerivativeOrder, const int yDerivativeOrder);
-
-/*
-  Calculates a first degree Lagrange polynomial on the
-  reference triangle [(0, 0), (0, 1), (1, 0)].
-
-  \param tx: Result when x is mapped onto reference domain
-  \param ty: Result when y is mapped onto reference domain
-*/
-real refDegree1LagrangePolynomial2D(const real tx, const real ty, 
-                                    const int shapeIndex,
-                                    const int xDerivativeOrder, const int yDerivativeOrder);
-
-/*
-  Calculates a first degree Lagrange polynomial on the
-  reference triangle [(0, 0), (0, 1), (1, 0)].
-
-  \param tx: Result when x is mapped onto reference domain
-  \param ty: Result when y is mapped onto reference domain
-*/
-real refDegree2LagrangePolynomial2D(const real tx, const real ty,
-                                    const int shapeIndex,
-                                    const int xDerivativeOrder, const int yDerivativeOrder);
-
 void plotRefLagrangePolynomial(const int degree, const int shapeIndex, const int xDerivativeOrder, const int yDerivativeOder, const int n);
 
 template<int N>
@@ -75,17 +43,28 @@ real lagrangeShapeFunction2D(const real x, const real y,
   const real ty = B[1][0] * (x - A1.x) + B[1][1] * (y - A1.y);
   ASSERT(tx > -1.0 * TOLERANCE && ty > -1.0 * TOLERANCE && ty < 1.0 - tx + TOLERANCE, "(tx, ty) is not inside the reference domain");
 
+  // Shape function on the reference domain, in the basis of fem
+  const auto refShapeFunction = [&](const int txDerivativeOrder, const int tyDerivativeOrder)
+  {
+    if (fem.basisType == BasisType::Lagrange)
+      return refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, txDerivativeOrder, tyDerivativeOrder);
+
+    real values[numLocalNodes2D(MaxPolynomialOrder2D)];
+    evaluateRefHierarchicalBasis2D(fem.polynomialOrder, tx, ty, txDerivativeOrder, tyDerivativeOrder, values);
+    return fem.shapeSign(K, j) * values[j];
+  };
+
   if (xDerivativeOrder == 0 && yDerivativeOrder == 0)
-    return refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, 0, 0);
+    return refShapeFunction(0, 0);
   else if (xDerivativeOrder == 1 && yDerivativeOrder == 0)
   {
-    return B[0][0] * refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, 1, 0)
-      + B[1][0] * refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, 0, 1);
+    return B[0][0] * refShapeFunction(1, 0)
+      + B[1][0] * refShapeFunction(0, 1);
   }
   else if (xDerivativeOrder == 0 && yDerivativeOrder == 1)
   {
-    return B[0][1] * refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, 1, 0)
-      + B[1][1] * refLagrangePolynomial2D(tx, ty, fem.polynomialOrder, j, 0, 1);
+    return B[0][1] * refShapeFunction(1, 0)
+      + B[1][1] * refShapeFunction(0, 1);
   }
   else
   {
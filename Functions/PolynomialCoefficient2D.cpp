@@ -0,0 +1,194 @@
+#include "Precompilied.h"
+#include "PolynomialCoefficient2D.h"
+#include "ReferenceBasis2D.h"
+#include "Gauss-LegendreNodes.h"
+
+using Polynomial2D = std::array<real, PolynomialCoefficient2D::MaxMonomials>;
+
+/*
+  Multiplies a polynomial of degree outDegree - 1 with the polynomial
+  linear[0] + linear[1] * tx + linear[2] * ty.
+*/
+static void multiplyByLinear(const Polynomial2D& polynomial, const real (&linear)[3], const int outDegree, Polynomial2D& product)
+{
+  product.fill(0.0);
+  for (int d = 0; d <= outDegree; ++d)
+    for (int q = 0; q <= d; ++q)
+    {
+      const int p = d - q;
+      real& entry = product[PolynomialCoefficient2D::monomialIndex(p, q)];
+      if (d < outDegree)
+        entry += linear[0] * polynomial[PolynomialCoefficient2D::monomialIndex(p, q)];
+      if (p > 0)
+        entry += linear[1] * polynomial[PolynomialCoefficient2D::monomialIndex(p - 1, q)];
+      if (q > 0)
+        entry += linear[2] * polynomial[PolynomialCoefficient2D::monomialIndex(p, q - 1)];
+    }
+}
+
+PolynomialCoefficient2D::PolynomialCoefficient2D(const int polynomialDegree, const std::vector<real>& monomialCoefficients)
+  : degree(polynomialDegree),
+    numMonomials((polynomialDegree + 1) * (polynomialDegree + 2) / 2)
+{
+  // Debug
+  ASSERT(degree >= 0, "Polynomial degree must be non-negative");
+  ASSERT((int)monomialCoefficients.size() == numMonomials, "Polynomial must have one coefficient per monomial");
+
+  if (degree > MaxDegree)
+    LOG("Polynomial degree not supported", LogLevel::Error);
+  std::copy(monomialCoefficients.begin(), monomialCoefficients.end(), coefficients.begin());
+}
+
+void PolynomialCoefficient2D::evaluate(const std::array<real, 2>* points, const int numPoints, real* values) const
+{
+  real powersOfX[MaxDegree + 1];
+  real powersOfY[MaxDegree + 1];
+  for (int k = 0; k < numPoints; ++k)
+  {
+    powersOfX[0] = 1.0;
+    powersOfY[0] = 1.0;
+    for (int d = 1; d <= degree; ++d)
+    {
+      powersOfX[d] = powersOfX[d - 1] * points[k][0];
+      powersOfY[d] = powersOfY[d - 1] * points[k][1];
+    }
+
+    real value = 0.0;
+    for (int d = 0; d <= degree; ++d)
+      for (int q = 0; q <= d; ++q)
+        value += coefficients[monomialIndex(d - q, q)] * powersOfX[d - q] * powersOfY[q];
+    values[k] = value;
+  }
+}
+
+void PolynomialCoefficient2D::referenceCoefficients(const ElementGeometry2D& geometry, real* alpha) const
+{
+  // x and y on the element as polynomials of degree one in (tx, ty)
+  const real X[3] = { geometry.x0, geometry.B[0][0], geometry.B[0][1] };
+  const real Y[3] = { geometry.y0, geometry.B[1][0], geometry.B[1][1] };
+
+  Polynomial2D powersOfY[MaxDegree + 1];
+  powersOfY[0].fill(0.0);
+  powersOfY[0][0] = 1.0;
+  for (int q = 1; q <= degree; ++q)
+    multiplyByLinear(powersOfY[q - 1], Y, q, powersOfY[q]);
+
+  // Horner's scheme in x, the coefficient of x^p being a polynomial in y of degree at most degree - p
+  Polynomial2D result;
+  Polynomial2D product;
+  result.fill(0.0);
+  for (int p = degree; p >= 0; --p)
+  {
+    if (p < degree)
+    {
+      multiplyByLinear(result, X, degree - p, product);
+      result = product;
+    }
+    for (int q = 0; q <= degree - p; ++q)
+    {
+      const real& c = coefficients[monomialIndex(p, q)];
+      for (int m = 0; m < numMonomials; ++m)
+        result[m] += c * powersOfY[q][m];
+    }
+  }
+
+  for (int m = 0; m < numMonomials; ++m)
+    alpha[m] = result[m];
+}
+
+RefMomentTable2D::RefMomentTable2D(const int polynomialOrder1, const int polynomialOrder2, const int polynomialDegree,
+                                   const int xDerivativeOrder1, const int yDerivativeOrder1,
+                                   const int xDerivativeOrder2, const int yDerivativeOrder2,
+                                   const BasisType basisType1, const BasisType basisType2)
+  : numMonomials((polynomialDegree + 1) * (polynomialDegree + 2) / 2),
+    numShapes1(numLocalNodes2D(polynomialOrder1)),
+    numShapes2(polynomialOrder2 > 0 ? numLocalNodes2D(polynomialOrder2) : 1),
+    numTypes1(xDerivativeOrder1 + yDerivativeOrder1 > 0 ? 2 : 1),
+    numTypes2(xDerivativeOrder2 + yDerivativeOrder2 > 0 ? 2 : 1),
+    derivativeIndex1(yDerivativeOrder1),
+    derivativeIndex2(yDerivativeOrder2)
+{
+  // Debug
+  ASSERT(xDerivativeOrder1 + yDerivativeOrder1 <= 1 && xDerivativeOrder2 + yDerivativeOrder2 <= 1, "Derivative order not implemented");
+  ASSERT(polynomialOrder2 > 0 || numTypes2 == 1, "Cannot take the derivative of a constant");
+
+  const int numNodes = gauss2DNumNodes(polynomialDegree + polynomialOrder1 + polynomialOrder2);
+  const std::vector<std::array<real, 2>>& nodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& weights = gauss2DWeightsRef(numNodes);
+
+  // Values or derivatives in tx and ty of the shape functions at a node
+  std::vector<real> psi1 = std::vector<real>(numTypes1 * numShapes1);
+  std::vector<real> psi2 = std::vector<real>(numTypes2 * numShapes2, 1.0);
+  std::vector<real> monomials = std::vector<real>(numMonomials);
+
+  const int n = numShapes1 * numShapes2;
+  moments = std::vector<real>(numMonomials * numTypes1 * numTypes2 * n, 0.0);
+  for (int k = 0; k < (int)nodes.size(); ++k)
+  {
+    const real& tx = nodes[k][0];
+    const real& ty = nodes[k][1];
+    for (int a = 0; a < numTypes1; ++a)
+      evaluateRefBasis2D<DynamicOrder>(basisType1, polynomialOrder1, tx, ty, numTypes1 == 1 ? 0 : 1 - a, numTypes1 == 1 ? 0 : a, &psi1[a * numShapes1]);
+    if (polynomialOrder2 > 0)
+      for (int b = 0; b < numTypes2; ++b)
+        evaluateRefBasis2D<DynamicOrder>(basisType2, polynomialOrder2, tx, ty, numTypes2 == 1 ? 0 : 1 - b, numTypes2 == 1 ? 0 : b, &psi2[b * numShapes2]);
+    for (int d = 0; d <= polynomialDegree; ++d)
+      for (int q = 0; q <= d; ++q)
+        monomials[PolynomialCoefficient2D::monomialIndex(d - q, q)] = pow(tx, d - q) * pow(ty, q);
+
+    for (int m = 0; m < numMonomials; ++m)
+      for (int a = 0; a < numTypes1; ++a)
+        for (int b = 0; b < numTypes2; ++b)
+        {
+          real* moment = &moments[((m * numTypes1 + a) * numTypes2 + b) * n];
+          for (int i = 0; i < numShapes1; ++i)
+          {
+            const real wi = weights[k] * monomials[m] * psi1[a * numShapes1 + i];
+            for (int j = 0; j < numShapes2; ++j)
+              moment[i * numShapes2 + j] += wi * psi2[b * numShapes2 + j];
+          }
+        }
+  }
+}
+
+int RefMomentTable2D::mappedSize() const
+{
+  return numMonomials * numShapes1 * numShapes2;
+}
+
+void RefMomentTable2D::mapToElement(const ElementGeometry2D& geometry, real* mapped) const
+{
+  // Chain rule through inverse of affine map
+  const real g1[2] = { numTypes1 == 1 ? 1.0 : geometry.Binv[0][derivativeIndex1], geometry.Binv[1][derivativeIndex1] };
+  const real g2[2] = { numTypes2 == 1 ? 1.0 : geometry.Binv[0][derivativeIndex2], geometry.Binv[1][derivativeIndex2] };
+
+  const int n = numShapes1 * numShapes2;
+  for (int m = 0; m < numMonomials; ++m)
+  {
+    real* result = mapped + m * n;
+    for (int ij = 0; ij < n; ++ij)
+      result[ij] = 0.0;
+    for (int a = 0; a < numTypes1; ++a)
+      for (int b = 0; b < numTypes2; ++b)
+      {
+        const real g = g1[a] * g2[b];
+        const real* moment = &moments[((m * numTypes1 + a) * numTypes2 + b) * n];
+        for (int ij = 0; ij < n; ++ij)
+          result[ij] += g * moment[ij];
+      }
+  }
+}
+
+void RefMomentTable2D::contract(const real* mapped, const real* alpha, const real scale, real* local) const
+{
+  const int n = numShapes1 * numShapes2;
+  for (int ij = 0; ij < n; ++ij)
+    local[ij] = 0.0;
+  for (int m = 0; m < numMonomials; ++m)
+  {
+    const real c = scale * alpha[m];
+    const real* moment = mapped + m * n;
+    for (int ij = 0; ij < n; ++ij)
+      local[ij] += c * moment[ij];
+  }
+}
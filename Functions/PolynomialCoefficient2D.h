@@ -0,0 +1,117 @@
+#pragma once
+#include "Precompilied.h"
+#include "Coefficients.h"
+#include "ReferenceBasis2D.h"
+#include "Meshing/2D/Mesh2D.h"
+
+/*
+  A coefficient that is a polynomial in x and y,
+
+    a(x, y) = sum over p + q <= degree of c_pq * x^p * y^q,
+
+  with the coefficients c_pq ordered by total degree and then by the power
+  of y: 1, x, y, x^2, xy, y^2, x^3, ...  For example, 1 + x*y is
+  PolynomialCoefficient2D(2, { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 }).
+
+  Since elements are affine images of the reference triangle, the coefficient
+  is a polynomial of the same degree in the reference coordinates of each
+  element.  Assembly integrates it exactly against the shape functions by
+  contracting these reference coefficients with the moments of the shape
+  functions (see RefMomentTable2D), without any quadrature.
+*/
+struct PolynomialCoefficient2D : public BatchCoefficient2D
+{
+  static constexpr int MaxDegree = 4;
+  static constexpr int MaxMonomials = (MaxDegree + 1) * (MaxDegree + 2) / 2;
+
+  int degree;
+  int numMonomials;
+  std::array<real, MaxMonomials> coefficients{};
+
+  PolynomialCoefficient2D() = delete;
+
+  PolynomialCoefficient2D(const int polynomialDegree, const std::vector<real>& monomialCoefficients);
+
+  /*
+    \returns the position of x^p * y^q in the list of coefficients.
+  */
+  static constexpr int monomialIndex(const int p, const int q)
+  {
+    return (p + q) * (p + q + 1) / 2 + q;
+  }
+
+  void evaluate(const std::array<real, 2>* points, const int numPoints, real* values) const;
+
+  /*
+    Writes the coefficients of the polynomial as a polynomial in the
+    reference coordinates (tx, ty) of an element into alpha, in the same
+    order as the coefficients in (x, y).  alpha must hold numMonomials entries.
+  */
+  void referenceCoefficients(const ElementGeometry2D& geometry, real* alpha) const;
+};
+
+/*
+  \returns the degree of a polynomial coefficient, see coefficientDegree2D in Coefficients.h.
+*/
+inline int coefficientDegree2D(const PolynomialCoefficient2D& a)
+{
+  return a.degree;
+}
+
+/*
+  Moments of the products of two sets of shape functions with the monomials
+  of a polynomial on the reference triangle,
+
+    integral of tx^p * ty^q * psi1_i * psi2_j,
+
+  where psi1 and psi2 are the shape functions of the given orders and basis
+  types, or their first derivatives.  An order of 0 for the second set stands for the
+  constant 1, which gives the moments needed for load vectors.
+
+  The moments are computed exactly, with a quadrature rule of sufficient
+  degree, once per assembly.  Mapping them onto an element takes care of the
+  chain rule for derivatives and only depends on the matrix B of the
+  element, so congruent elements can share their mapped moments.
+*/
+class RefMomentTable2D
+{
+public:
+  const int numMonomials;
+  const int numShapes1;
+  const int numShapes2;
+
+  RefMomentTable2D() = delete;
+
+  RefMomentTable2D(const int polynomialOrder1, const int polynomialOrder2, const int polynomialDegree,
+                   const int xDerivativeOrder1, const int yDerivativeOrder1,
+                   const int xDerivativeOrder2, const int yDerivativeOrder2,
+                   const BasisType basisType1 = BasisType::Lagrange, const BasisType basisType2 = BasisType::Lagrange);
+
+  /*
+    \returns the number of entries of the mapped moments of an element.
+  */
+  int mappedSize() const;
+
+  /*
+    Writes the moments of the derivatives of the shape functions on an element,
+    pulled back to the reference triangle, into mapped, which must hold mappedSize() entries.
+  */
+  void mapToElement(const ElementGeometry2D& geometry, real* mapped) const;
+
+  /*
+    Computes the numShapes1 x numShapes2 local matrix
+
+      local[i][j] = scale * sum_m alpha[m] * mapped[m][i][j],
+
+    which is the exact element integral for a polynomial with reference
+    coefficients alpha, when scale is the absolute value of the determinant of B.
+  */
+  void contract(const real* mapped, const real* alpha, const real scale, real* local) const;
+
+private:
+  int numTypes1;             // 1 if no derivative is taken of the first set of shape functions, 2 otherwise
+  int numTypes2;
+  int derivativeIndex1;      // Index of the variable of the derivative, 0 for x and 1 for y
+  int derivativeIndex2;
+  std::vector<real> moments; // moments[m][a][b][i][j], a and b select the value or the derivative in tx or ty
+};
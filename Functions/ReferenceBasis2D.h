@@ -0,0 +1,411 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Polynomial order used for kernels whose order is only known at runtime.
+*/
+constexpr int DynamicOrder = 0;
+
+/*
+  \returns the number of nodes (and shape functions) on a
+  triangular element of the given polynomial order.
+*/
+constexpr int numLocalNodes2D(const int polynomialOrder)
+{
+  return (polynomialOrder + 1) * (polynomialOrder + 2) / 2;
+}
+
+/*
+  Highest polynomial order of the Lagrange elements on triangles.
+*/
+constexpr int MaxPolynomialOrder2D = 8;
+
+/*
+  \returns the nodes of a triangular element of the given polynomial order on
+  the reference triangle [(0, 0), (1, 0), (0, 1)], in the local numbering of FEM2D:
+  the three vertices, then the p - 1 equally spaced nodes on each of the edges
+  (0, 1), (1, 2) and (0, 2), running from the first vertex to the second, and
+  finally the interior nodes (i / p, j / p), by i and then by j.
+*/
+std::vector<std::array<real, 2>> refLagrangeNodes2D(const int polynomialOrder);
+
+/*
+  Evaluates all Lagrange shape functions of any order up to MaxPolynomialOrder2D
+  at (tx, ty) and stores them in values.
+
+  The shape functions are expanded in products of Legendre polynomials in tx and ty,
+  with coefficients found by inverting the Vandermonde matrix of the nodes in
+  refLagrangeNodes2D.  The inversion is done once per order, on first use.
+*/
+void evaluateRefLagrangeBasis2D(const int polynomialOrder, const real tx, const real ty,
+                                const int xDerivativeOrder, const int yDerivativeOrder,
+                                real* values);
+
+/*
+  Shape functions spanning the polynomials of a given order on each element.
+
+  The coefficients of Lagrange shape functions are the values at the FE nodes.
+  Hierarchical shape functions (see evaluateRefHierarchicalBasis2D) are instead
+  nested: those of a lower order are a subset of those of a higher order.
+*/
+enum class BasisType
+{
+  Lagrange,
+  Hierarchical
+};
+
+/*
+  Evaluates all hierarchical shape functions of any order up to MaxPolynomialOrder2D
+  at (tx, ty) and stores them in values.  Derivative orders must be at most one in total.
+
+  The shape functions are numbered like the Lagrange ones: the three vertex modes,
+  which are the barycentric coordinates, then the p - 1 modes of order 2, ..., p
+  on each of the edges (0, 1), (1, 2) and (0, 2), built from integrated Legendre
+  polynomials running from the first vertex to the second, and finally the
+  (p - 1)(p - 2) / 2 bubble modes by increasing order.  Edge modes of odd order
+  change sign with the direction of their edge.
+*/
+void evaluateRefHierarchicalBasis2D(const int polynomialOrder, const real tx, const real ty,
+                                    const int xDerivativeOrder, const int yDerivativeOrder,
+                                    real* values);
+
+/*
+  Calculates a p-th degree Lagrange polynomial on the
+  reference triangle [(0, 0), (0, 1), (1, 0)].
+
+  \param tx: Result when x is mapped onto reference domain
+  \param ty: Result when y is mapped onto reference domain
+*/
+real refLagrangePolynomial2D(const real tx, const real ty,
+                             const int polynomialOrder, const int shapeIndex,
+                             const int xDerivativeOrder, const int yDerivativeOrder);
+
+/*
+  Calculates a first degree Lagrange polynomial on the
+  reference triangle [(0, 0), (0, 1), (1, 0)].
+
+  \param tx: Result when x is mapped onto reference domain
+  \param ty: Result when y is mapped onto reference domain
+*/
+real refDegree1LagrangePolynomial2D(const real tx, const real ty, 
+                                    const int shapeIndex,
+                                    const int xDerivativeOrder, const int yDerivativeOrder);
+
+/*
+  Calculates a first degree Lagrange polynomial on the
+  reference triangle [(0, 0), (0, 1), (1, 0)].
+
+  \param tx: Result when x is mapped onto reference domain
+  \param ty: Result when y is mapped onto reference domain
+*/
+real refDegree2LagrangePolynomial2D(const real tx, const real ty,
+                                    const int shapeIndex,
+                                    const int xDerivativeOrder, const int yDerivativeOrder);
+
+
+/*
+  Lagrange shape functions on the reference triangle [(0, 0), (1, 0), (0, 1)]
+  for a polynomial order P known at compile time, numShapes being their number.
+
+  The shape function of the node with barycentric coordinates (i_0, i_1, i_2) / P is
+  F_i_0(phi_0) * F_i_1(phi_1) * F_i_2(phi_2), where phi_0 = 1 - tx - ty, phi_1 = tx,
+  phi_2 = ty and F_i(phi) = (P phi)(P phi - 1)...(P phi - i + 1) / i!, so all of them
+  are found in one pass from the factors F_i.  Orders 1 and 2 have their own kernels,
+  P = DynamicOrder dispatches on the runtime order.
+*/
+template<int P>
+struct RefLagrangeBasis2D
+{
+  static constexpr int numShapes = numLocalNodes2D(P);
+
+  /*
+    Evaluates all shape functions at (tx, ty) and stores them in values.
+  */
+  static void evaluate(const int, const real tx, const real ty,
+                       const int xDerivativeOrder, const int yDerivativeOrder,
+                       real* values)
+  {
+    const int derivativeOrder = xDerivativeOrder + yDerivativeOrder;
+    if (derivativeOrder > 2)
+    {
+      evaluateRefLagrangeBasis2D(P, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+      return;
+    }
+
+    // Barycentric coordinates and their (constant) gradients
+    const real phi[3] = { 1 - tx - ty, tx, ty };
+    const real grad[3][2] = { { -1, -1 }, { 1, 0 }, { 0, 1 } };
+
+    // Factors F_i(phi_a) and their first two derivatives with respect to phi_a
+    real F[3][P + 1];
+    real dF[3][P + 1];
+    real d2F[3][P + 1];
+    for (int a = 0; a < 3; ++a)
+    {
+      F[a][0] = 1;
+      dF[a][0] = 0;
+      d2F[a][0] = 0;
+      for (int i = 1; i <= P; ++i)
+      {
+        const real factor = (P * phi[a] - (i - 1)) / i;
+        const real dFactor = (real)P / i;
+        d2F[a][i] = d2F[a][i - 1] * factor + 2 * dF[a][i - 1] * dFactor;
+        dF[a][i] = dF[a][i - 1] * factor + F[a][i - 1] * dFactor;
+        F[a][i] = F[a][i - 1] * factor;
+      }
+    }
+
+    const int derivative = yDerivativeOrder;
+    if (derivativeOrder == 0)
+      evaluateAtNodes(values, [&](const int i0, const int i1, const int i2)
+      {
+        return F[0][i0] * F[1][i1] * F[2][i2];
+      });
+    else if (derivativeOrder == 1)
+    {
+      const real g0 = grad[0][derivative];
+      const real g1 = grad[1][derivative];
+      const real g2 = grad[2][derivative];
+      evaluateAtNodes(values, [&](const int i0, const int i1, const int i2)
+      {
+        return g0 * dF[0][i0] * F[1][i1] * F[2][i2]
+             + g1 * F[0][i0] * dF[1][i1] * F[2][i2]
+             + g2 * F[0][i0] * F[1][i1] * dF[2][i2];
+      });
+    }
+    else
+    {
+      // Product rule, with a term for each coordinate and each pair of coordinates
+      const int c1 = xDerivativeOrder > 0 ? 0 : 1;
+      const int c2 = yDerivativeOrder > 0 ? 1 : 0;
+      const auto pairFactor = [&](const int a, const int b)
+      {
+        return grad[a][c1] * grad[b][c2] + grad[b][c1] * grad[a][c2];
+      };
+      const real h0 = grad[0][c1] * grad[0][c2];
+      const real h1 = grad[1][c1] * grad[1][c2];
+      const real h2 = grad[2][c1] * grad[2][c2];
+      const real h01 = pairFactor(0, 1);
+      const real h12 = pairFactor(1, 2);
+      const real h02 = pairFactor(0, 2);
+      evaluateAtNodes(values, [&](const int i0, const int i1, const int i2)
+      {
+        return h0 * d2F[0][i0] * F[1][i1] * F[2][i2]
+             + h1 * F[0][i0] * d2F[1][i1] * F[2][i2]
+             + h2 * F[0][i0] * F[1][i1] * d2F[2][i2]
+             + h01 * dF[0][i0] * dF[1][i1] * F[2][i2]
+             + h12 * F[0][i0] * dF[1][i1] * dF[2][i2]
+             + h02 * dF[0][i0] * F[1][i1] * dF[2][i2];
+      });
+    }
+  }
+
+private:
+  /*
+    Stores shapeFunction(i_0, i_1, i_2) of each node in values, in the order of
+    refLagrangeNodes2D: vertices, edges (0, 1), (1, 2) and (0, 2), then interior nodes.
+  */
+  template<typename ShapeFunction>
+  static void evaluateAtNodes(real* values, const ShapeFunction& shapeFunction)
+  {
+    int j = 0;
+    values[j++] = shapeFunction(P, 0, 0);
+    values[j++] = shapeFunction(0, P, 0);
+    values[j++] = shapeFunction(0, 0, P);
+    for (int l = 1; l < P; ++l)
+      values[j++] = shapeFunction(P - l, l, 0);
+    for (int l = 1; l < P; ++l)
+      values[j++] = shapeFunction(0, P - l, l);
+    for (int l = 1; l < P; ++l)
+      values[j++] = shapeFunction(P - l, 0, l);
+    for (int k = 0; k < P - 2; ++k)
+      for (int l = 0; l < P - 2 - k; ++l)
+        values[j++] = shapeFunction(P - 2 - k - l, k + 1, l + 1);
+  }
+};
+
+template<>
+struct RefLagrangeBasis2D<1>
+{
+  static constexpr int numShapes = 3;
+
+  static void evaluate(const int, const real tx, const real ty,
+                       const int xDerivativeOrder, const int yDerivativeOrder,
+                       real* values)
+  {
+    if (xDerivativeOrder == 0 && yDerivativeOrder == 0)
+    {
+      values[0] = 1 - tx - ty;
+      values[1] = tx;
+      values[2] = ty;
+    }
+    else if (xDerivativeOrder == 1 && yDerivativeOrder == 0)
+    {
+      values[0] = -1;
+      values[1] = 1;
+      values[2] = 0;
+    }
+    else if (xDerivativeOrder == 0 && yDerivativeOrder == 1)
+    {
+      values[0] = -1;
+      values[1] = 0;
+      values[2] = 1;
+    }
+    else
+      for (int j = 0; j < numShapes; ++j)
+        values[j] = 0;
+  }
+};
+
+template<>
+struct RefLagrangeBasis2D<2>
+{
+  static constexpr int numShapes = 6;
+
+  static void evaluate(const int, const real tx, const real ty,
+                       const int xDerivativeOrder, const int yDerivativeOrder,
+                       real* values)
+  {
+    // Barycentric coordinates and their (constant) gradients
+    const real phi[3] = { 1 - tx - ty, tx, ty };
+    const real grad[3][2] = { { -1, -1 }, { 1, 0 }, { 0, 1 } };
+
+    // Vertex shape functions are phi_a(2phi_a - 1), edge shape functions are 4phi_a*phi_b
+    static constexpr int edgeA[3] = { 0, 2, 2 };
+    static constexpr int edgeB[3] = { 1, 1, 0 };
+
+    const int derivativeOrder = xDerivativeOrder + yDerivativeOrder;
+    if (derivativeOrder == 0)
+    {
+      for (int a = 0; a < 3; ++a)
+        values[a] = phi[a] * (2 * phi[a] - 1);
+      for (int e = 0; e < 3; ++e)
+        values[3 + e] = 4 * phi[edgeA[e]] * phi[edgeB[e]];
+    }
+    else if (derivativeOrder == 1)
+    {
+      const int c = yDerivativeOrder;
+      for (int a = 0; a < 3; ++a)
+        values[a] = grad[a][c] * (4 * phi[a] - 1);
+      for (int e = 0; e < 3; ++e)
+      {
+        const int& a = edgeA[e];
+        const int& b = edgeB[e];
+        values[3 + e] = 4 * (grad[a][c] * phi[b] + phi[a] * grad[b][c]);
+      }
+    }
+    else if (derivativeOrder == 2)
+    {
+      const int c1 = xDerivativeOrder > 0 ? 0 : 1;
+      const int c2 = yDerivativeOrder > 0 ? 1 : 0;
+      for (int a = 0; a < 3; ++a)
+        values[a] = 4 * grad[a][c1] * grad[a][c2];
+      for (int e = 0; e < 3; ++e)
+      {
+        const int& a = edgeA[e];
+        const int& b = edgeB[e];
+        values[3 + e] = 4 * (grad[a][c1] * grad[b][c2] + grad[a][c2] * grad[b][c1]);
+      }
+    }
+    else
+      for (int j = 0; j < numShapes; ++j)
+        values[j] = 0;
+  }
+};
+
+template<>
+struct RefLagrangeBasis2D<DynamicOrder>
+{
+  static constexpr int numShapes = 0;
+
+  static void evaluate(const int polynomialOrder, const real tx, const real ty,
+                       const int xDerivativeOrder, const int yDerivativeOrder,
+                       real* values)
+  {
+    switch (polynomialOrder)
+    {
+    case 1:
+      RefLagrangeBasis2D<1>::evaluate(1, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+      break;
+    case 2:
+      RefLagrangeBasis2D<2>::evaluate(2, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+      break;
+    case 3:
+      RefLagrangeBasis2D<3>::evaluate(3, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+      break;
+    case 4:
+      RefLagrangeBasis2D<4>::evaluate(4, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+      break;
+    default:
+      evaluateRefLagrangeBasis2D(polynomialOrder, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+    }
+  }
+};
+
+/*
+  Evaluates all shape functions of the given basis type at (tx, ty) and stores them in values.
+  P only selects the Lagrange kernel, hierarchical shape functions are evaluated at runtime order.
+*/
+template<int P>
+void evaluateRefBasis2D(const BasisType basisType, const int polynomialOrder, const real tx, const real ty,
+                        const int xDerivativeOrder, const int yDerivativeOrder,
+                        real* values)
+{
+  if (basisType == BasisType::Hierarchical)
+    evaluateRefHierarchicalBasis2D(polynomialOrder, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+  else
+    RefLagrangeBasis2D<P>::evaluate(polynomialOrder, tx, ty, xDerivativeOrder, yDerivativeOrder, values);
+}
+
+/*
+  Calls kernel with std::integral_constant<int, P>, where P is the given
+  polynomial order if a specialized kernel exists for it and DynamicOrder otherwise.
+
+  Kernels are typically generic lambdas:
+
+    dispatchPolynomialOrder(p, [&](auto order)
+    {
+      constexpr int P = decltype(order)::value;
+      ...
+    });
+*/
+template<typename Kernel>
+decltype(auto) dispatchPolynomialOrder(const int polynomialOrder, Kernel&& kernel)
+{
+  switch (polynomialOrder)
+  {
+  case 1:
+    return kernel(std::integral_constant<int, 1>());
+  case 2:
+    return kernel(std::integral_constant<int, 2>());
+  case 3:
+    return kernel(std::integral_constant<int, 3>());
+  case 4:
+    return kernel(std::integral_constant<int, 4>());
+  default:
+    return kernel(std::integral_constant<int, DynamicOrder>());
+  }
+}
+
+/*
+  Same as dispatchPolynomialOrder, but for kernels involving two FE spaces.
+  Both orders are dispatched to DynamicOrder unless a specialized kernel exists for the pair.
+*/
+template<typename Kernel>
+decltype(auto) dispatchPolynomialOrders(const int polynomialOrder1, const int polynomialOrder2, Kernel&& kernel)
+{
+  if (polynomialOrder1 == 1 && polynomialOrder2 == 1)
+    return kernel(std::integral_constant<int, 1>(), std::integral_constant<int, 1>());
+  else if (polynomialOrder1 == 1 && polynomialOrder2 == 2)
+    return kernel(std::integral_constant<int, 1>(), std::integral_constant<int, 2>());
+  else if (polynomialOrder1 == 2 && polynomialOrder2 == 1)
+    return kernel(std::integral_constant<int, 2>(), std::integral_constant<int, 1>());
+  else if (polynomialOrder1 == 2 && polynomialOrder2 == 2)
+    return kernel(std::integral_constant<int, 2>(), std::integral_constant<int, 2>());
+  else if (polynomialOrder1 == 3 && polynomialOrder2 == 3)
+    return kernel(std::integral_constant<int, 3>(), std::integral_constant<int, 3>());
+  else if (polynomialOrder1 == 4 && polynomialOrder2 == 4)
+    return kernel(std::integral_constant<int, 4>(), std::integral_constant<int, 4>());
+  else
+    return kernel(std::integral_constant<int, DynamicOrder>(), std::integral_constant<int, DynamicOrder>());
+}
\ No newline at end of file
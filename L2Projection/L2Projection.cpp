@@ -1,5 +1,6 @@
 #include "Precompilied.h"
 #include "L2Projection.h"
+#include "Utilities/TaskScheduler.h"
 
 static real identityFunction1D(real x) { return 1.0; }
 static real identityFunction2D(real x, real y) { return 1.0; }
@@ -7,24 +8,35 @@ static real identityFunction2D(real x, real y) { return 1.0; }
 Vector FE_LoadVector1D(const FEM1D& fem, real1DFunction f, const int n_gq, const int derivativeOrder)
 {
   Vector b = Vector(fem.Ng);
-  for (int K = 0; K < fem.meshSize; ++K)
-  {
-    std::vector<real> GLnodes = gauss1DNodesLocal(fem.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss1DWeightsLocal(fem.mesh, K, n_gq);
 
-    for (int j = 0; j < fem.polynomialOrder + 1; ++j)
+  // Elements of one color share no FE nodes, so they are assembled in parallel
+  for (const std::vector<int>& elements : fem.elementColors)
+    parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
     {
-      // Calculate inner product between f and j-th shape function on K
-      real innerProduct = 0.0;
-      for (int i = 0; i < n_gq; ++i)
+      std::vector<real> fValues = std::vector<real>(n_gq);
+      for (int c = begin; c < end; ++c)
       {
-        const real& x = GLnodes[i];
-        const real integrand = f(x) * lagrangeShapeFunction1D(x, fem, K, j, derivativeOrder);
-        innerProduct += GLweights[i] * integrand;
+        const int K = elements[c];
+        std::vector<real> GLnodes = gauss1DNodesLocal(fem.mesh, K, n_gq);
+        std::vector<real> GLweights = gauss1DWeightsLocal(fem.mesh, K, n_gq);
+
+        // Evaluate f at all quadrature nodes of K at once
+        evaluateCoefficient1D(f, GLnodes, fValues);
+
+        for (int j = 0; j < fem.polynomialOrder + 1; ++j)
+        {
+          // Calculate inner product between f and j-th shape function on K
+          real innerProduct = 0.0;
+          for (int i = 0; i < n_gq; ++i)
+          {
+            const real& x = GLnodes[i];
+            const real integrand = fValues[i] * lagrangeShapeFunction1D(x, fem, K, j, derivativeOrder);
+            innerProduct += GLweights[i] * integrand;
+          }
+          b[fem[K][j]] += innerProduct; // Accumulate to b
+        }
       }
-      b[fem[K][j]] += innerProduct; // Accumulate to b
-    }
-  }
+    });
   return b;
 }
 
@@ -36,31 +48,84 @@ Matrix FE_MassMatrix1D(const FEM1D& fem, real1DFunction a, const int n_gq, const
 Matrix FE_MassMatrix1D(const FEM1D& fem, real1DFunction a, const int n_gq, const int derivativeOrder1, const int derivativeOrder2)
 {
   Matrix M = Matrix(fem.Ng);
-  for (int K = 0; K < fem.meshSize; ++K)
-  {
-    std::vector<real> GLnodes = gauss1DNodesLocal(fem.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss1DWeightsLocal(fem.mesh, K, n_gq);
 
-    for (int i = 0; i < fem.polynomialOrder + 1; ++i)
-      for (int j = 0; j < fem.polynomialOrder + 1; ++j)
+  // Elements of one color share no FE nodes, so they are assembled in parallel
+  for (const std::vector<int>& elements : fem.elementColors)
+    parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<real> aValues = std::vector<real>(n_gq);
+      for (int c = begin; c < end; ++c)
       {
-        // Calculate the inner product between the i-th and j-th shape function on K
-        real innerProduct = 0.0;
-        for (int k = 0; k < n_gq; ++k)
-        {
-          const real& x = GLnodes[k];
-          const real integrand = a(x) * lagrangeShapeFunction1D(x, fem, K, i, derivativeOrder1)
-            * lagrangeShapeFunction1D(x, fem, K, j, derivativeOrder2);
-          innerProduct += GLweights[k] * integrand;
-        }
-        M[fem[K][i]][fem[K][j]] += innerProduct; // Accumulate to M
+        const int K = elements[c];
+        std::vector<real> GLnodes = gauss1DNodesLocal(fem.mesh, K, n_gq);
+        std::vector<real> GLweights = gauss1DWeightsLocal(fem.mesh, K, n_gq);
+
+        // Evaluate "a" at all quadrature nodes of K at once
+        evaluateCoefficient1D(a, GLnodes, aValues);
+
+        for (int i = 0; i < fem.polynomialOrder + 1; ++i)
+          for (int j = 0; j < fem.polynomialOrder + 1; ++j)
+          {
+            // Calculate the inner product between the i-th and j-th shape function on K
+            real innerProduct = 0.0;
+            for (int k = 0; k < n_gq; ++k)
+            {
+              const real& x = GLnodes[k];
+              const real integrand = aValues[k] * lagrangeShapeFunction1D(x, fem, K, i, derivativeOrder1)
+                * lagrangeShapeFunction1D(x, fem, K, j, derivativeOrder2);
+              innerProduct += GLweights[k] * integrand;
+            }
+            M[fem[K][i]][fem[K][j]] += innerProduct; // Accumulate to M
+          }
       }
+    });
+  return M;
+}
+
+Vector FE_LumpedMassMatrix1D(const FEM1D& fem, real1DFunction a)
+{
+  const int& p = fem.polynomialOrder;
+
+  // Quadrature weights of the FE nodes on [-1, 1], the integrals of the shape functions
+  std::vector<real> refWeights;
+  if (fem.nodeDistribution == NodeDistribution1D::GaussLobatto)
+    refWeights = gaussLobatto1DWeightsRef(p + 1);
+  else
+  {
+    const int numNodes = gauss1DNumNodes(p);
+    const std::vector<real>& GLnodes = gauss1DNodesRef(numNodes);
+    const std::vector<real>& GLweights = gauss1DWeightsRef(numNodes);
+    const std::vector<real> allRefNodes = refNodes1D(p, fem.nodeDistribution);
+    refWeights.assign(p + 1, 0.0);
+    for (int j = 0; j < p + 1; ++j)
+    {
+      std::vector<real> refNodes = allRefNodes;
+      refNodes.erase(refNodes.begin() + j);
+      for (int k = 0; k < numNodes; ++k)
+        refWeights[j] += GLweights[k] * refLagrangePolynomial1D(GLnodes[k], allRefNodes[j], refNodes, 0);
+    }
+  }
+
+  Vector M = Vector(fem.Ng);
+  for (int K = 0; K < fem.meshSize; ++K)
+  {
+    const real h = fem(K, p).x - fem(K, 0).x;
+    for (int j = 0; j < p + 1; ++j)
+      M[fem[K][j]] += a(fem(K, j).x) * refWeights[j] * h / 2;
   }
   return M;
 }
 
-void L2_Projection1D(FEM1D& fem, real1DFunction f, const int n_gq)
+void L2_Projection1D(FEM1D& fem, real1DFunction f, const int n_gq, const MassLumping lumping)
 {
+  // With the load lumped like the mass matrix, b_i / M_ii = f(x_i)
+  if (lumping != MassLumping::None)
+  {
+    for (int i = 0; i < fem.Ng; ++i)
+      fem.FENodes[i].u = f(fem.FENodes[i].x);
+    return;
+  }
+
   Matrix M = FE_MassMatrix1D(fem, identityFunction1D, n_gq, 0);
   Vector b = FE_LoadVector1D(fem, f, n_gq, 0);
   Vector coefficients = solve(M, b);
@@ -4,6 +4,11 @@
 #include "Functions/Gauss-LegendreNodes.h"
 #include "Functions/LagrangeShapeFunctions1D.h"
 #include "Functions/LagrangeShapeFunctions2D.h"
+#include "Functions/Coefficients.h"
+#include "Functions/ElementCoefficient2D.h"
+#include "Functions/PolynomialCoefficient2D.h"
+#include "Functions/ElementKernels2D.h"
+#include "Utilities/TaskScheduler.h"
 
 /*
   \returns the FE load vector for a function f.
@@ -42,110 +47,162 @@ Matrix FE_MassMatrix1D(const FEM1D& fem, real1DFunction a, const int n_gq, const
 */
 Matrix FE_MassMatrix1D(const FEM1D& fem, real1DFunction a, const int n_gq, const int derivativeOrder1, const int derivativeOrder2);
 
+/*
+  How a mass matrix is lumped into a diagonal one.
+
+  None:            The consistent mass matrix.
+  RowSum:          Each diagonal entry is the sum of its row, the integral of "a"
+                   times the shape function.  On triangles these are only positive
+                   for p = 1, 3 and 5, for p = 2 they vanish at the vertices.
+  DiagonalScaling: The diagonal of each element matrix is scaled so that it sums to
+                   the integral of "a" over the element (Hinton, Rock and Zienkiewicz),
+                   which keeps all entries positive for any order.
+*/
+enum class MassLumping
+{
+  None,
+  RowSum,
+  DiagonalScaling
+};
+
+/*
+  \returns the diagonal of the lumped FE mass matrix for a function "a" using one FEM1D.
+
+  The mass matrix is lumped by quadrature at the FE nodes of each element.  The
+  weights of this quadrature are the integrals of the shape functions, so for
+  constant "a" the diagonal entries are the row sums of the consistent mass matrix
+  (MassLumping::RowSum).
+  With NodeDistribution1D::GaussLobatto, this is the Gauss-Lobatto rule, exact up to
+  degree 2p - 1.  With evenly spaced nodes it is the Newton-Cotes rule, which has
+  negative weights for p >= 8.
+*/
+Vector FE_LumpedMassMatrix1D(const FEM1D& fem, real1DFunction a);
+
 /*
   Performs and L2 projection on FEM1D for a function f.
 
   \param n_gq: Number of Gaussian quadrature nodes.
+  \param lumping: Lumping of the mass matrix (see FE_LumpedMassMatrix1D).  With a
+  lumped mass matrix, the load vector is lumped with the same nodal quadrature,
+  b_i = M_ii f(x_i), so the projection is interpolation at the FE nodes, of the same
+  order of accuracy as the consistent projection, in a single pass instead of a dense
+  solve.  Both lumpings then give the same projection, and n_gq is not used.
 */
-void L2_Projection1D(FEM1D& fem, real1DFunction f, const int n_gq);
+void L2_Projection1D(FEM1D& fem, real1DFunction f, const int n_gq, const MassLumping lumping = MassLumping::None);
 
 
 
 /*
   \returns the FE load vector for a function f.
 
-  \param f: Function in the inner products of the load vector.
-  \param n_gq: Number of Gaussian quadrature nodes.
+  \param f: Function in the inner products of the load vector.  May be any
+  callable of (x, y) or a batch coefficient (see Functions/Coefficients.h).
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
 
   Note: This function does NOT cacluate the derivative of f.
   Must pass in the derivative manually.
 */
-template<int N>
-Vector* FE_LoadVector2D(const FEM2D<N>& fem, real2DFunction f, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
+template<int N, typename Function>
+Vector* FE_LoadVector2D(const FEM2D<N>& fem, const Function& f, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
 {
-  const int& p = fem.polynomialOrder;
+  const int numNodes = gauss2DNumNodes(n_gq, integrandDegree2D(f, fem.polynomialOrder - xDerivativeOrder - yDerivativeOrder, fem.polynomialOrder));
+  const std::vector<std::array<real, 2>>& refNodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& refWeights = gauss2DWeightsRef(numNodes);
 
   Vector* b = new Vector(fem.Ng);
-  for (int K = 0; K < fem.mesh.size; ++K)
+  dispatchPolynomialOrder(fem.polynomialOrder, [&](auto order)
   {
-    std::vector<std::array<real, 2>> GLnodes = gauss2DNodesLocal(fem.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss2DWeightsLocal(fem.mesh, K, n_gq);
+    constexpr int P = decltype(order)::value;
+    const RefBasisTable2D<P> basis = RefBasisTable2D<P>(fem.polynomialOrder, refNodes, fem.basisType);
 
-    for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
-    {
-      // Calculate inner product between f and j-th shape function on K
-      real innerProduct = 0.0;
-      for (int i = 0; i < n_gq; ++i)
-      {
-        const real& x = GLnodes[i][0];
-        const real& y = GLnodes[i][1];
-        const real integrand = f(x, y) * lagrangeShapeFunction2D(x, y, fem, K, j, xDerivativeOrder, yDerivativeOrder);
-        innerProduct += GLweights[i] * integrand;
-      }
-      (*b)[fem[K][j]] += innerProduct; // Accumulate to b
-    }
-  }
-  return b;
-}
-template<int N>
-Vector* FE_LoadVector2D(const FEM2D<N>& fem, std::function<real(real, real)> f, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
-{
-  const int& p = fem.polynomialOrder;
+    // On elements that are congruent to others and on which f is constant,
+    // the load vector is that of their class scaled by f
+    const std::vector<LocalArray<real, RefBasisTable2D<P>::n>> classVectors = congruentElementLoadVectors2D<P>(fem.mesh, basis, refWeights, xDerivativeOrder, yDerivativeOrder);
 
-  Vector* b = new Vector(fem.Ng);
-  for (int K = 0; K < fem.mesh.size; ++K)
-  {
-    std::vector<std::array<real, 2>> GLnodes = gauss2DNodesLocal(fem.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss2DWeightsLocal(fem.mesh, K, n_gq);
+    // Elements are processed in batches of RealPack::width, interleaved lane by lane
+    constexpr int W = RealPack::width;
+    const int n = basis.numShapes;
 
-    for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
-    {
-      // Calculate inner product between f and j-th shape function on K
-      real innerProduct = 0.0;
-      for (int i = 0; i < n_gq; ++i)
+    // Elements of one color share no FE nodes, so they are assembled in parallel
+    for (const std::vector<int>& elements : fem.elementColors)
+      parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
       {
-        const real& x = GLnodes[i][0];
-        const real& y = GLnodes[i][1];
-        const real integrand = f(x, y) * lagrangeShapeFunction2D(x, y, fem, K, j, xDerivativeOrder, yDerivativeOrder);
-        innerProduct += GLweights[i] * integrand;
-      }
-      (*b)[fem[K][j]] += innerProduct; // Accumulate to b
-    }
-  }
+        std::vector<real> phi = std::vector<real>(numNodes * n * W);
+        std::vector<real> weights = std::vector<real>(numNodes * W);
+        std::vector<real> localVectors = std::vector<real>(n * W);
+        std::vector<std::array<real, 2>> GLnodes = std::vector<std::array<real, 2>>(W * numNodes);
+        std::vector<real> fValues = std::vector<real>(W * numNodes);
+        for (int c0 = begin; c0 < end; c0 += W)
+        {
+          const int batchSize = std::min(W, end - c0);
+          const int* batch = &elements[c0];
+          ElementGeometry2D geometries[W];
+          GLnodes.resize(batchSize * numNodes);
+          for (int l = 0; l < batchSize; ++l)
+          {
+            geometries[l] = fem.mesh.elementGeometry(batch[l]);
+            for (int k = 0; k < numNodes; ++k)
+              GLnodes[l * numNodes + k] = geometries[l].toLocal(refNodes[k][0], refNodes[k][1]);
+          }
+
+          // Evaluate f at all quadrature nodes of the batch at once
+          evaluateCoefficientOnElements2D(f, batch, batchSize, GLnodes, fValues);
+
+          // Scale the load vectors of congruent elements with constant f
+          bool computed[W];
+          int numComputed = 0;
+          for (int l = 0; l < batchSize; ++l)
+          {
+            const int c = fem.mesh.congruenceClass(batch[l]);
+            computed[l] = c < 0 || !isConstantOnElement(&fValues[l * numNodes], numNodes);
+            if (computed[l])
+              ++numComputed;
+            else
+              for (int j = 0; j < n; ++j)
+                (*b)[fem[batch[l]][j]] += fem.shapeSign(batch[l], j) * fValues[l * numNodes] * classVectors[c][j]; // Accumulate to b
+          }
+          if (numComputed == 0)
+            continue;
+
+          // Fold in the weights
+          for (int l = 0; l < W; ++l)
+            for (int k = 0; k < numNodes; ++k)
+              weights[k * W + l] = l < batchSize && computed[l] ? fValues[l * numNodes + k] * abs(geometries[l].determinant) * refWeights[k] : 0.0;
+
+          // Calculate inner products between f and the shape functions on each remaining element
+          for (int l = 0; l < batchSize; ++l)
+            if (computed[l])
+              basis.mapToElementInterleaved(geometries[l], xDerivativeOrder, yDerivativeOrder, l, phi.data());
+          elementLoadVectors2D<P>(phi.data(), weights.data(), numNodes, n, localVectors.data());
+
+          for (int l = 0; l < batchSize; ++l)
+            if (computed[l])
+              for (int j = 0; j < n; ++j)
+                (*b)[fem[batch[l]][j]] += fem.shapeSign(batch[l], j) * localVectors[j * W + l]; // Accumulate to b
+        }
+      });
+  });
   return b;
 }
 
 /*
   \returns the FE mass matrix for a function "a" using one FEM2D.
 
-  \param a: Function in the inner products of the mass matrix.
-  \param n_gq: Number of Gaussian quadrature nodes.
+  \param a: Function in the inner products of the mass matrix.  May be any
+  callable of (x, y) or a batch coefficient (see Functions/Coefficients.h).
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
 
   Note: Full matrix representation is inefficient here.
   Better to use sparse matrix representation.
 */
-template<int N>
-Matrix* FE_MassMatrix2D(const FEM2D<N>& fem, real2DFunction a, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
-{
-  return FE_MassMatrix2D(fem, fem, a, n_gq, xDerivativeOrder, yDerivativeOrder, xDerivativeOrder, yDerivativeOrder);
-}
-template<int N>
-Matrix* FE_MassMatrix2D(const FEM2D<N>& fem,
-  real2DFunction a,
-  const int n_gq,
-  const int xDerivativeOrder1, const int yDerivativeOrder1,
-  const int xDerivativeOrder2, const int yDerivativeOrder2)
-{
-  return FE_MassMatrix2D(fem, fem, a, n_gq, xDerivativeOrder1, yDerivativeOrder1, xDerivativeOrder2, yDerivativeOrder2);
-}
-template<int N>
-Matrix* FE_MassMatrix2D(const FEM2D<N>& fem, std::function<real(real, real)> a, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
+template<int N, typename Function>
+Matrix* FE_MassMatrix2D(const FEM2D<N>& fem, const Function& a, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
 {
   return FE_MassMatrix2D(fem, fem, a, n_gq, xDerivativeOrder, yDerivativeOrder, xDerivativeOrder, yDerivativeOrder);
 }
-template<int N>
+template<int N, typename Function>
 Matrix* FE_MassMatrix2D(const FEM2D<N>& fem,
-  std::function<real(real, real)> a,
+  const Function& a,
   const int n_gq,
   const int xDerivativeOrder1, const int yDerivativeOrder1,
   const int xDerivativeOrder2, const int yDerivativeOrder2)
@@ -156,124 +213,395 @@ Matrix* FE_MassMatrix2D(const FEM2D<N>& fem,
 /*
   \returns the FE mass matrix for a function "a" using two FEM2Ds.
 
-  \param a: Function in the inner products of the mass matrix.
-  \param n_gq: Number of Gaussian quadrature nodes.
+  \param a: Function in the inner products of the mass matrix.  May be any
+  callable of (x, y) or a batch coefficient (see Functions/Coefficients.h).
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
 
   Note: Full matrix representation is inefficient here.
   Better to use sparse matrix representation.
 */
-template<int N, int M>
+template<int N, int M, typename Function>
 Matrix* FE_MassMatrix2D(const FEM2D<N>& fem1, const FEM2D<M>& fem2,
-  real2DFunction a,
+  const Function& a,
   const int n_gq,
   const int xDerivativeOrder, const int yDerivativeOrder)
 {
   return FE_MassMatrix2D(fem1, fem2, a, n_gq, xDerivativeOrder, yDerivativeOrder, xDerivativeOrder, yDerivativeOrder);
 }
-template<int N, int M>
+template<int N, int M, typename Function>
 Matrix* FE_MassMatrix2D(const FEM2D<N>& fem1, const FEM2D<M>& fem2,
-  real2DFunction a,
+  const Function& a,
   const int n_gq,
   const int xDerivativeOrder1, const int yDerivativeOrder1,
   const int xDerivativeOrder2, const int yDerivativeOrder2)
 {
   // Debug
-  ASSERT(fem1.mesh.size == fem2.mesh.size, "FEM structures do not share the same mesh");
-  ASSERT(fem1.mesh.numNodes == fem2.mesh.numNodes, "FEM structures do not share the same mesh");
-  ASSERT(fem1.mesh.numEdges == fem2.mesh.numEdges, "FEM structures do not share the same mesh");
+  ASSERT(&fem1.mesh == &fem2.mesh, "FEM structures do not share the same mesh");
 
-  const int& p1 = fem1.polynomialOrder;
-  const int& p2 = fem2.polynomialOrder;
+  const int shapeDegree = fem1.polynomialOrder - xDerivativeOrder1 - yDerivativeOrder1 + fem2.polynomialOrder - xDerivativeOrder2 - yDerivativeOrder2;
+  const int numNodes = gauss2DNumNodes(n_gq, integrandDegree2D(a, shapeDegree, std::max(fem1.polynomialOrder, fem2.polynomialOrder)));
+  const std::vector<std::array<real, 2>>& refNodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& refWeights = gauss2DWeightsRef(numNodes);
 
   Matrix* A = new Matrix(fem1.Ng, fem2.Ng);
-  for (int K = 0; K < fem1.mesh.size; ++K)
+  dispatchPolynomialOrders(fem1.polynomialOrder, fem2.polynomialOrder, [&](auto order1, auto order2)
   {
-    std::vector<std::array<real, 2>> GLnodes = gauss2DNodesLocal(fem1.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss2DWeightsLocal(fem1.mesh, K, n_gq);
-
-    for (int i = 0; i < (p1 + 1) * (p1 + 2) / 2; ++i)
-      for (int j = 0; j < (p2 + 1) * (p2 + 2) / 2; ++j)
+    constexpr int P1 = decltype(order1)::value;
+    constexpr int P2 = decltype(order2)::value;
+    const RefBasisTable2D<P1> basis1 = RefBasisTable2D<P1>(fem1.polynomialOrder, refNodes, fem1.basisType);
+    const RefBasisTable2D<P2> basis2 = RefBasisTable2D<P2>(fem2.polynomialOrder, refNodes, fem2.basisType);
+
+    // On elements that are congruent to others and on which "a" is constant,
+    // the mass matrix is that of their class scaled by "a"
+    const std::vector<LocalMatrix<real, RefBasisTable2D<P1>::n, RefBasisTable2D<P2>::n>> classMatrices =
+      congruentElementMassMatrices2D<P1, P2>(fem1.mesh, basis1, basis2, refWeights, xDerivativeOrder1, yDerivativeOrder1, xDerivativeOrder2, yDerivativeOrder2);
+
+    // Elements are processed in batches of RealPack::width, interleaved lane by lane
+    constexpr int W = RealPack::width;
+    const int n1 = basis1.numShapes;
+    const int n2 = basis2.numShapes;
+
+    // Elements of one color share no FE nodes, so they are assembled in parallel
+    for (const std::vector<int>& elements : fem1.elementColors)
+      parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
       {
-        // Calculate the inner product between the i-th and j-th shape function on K
-        real innerProduct = 0.0;
-        for (int k = 0; k < n_gq; ++k)
+        std::vector<real> phi1 = std::vector<real>(numNodes * n1 * W);
+        std::vector<real> phi2 = std::vector<real>(numNodes * n2 * W);
+        std::vector<real> weights = std::vector<real>(numNodes * W);
+        std::vector<real> localMatrices = std::vector<real>(n1 * n2 * W);
+        std::vector<std::array<real, 2>> GLnodes = std::vector<std::array<real, 2>>(W * numNodes);
+        std::vector<real> aValues = std::vector<real>(W * numNodes);
+        for (int c0 = begin; c0 < end; c0 += W)
         {
-          const real& x = GLnodes[k][0];
-          const real& y = GLnodes[k][1];
-          const real integrand = a(x, y) * lagrangeShapeFunction2D(x, y, fem1, K, i, xDerivativeOrder1, yDerivativeOrder1)
-            * lagrangeShapeFunction2D(x, y, fem2, K, j, xDerivativeOrder2, yDerivativeOrder2);
-          innerProduct += GLweights[k] * integrand;
+          const int batchSize = std::min(W, end - c0);
+          const int* batch = &elements[c0];
+          ElementGeometry2D geometries[W];
+          GLnodes.resize(batchSize * numNodes);
+          for (int l = 0; l < batchSize; ++l)
+          {
+            geometries[l] = fem1.mesh.elementGeometry(batch[l]);
+            for (int k = 0; k < numNodes; ++k)
+              GLnodes[l * numNodes + k] = geometries[l].toLocal(refNodes[k][0], refNodes[k][1]);
+          }
+
+          // Evaluate "a" at all quadrature nodes of the batch at once
+          evaluateCoefficientOnElements2D(a, batch, batchSize, GLnodes, aValues);
+
+          // Scale the mass matrices of congruent elements with constant "a"
+          bool computed[W];
+          int numComputed = 0;
+          for (int l = 0; l < batchSize; ++l)
+          {
+            const int c = fem1.mesh.congruenceClass(batch[l]);
+            computed[l] = c < 0 || !isConstantOnElement(&aValues[l * numNodes], numNodes);
+            if (computed[l])
+              ++numComputed;
+            else
+              for (int i = 0; i < n1; ++i)
+                for (int j = 0; j < n2; ++j)
+                  (*A)[fem1[batch[l]][i]][fem2[batch[l]][j]] += fem1.shapeSign(batch[l], i) * fem2.shapeSign(batch[l], j) * aValues[l * numNodes] * classMatrices[c][i][j]; // Accumulate to M
+          }
+          if (numComputed == 0)
+            continue;
+
+          // Fold in the weights
+          for (int l = 0; l < W; ++l)
+            for (int k = 0; k < numNodes; ++k)
+              weights[k * W + l] = l < batchSize && computed[l] ? aValues[l * numNodes + k] * abs(geometries[l].determinant) * refWeights[k] : 0.0;
+
+          // Calculate the inner products between the shape functions on each remaining element
+          for (int l = 0; l < batchSize; ++l)
+            if (computed[l])
+            {
+              basis1.mapToElementInterleaved(geometries[l], xDerivativeOrder1, yDerivativeOrder1, l, phi1.data());
+              basis2.mapToElementInterleaved(geometries[l], xDerivativeOrder2, yDerivativeOrder2, l, phi2.data());
+            }
+          elementMassMatrices2D<P1, P2>(phi1.data(), phi2.data(), weights.data(), numNodes, n1, n2, localMatrices.data());
+
+          for (int l = 0; l < batchSize; ++l)
+            if (computed[l])
+              for (int i = 0; i < n1; ++i)
+                for (int j = 0; j < n2; ++j)
+                  (*A)[fem1[batch[l]][i]][fem2[batch[l]][j]] += fem1.shapeSign(batch[l], i) * fem2.shapeSign(batch[l], j) * localMatrices[(i * n2 + j) * W + l]; // Accumulate to M
         }
-        (*A)[fem1[K][i]][fem2[K][j]] += innerProduct; // Accumulate to M
-      }
-  }
+      });
+  });
   return A;
 }
-template<int N, int M>
-Matrix* FE_MassMatrix2D(const FEM2D<N>& fem1, const FEM2D<M>& fem2,
-  std::function<real(real, real)> a,
-  const int n_gq,
-  const int xDerivativeOrder, const int yDerivativeOrder)
+
+/*
+  \returns the FE load vector for a polynomial f.
+
+  The inner products are integrated exactly from the moments of the shape
+  functions (see Functions/PolynomialCoefficient2D.h), so n_gq is not used.
+*/
+template<int N>
+Vector* FE_LoadVector2D(const FEM2D<N>& fem, const PolynomialCoefficient2D& f, const int n_gq, const int xDerivativeOrder, const int yDerivativeOrder)
 {
-  return FE_MassMatrix2D(fem1, fem2, a, n_gq, xDerivativeOrder, yDerivativeOrder, xDerivativeOrder, yDerivativeOrder);
+  const RefMomentTable2D moments = RefMomentTable2D(fem.polynomialOrder, 0, f.degree, xDerivativeOrder, yDerivativeOrder, 0, 0, fem.basisType);
+  const int n = moments.numShapes1;
+
+  // Congruent elements share their mapped moments
+  std::vector<std::vector<real>> classMoments = std::vector<std::vector<real>>(fem.mesh.numCongruenceClasses());
+  for (int c = 0; c < (int)classMoments.size(); ++c)
+  {
+    classMoments[c].resize(moments.mappedSize());
+    moments.mapToElement(fem.mesh.elementGeometry(fem.mesh.congruenceClassElement(c)), classMoments[c].data());
+  }
+
+  Vector* b = new Vector(fem.Ng);
+
+  // Elements of one color share no FE nodes, so they are assembled in parallel
+  for (const std::vector<int>& elements : fem.elementColors)
+    parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<real> mapped = std::vector<real>(moments.mappedSize());
+      std::vector<real> alpha = std::vector<real>(f.numMonomials);
+      std::vector<real> localVector = std::vector<real>(n);
+      for (int e = begin; e < end; ++e)
+      {
+        const int K = elements[e];
+        const ElementGeometry2D geometry = fem.mesh.elementGeometry(K);
+        const int c = fem.mesh.congruenceClass(K);
+        if (c < 0)
+          moments.mapToElement(geometry, mapped.data());
+
+        f.referenceCoefficients(geometry, alpha.data());
+        moments.contract(c < 0 ? mapped.data() : classMoments[c].data(), alpha.data(), abs(geometry.determinant), localVector.data());
+
+        for (int j = 0; j < n; ++j)
+          (*b)[fem[K][j]] += fem.shapeSign(K, j) * localVector[j]; // Accumulate to b
+      }
+    });
+  return b;
 }
+
+/*
+  \returns the FE mass matrix for a polynomial coefficient "a" using two FEM2Ds.
+
+  The inner products are integrated exactly from the moments of the shape
+  functions (see Functions/PolynomialCoefficient2D.h), so n_gq is not used.
+*/
 template<int N, int M>
 Matrix* FE_MassMatrix2D(const FEM2D<N>& fem1, const FEM2D<M>& fem2,
-  std::function<real(real, real)> a,
+  const PolynomialCoefficient2D& a,
   const int n_gq,
   const int xDerivativeOrder1, const int yDerivativeOrder1,
   const int xDerivativeOrder2, const int yDerivativeOrder2)
 {
   // Debug
-  ASSERT(fem1.mesh.size == fem2.mesh.size, "FEM structures do not share the same mesh");
-  ASSERT(fem1.mesh.numNodes == fem2.mesh.numNodes, "FEM structures do not share the same mesh");
-  ASSERT(fem1.mesh.numEdges == fem2.mesh.numEdges, "FEM structures do not share the same mesh");
+  ASSERT(&fem1.mesh == &fem2.mesh, "FEM structures do not share the same mesh");
 
-  const int& p1 = fem1.polynomialOrder;
-  const int& p2 = fem2.polynomialOrder;
+  const RefMomentTable2D moments = RefMomentTable2D(fem1.polynomialOrder, fem2.polynomialOrder, a.degree,
+                                                    xDerivativeOrder1, yDerivativeOrder1, xDerivativeOrder2, yDerivativeOrder2,
+                                                    fem1.basisType, fem2.basisType);
+  const int n1 = moments.numShapes1;
+  const int n2 = moments.numShapes2;
+
+  // Congruent elements share their mapped moments
+  std::vector<std::vector<real>> classMoments = std::vector<std::vector<real>>(fem1.mesh.numCongruenceClasses());
+  for (int c = 0; c < (int)classMoments.size(); ++c)
+  {
+    classMoments[c].resize(moments.mappedSize());
+    moments.mapToElement(fem1.mesh.elementGeometry(fem1.mesh.congruenceClassElement(c)), classMoments[c].data());
+  }
 
   Matrix* A = new Matrix(fem1.Ng, fem2.Ng);
-  for (int K = 0; K < fem1.mesh.size; ++K)
+
+  // Elements of one color share no FE nodes, so they are assembled in parallel
+  for (const std::vector<int>& elements : fem1.elementColors)
+    parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<real> mapped = std::vector<real>(moments.mappedSize());
+      std::vector<real> alpha = std::vector<real>(a.numMonomials);
+      std::vector<real> localMatrix = std::vector<real>(n1 * n2);
+      for (int e = begin; e < end; ++e)
+      {
+        const int K = elements[e];
+        const ElementGeometry2D geometry = fem1.mesh.elementGeometry(K);
+        const int c = fem1.mesh.congruenceClass(K);
+        if (c < 0)
+          moments.mapToElement(geometry, mapped.data());
+
+        a.referenceCoefficients(geometry, alpha.data());
+        moments.contract(c < 0 ? mapped.data() : classMoments[c].data(), alpha.data(), abs(geometry.determinant), localMatrix.data());
+
+        for (int i = 0; i < n1; ++i)
+          for (int j = 0; j < n2; ++j)
+            (*A)[fem1[K][i]][fem2[K][j]] += fem1.shapeSign(K, i) * fem2.shapeSign(K, j) * localMatrix[i * n2 + j]; // Accumulate to M
+      }
+    });
+  return A;
+}
+
+/*
+  Calls accumulate(K, masses) for each element K with the diagonal of its lumped
+  mass matrix for a function "a" (see MassLumping).  Elements of one color are
+  visited in parallel, so accumulate may add to the entries of their FE nodes.
+
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
+*/
+template<int N, typename Function, typename Accumulate>
+void lumpedElementMassMatrices2D(const FEM2D<N>& fem, const Function& a, const int n_gq, const MassLumping lumping, const Accumulate& accumulate)
+{
+  // Debug
+  ASSERT(lumping != MassLumping::None, "Mass matrix must be lumped");
+
+  if (fem.basisType != BasisType::Lagrange)
+    LOG("Mass lumping requires a Lagrange basis", LogLevel::Error);
+
+  const int numNodes = gauss2DNumNodes(n_gq, integrandDegree2D(a, 2 * fem.polynomialOrder, fem.polynomialOrder));
+  const std::vector<std::array<real, 2>>& refNodes = gauss2DNodesRef(numNodes);
+  const std::vector<real>& refWeights = gauss2DWeightsRef(numNodes);
+
+  dispatchPolynomialOrder(fem.polynomialOrder, [&](auto order)
   {
-    std::vector<std::array<real, 2>> GLnodes = gauss2DNodesLocal(fem1.mesh, K, n_gq);
-    std::vector<real> GLweights = gauss2DWeightsLocal(fem1.mesh, K, n_gq);
+    constexpr int P = decltype(order)::value;
+    const RefBasisTable2D<P> basis = RefBasisTable2D<P>(fem.polynomialOrder, refNodes);
+    const int n = basis.numShapes;
 
-    for (int i = 0; i < (p1 + 1) * (p1 + 2) / 2; ++i)
-      for (int j = 0; j < (p2 + 1) * (p2 + 2) / 2; ++j)
+    for (const std::vector<int>& elements : fem.elementColors)
+      parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
       {
-        // Calculate the inner product between the i-th and j-th shape function on K
-        real innerProduct = 0.0;
-        for (int k = 0; k < n_gq; ++k)
+        std::vector<typename RefBasisTable2D<P>::Row> phi = basis.makeTable();
+        std::vector<std::array<real, 2>> GLnodes = std::vector<std::array<real, 2>>(numNodes);
+        std::vector<real> aValues = std::vector<real>(numNodes);
+        std::vector<real> masses = std::vector<real>(n);
+        for (int c = begin; c < end; ++c)
         {
-          const real& x = GLnodes[k][0];
-          const real& y = GLnodes[k][1];
-          const real integrand = a(x, y) * lagrangeShapeFunction2D(x, y, fem1, K, i, xDerivativeOrder1, yDerivativeOrder1)
-            * lagrangeShapeFunction2D(x, y, fem2, K, j, xDerivativeOrder2, yDerivativeOrder2);
-          innerProduct += GLweights[k] * integrand;
+          const int K = elements[c];
+          const ElementGeometry2D geometry = fem.mesh.elementGeometry(K);
+          for (int k = 0; k < numNodes; ++k)
+            GLnodes[k] = geometry.toLocal(refNodes[k][0], refNodes[k][1]);
+          evaluateCoefficientOnElements2D(a, &K, 1, GLnodes, aValues);
+          basis.mapToElement(geometry, 0, 0, phi);
+
+          // Row sums, or the diagonal of the element mass matrix and the integral of "a" over the element
+          real mass = 0.0;
+          std::fill(masses.begin(), masses.end(), 0.0);
+          for (int k = 0; k < numNodes; ++k)
+          {
+            const real w = aValues[k] * abs(geometry.determinant) * refWeights[k];
+            mass += w;
+            if (lumping == MassLumping::RowSum)
+              for (int j = 0; j < n; ++j)
+                masses[j] += w * phi[k][j];
+            else
+              for (int j = 0; j < n; ++j)
+                masses[j] += w * phi[k][j] * phi[k][j];
+          }
+
+          if (lumping == MassLumping::DiagonalScaling)
+          {
+            real diagonalSum = 0.0;
+            for (int j = 0; j < n; ++j)
+              diagonalSum += masses[j];
+            for (int j = 0; j < n; ++j)
+              masses[j] *= mass / diagonalSum;
+          }
+          accumulate(K, masses.data());
         }
-        (*A)[fem1[K][i]][fem2[K][j]] += innerProduct; // Accumulate to M
-      }
-  }
-  return A;
+      });
+  });
+}
+
+/*
+  \returns the diagonal of the lumped FE mass matrix for a function "a" using one FEM2D.
+  Only for Lagrange bases, whose shape functions sum to 1.
+
+  With a diagonal mass matrix, projections and explicit time steps
+  divide by it entry by entry instead of solving a system.
+
+  \param n_gq: Number of Gaussian quadrature nodes, or AutomaticQuadrature.
+*/
+template<int N, typename Function>
+Vector* FE_LumpedMassMatrix2D(const FEM2D<N>& fem, const Function& a, const int n_gq, const MassLumping lumping)
+{
+  // Debug
+  ASSERT(lumping != MassLumping::None, "Mass matrix must be lumped");
+
+  if (fem.basisType != BasisType::Lagrange)
+    LOG("Mass lumping requires a Lagrange basis", LogLevel::Error);
+
+  // Since the shape functions sum to 1, the row sums are the entries of the load vector of "a"
+  if (lumping == MassLumping::RowSum)
+    return FE_LoadVector2D(fem, a, n_gq, 0, 0);
+
+  Vector* M = new Vector(fem.Ng);
+  const int n = numLocalNodes2D(fem.polynomialOrder);
+  lumpedElementMassMatrices2D(fem, a, n_gq, lumping, [&](const int K, const real* masses)
+  {
+    for (int j = 0; j < n; ++j)
+      (*M)[fem[K][j]] += masses[j]; // Accumulate to M
+  });
+  return M;
 }
 
 /*
   Performs and L2 projection on FEM2D for a function f.
 
   \param n_gq: Number of Gaussian quadrature nodes.
+  \param lumping: Lumping of the mass matrix (see FE_LumpedMassMatrix2D).  With a
+  lumped mass matrix, the load vector is lumped with the same nodal quadrature,
+  b_i = M_ii f(x_i), so the projection is a single pass over the FE nodes instead
+  of a dense solve.  For continuous f it is interpolation at the FE nodes, and where
+  f differs between the elements of a node, as element coefficients do, it is their
+  average weighted by the lumped masses, which must be positive (see MassLumping).
 */
-template<int N>
-void L2_Projection2D(FEM2D<N>& fem, real2DFunction f, const int n_gq)
+template<int N, typename Function>
+void L2_Projection2D(FEM2D<N>& fem, const Function& f, const int n_gq, const MassLumping lumping = MassLumping::None)
 {
   const int u = 0;
   const int& p = fem.polynomialOrder;
-  real2DFunction identityFunction = [](real x, real y) { return 1.0; };
 
-  Matrix* M = FE_MassMatrix2D(fem, identityFunction, n_gq, 0, 0);
+  if (lumping != MassLumping::None)
+  {
+    const std::vector<std::array<real, 2>> refNodes = refLagrangeNodes2D(p);
+    const int n = (int)refNodes.size();
+
+    // Values of f at the FE nodes of each element
+    std::vector<real> fValues = std::vector<real>(fem.mesh.size * n);
+    parallelFor(0, fem.mesh.size, ElementGrainSize, [&](const int begin, const int end)
+    {
+      std::vector<std::array<real, 2>> nodes = std::vector<std::array<real, 2>>(n);
+      std::vector<real> values = std::vector<real>(n);
+      for (int K = begin; K < end; ++K)
+      {
+        const ElementGeometry2D geometry = fem.mesh.elementGeometry(K);
+        for (int j = 0; j < n; ++j)
+          nodes[j] = geometry.toLocal(refNodes[j][0], refNodes[j][1]);
+        evaluateCoefficientOnElements2D(f, &K, 1, nodes, values);
+        std::copy(values.begin(), values.end(), fValues.begin() + K * n);
+      }
+    });
+
+    Vector M = Vector(fem.Ng);
+    Vector b = Vector(fem.Ng);
+    lumpedElementMassMatrices2D(fem, ConstantCoefficient2D(1.0), n_gq, lumping, [&](const int K, const real* masses)
+    {
+      for (int j = 0; j < n; ++j)
+      {
+        M[fem[K][j]] += masses[j];
+        b[fem[K][j]] += masses[j] * fValues[K * n + j];
+      }
+    });
+
+    for (int i = 0; i < fem.Ng; ++i)
+    {
+      if (M[i] <= 0.0)
+        LOG("Lumped mass matrix is not positive", LogLevel::Error);
+      fem.FENodes[i][u] = b[i] / M[i];
+    }
+    return;
+  }
+
   Vector* b = FE_LoadVector2D(fem, f, n_gq, 0, 0);
+  Matrix* M = FE_MassMatrix2D(fem, ConstantCoefficient2D(1.0), n_gq, 0, 0);
   Vector coefficients = solve(*M, *b);
 
   for (int K = 0; K < fem.mesh.size; ++K)
-    for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
+    for (int j = 0; j < numLocalNodes2D(p); ++j)
       fem(K, j)[u] = coefficients[fem[K][j]];
+  delete M;
+  delete b;
 }
\ No newline at end of file
@@ -2,13 +2,21 @@
 #include <memory>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
 
 // Data structures
 #include <array>
 #include <vector>
+#include <deque>
 #include <string>
 #include <functional>
 
 // I/O
 #include <iostream>
-#include <fstream>
\ No newline at end of file
+#include <fstream>
+
+// Concurrency
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
\ No newline at end of file
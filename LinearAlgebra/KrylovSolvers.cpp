@@ -0,0 +1,150 @@
+#include "Precompilied.h"
+#include "KrylovSolvers.h"
+
+static real dot(const Vector& u, const Vector& v)
+{
+  real sum = 0.0;
+  for (int i = 0; i < u.size(); ++i)
+    sum += u[i] * v[i];
+  return sum;
+}
+
+/*
+  Computes y += a * x.
+*/
+static void axpy(const real a, const Vector& x, Vector& y)
+{
+  for (int i = 0; i < y.size(); ++i)
+    y[i] += a * x[i];
+}
+
+KrylovResult conjugateGradient(const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations)
+{
+  // Debug
+  ASSERT(A.isSquare(), "Matrix A is not square");
+  ASSERT(A.size() == b.size(), "A and b must be the same dimension");
+
+  const int n = b.size();
+  const real bNorm = sqrt(dot(b, b));
+  Vector x = Vector(n);
+  if (bNorm == 0.0)
+    return KrylovResult{ std::move(x), 0, 0.0, true };
+
+  Vector r = Vector(n);
+  Vector z = Vector(n);
+  Vector p = Vector(n);
+  Vector Ap = Vector(n);
+  for (int i = 0; i < n; ++i)
+    r[i] = b[i];
+  preconditioner(r, z);
+  for (int i = 0; i < n; ++i)
+    p[i] = z[i];
+  real rz = dot(r, z);
+
+  real residual = 1.0;
+  for (int k = 1; k <= maxIterations; ++k)
+  {
+    multiply(A, p, Ap);
+    const real alpha = rz / dot(p, Ap);
+    axpy(alpha, p, x);
+    axpy(-alpha, Ap, r);
+
+    residual = sqrt(dot(r, r)) / bNorm;
+    if (residual <= tolerance)
+      return KrylovResult{ std::move(x), k, residual, true };
+
+    preconditioner(r, z);
+    const real rzNew = dot(r, z);
+    const real beta = rzNew / rz;
+    rz = rzNew;
+    for (int i = 0; i < n; ++i)
+      p[i] = z[i] + beta * p[i];
+  }
+  return KrylovResult{ std::move(x), maxIterations, residual, false };
+}
+
+KrylovResult biCGStab(const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations)
+{
+  // Debug
+  ASSERT(A.isSquare(), "Matrix A is not square");
+  ASSERT(A.size() == b.size(), "A and b must be the same dimension");
+
+  const int n = b.size();
+  const real bNorm = sqrt(dot(b, b));
+  Vector x = Vector(n);
+  if (bNorm == 0.0)
+    return KrylovResult{ std::move(x), 0, 0.0, true };
+
+  // Residual, shadow residual and search directions
+  Vector r = Vector(n);
+  Vector rHat = Vector(n);
+  Vector p = Vector(n);
+  Vector v = Vector(n);
+  Vector y = Vector(n);
+  Vector s = Vector(n);
+  Vector z = Vector(n);
+  Vector t = Vector(n);
+  for (int i = 0; i < n; ++i)
+  {
+    r[i] = b[i];
+    rHat[i] = b[i];
+  }
+
+  real rho = 1.0;
+  real alpha = 1.0;
+  real omega = 1.0;
+  real residual = 1.0;
+  for (int k = 1; k <= maxIterations; ++k)
+  {
+    // Breakdown, the shadow residual is orthogonal to the residual
+    const real rhoNew = dot(rHat, r);
+    if (rhoNew == 0.0)
+      return KrylovResult{ std::move(x), k, residual, false };
+    const real beta = (rhoNew / rho) * (alpha / omega);
+    rho = rhoNew;
+    for (int i = 0; i < n; ++i)
+      p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+    preconditioner(p, y);
+    multiply(A, y, v);
+    alpha = rho / dot(rHat, v);
+    for (int i = 0; i < n; ++i)
+      s[i] = r[i] - alpha * v[i];
+
+    residual = sqrt(dot(s, s)) / bNorm;
+    if (residual <= tolerance)
+    {
+      axpy(alpha, y, x);
+      return KrylovResult{ std::move(x), k, residual, true };
+    }
+
+    preconditioner(s, z);
+    multiply(A, z, t);
+    omega = dot(t, s) / dot(t, t);
+    axpy(alpha, y, x);
+    axpy(omega, z, x);
+    for (int i = 0; i < n; ++i)
+      r[i] = s[i] - omega * t[i];
+
+    residual = sqrt(dot(r, r)) / bNorm;
+    if (residual <= tolerance)
+      return KrylovResult{ std::move(x), k, residual, true };
+    if (omega == 0.0)
+      return KrylovResult{ std::move(x), k, residual, false };
+  }
+  return KrylovResult{ std::move(x), maxIterations, residual, false };
+}
+
+KrylovResult solveKrylov(const KrylovMethod method, const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations)
+{
+  switch (method)
+  {
+  case KrylovMethod::ConjugateGradient:
+    return conjugateGradient(A, b, preconditioner, tolerance, maxIterations);
+  case KrylovMethod::BiCGStab:
+    return biCGStab(A, b, preconditioner, tolerance, maxIterations);
+  default:
+    LOG("Krylov method not implemented", LogLevel::Error);
+    return conjugateGradient(A, b, preconditioner, tolerance, maxIterations);
+  }
+}
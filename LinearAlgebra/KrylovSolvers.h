@@ -0,0 +1,55 @@
+#pragma once
+#include "Precompilied.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+/*
+  A preconditioner z = M^-1 r, applied as preconditioner(r, z).
+  The identity, preconditioner(r, z) copying r to z, gives the plain methods.
+*/
+using Preconditioner = std::function<void(const Vector&, Vector&)>;
+
+/*
+  Krylov method for iterative solves of a system Ax = b.
+
+  ConjugateGradient: For symmetric positive definite A and symmetric positive definite preconditioners.
+  BiCGStab:          For general A.
+*/
+enum class KrylovMethod
+{
+  ConjugateGradient,
+  BiCGStab
+};
+
+/*
+  Solution of an iterative solve, along with the number of
+  iterations it took and the relative residual |b - Ax| / |b| it reached.
+*/
+struct KrylovResult
+{
+  Vector x;
+  int iterations;
+  real relativeResidual;
+  bool converged;
+};
+
+/*
+  \returns solution of system Ax = b with the preconditioned conjugate
+  gradient method, starting from x = 0.
+
+  \param tolerance: Relative residual at which the iteration stops.
+*/
+KrylovResult conjugateGradient(const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations);
+
+/*
+  \returns solution of system Ax = b with the preconditioned BiCGStab
+  method of van der Vorst, starting from x = 0.
+
+  \param tolerance: Relative residual at which the iteration stops.
+*/
+KrylovResult biCGStab(const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations);
+
+/*
+  \returns solution of system Ax = b with the given Krylov method.
+*/
+KrylovResult solveKrylov(const KrylovMethod method, const Matrix& A, const Vector& b, const Preconditioner& preconditioner, const real tolerance, const int maxIterations);
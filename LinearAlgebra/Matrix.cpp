@@ -1,5 +1,6 @@
 #include "Precompilied.h"
 #include "Matrix.h"
+#include "Utilities/TaskScheduler.h"
 
 Matrix::Matrix(const int size)
   : Matrix(size, size)
@@ -30,7 +31,7 @@ Matrix& Matrix::operator=(Matrix&& other) noexcept
   return *this;
 }
 
-Container<real>& Matrix::operator[](const int index)
+real* Matrix::operator[](const int index)
 {
   // Debug
   ASSERT(index >= 0, "index must be non-negative");
@@ -39,7 +40,7 @@ Container<real>& Matrix::operator[](const int index)
   return entries[index];
 }
 
-const Container<real>& Matrix::operator[](const int index) const
+const real* Matrix::operator[](const int index) const
 {
   // Debug
   ASSERT(index >= 0, "index must be non-negative");
@@ -161,8 +162,16 @@ Vector solve(Matrix& A, const Vector& b)
   ASSERT(A.isSquare(), "Matrix A is not square");
   ASSERT(A.size() == b.size(), "A and b must be the same dimension");
 
+  decomposeLU(A);
+  return solveLU(A, b);
+}
+
+void decomposeLU(Matrix& A)
+{
+  // Debug
+  ASSERT(A.isSquare(), "Matrix A is not square");
+
   const int n = A.size();
-  Vector x = Vector(n);
 
   // Diagonalization
   for (int k = 0; k < n; ++k)
@@ -172,6 +181,16 @@ Vector solve(Matrix& A, const Vector& b)
       for (int j = k + 1; j < n; ++j)
         A[i][j] -= A[i][k] * A[k][j];
     }
+}
+
+Vector solveLU(const Matrix& LU, const Vector& b)
+{
+  // Debug
+  ASSERT(LU.isSquare(), "Matrix LU is not square");
+  ASSERT(LU.size() == b.size(), "LU and b must be the same dimension");
+
+  const int n = LU.size();
+  Vector x = Vector(n);
 
   // Forward substitution to solve Ld = b
   x[0] = b[0];
@@ -179,23 +198,43 @@ Vector solve(Matrix& A, const Vector& b)
   {
     real s = 0;
     for (int j = 0; j < i; ++j)
-      s += A[i][j] * x[j];
+      s += LU[i][j] * x[j];
     x[i] = b[i] - s;
   }
 
   // Backwards substitution to solve Ux = d
-  x[n-1] /= A[n-1][n-1];
+  x[n-1] /= LU[n-1][n-1];
   for (int i = n - 2; i >= 0; --i)
   {
     real s = 0;
     for (int j = i + 1; j < n; ++j)
-      s += A[i][j] * x[j];
-    x[i] = (x[i] - s) / A[i][i];
+      s += LU[i][j] * x[j];
+    x[i] = (x[i] - s) / LU[i][i];
   }
 
   return x;
 }
 
+void multiply(const Matrix& A, const Vector& x, Vector& y)
+{
+  // Debug
+  ASSERT(A.columns() == x.size(), "Number of columns of A must match the dimension of x");
+  ASSERT(A.rows() == y.size(), "Number of rows of A must match the dimension of y");
+
+  constexpr int rowGrainSize = 64;
+  parallelFor(0, A.rows(), rowGrainSize, [&](const int begin, const int end)
+  {
+    for (int i = begin; i < end; ++i)
+    {
+      const real* row = A[i];
+      real sum = 0.0;
+      for (int j = 0; j < A.columns(); ++j)
+        sum += row[j] * x[j];
+      y[i] = sum;
+    }
+  });
+}
+
 Vector solve(Matrix&& A, Vector&& b)
 {
   Matrix M = std::move(A);
@@ -243,3 +282,54 @@ Vector solve(std::vector<std::vector<real>>& A, const Vector& b)
 
   return x;
 }
+
+Matrix inverse(Matrix& A)
+{
+  // Debug
+  ASSERT(A.isSquare(), "Matrix A is not square");
+
+  const int n = A.size();
+  Matrix X = Matrix(n);
+  for (int i = 0; i < n; ++i)
+    X[i][i] = 1.0;
+
+  // Pivots are compared to the size of the entries, so that the
+  // singularity test does not depend on the scaling of A
+  real maxEntry = 0.0;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      maxEntry = std::max(maxEntry, (real)abs(A[i][j]));
+
+  for (int k = 0; k < n; ++k)
+  {
+    int pivot = k;
+    for (int i = k + 1; i < n; ++i)
+      if (abs(A[i][k]) > abs(A[pivot][k]))
+        pivot = i;
+    if (abs(A[pivot][k]) <= TOLERANCE * maxEntry)
+      LOG("Matrix is singular", LogLevel::Error);
+    if (pivot != k)
+    {
+      std::swap_ranges(A[k], A[k] + n, A[pivot]);
+      std::swap_ranges(X[k], X[k] + n, X[pivot]);
+    }
+
+    const real diagonal = A[k][k];
+    for (int j = 0; j < n; ++j)
+    {
+      A[k][j] /= diagonal;
+      X[k][j] /= diagonal;
+    }
+    for (int i = 0; i < n; ++i)
+      if (i != k && A[i][k] != 0.0)
+      {
+        const real factor = A[i][k];
+        for (int j = 0; j < n; ++j)
+        {
+          A[i][j] -= factor * A[k][j];
+          X[i][j] -= factor * X[k][j];
+        }
+      }
+  }
+  return X;
+}
@@ -24,9 +24,9 @@ public:
 
   Matrix& operator=(Matrix&& other) noexcept;
 
-  Container<real>& operator[](const int index);
+  real* operator[](const int index);
 
-  const Container<real>& operator[](const int index) const;
+  const real* operator[](const int index) const;
 
   Matrix operator+(const Matrix& other) const;
 
@@ -79,6 +79,22 @@ private:
 */
 Vector solve(Matrix& A, const Vector& b);
 
+/*
+  Overwrites A with its LU decomposition (without pivoting), L being unit
+  lower triangular, so that systems with A can be solved repeatedly with solveLU.
+*/
+void decomposeLU(Matrix& A);
+
+/*
+  \returns solution of system Ax = b, given the LU decomposition of A from decomposeLU.
+*/
+Vector solveLU(const Matrix& LU, const Vector& b);
+
+/*
+  Computes y = Ax, rows are computed in parallel.
+*/
+void multiply(const Matrix& A, const Vector& x, Vector& y);
+
 /*
   Passes tempory values to other solve function.
 
@@ -86,4 +102,13 @@ Vector solve(Matrix& A, const Vector& b);
 */
 Vector solve(Matrix&& A, Vector&& b);
 
-Vector solve(std::vector<std::vector<real>>& A, const Vector& b);
\ No newline at end of file
+Vector solve(std::vector<std::vector<real>>& A, const Vector& b);
+
+/*
+  \returns the inverse of a square matrix A using Gauss-Jordan
+  elimination with partial pivoting.  A is singular if a pivot
+  is below TOLERANCE times the largest entry of A.
+
+  Warning: Changes matrix A!
+*/
+Matrix inverse(Matrix& A);
\ No newline at end of file
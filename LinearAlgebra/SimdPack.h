@@ -0,0 +1,64 @@
+#pragma once
+#include "Precompilied.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FE_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FE_SIMD_SSE2 1
+#endif
+
+/*
+  A pack of reals that is operated on with a single SIMD instruction.
+
+  The width is chosen at compile time from the widest instruction set
+  available (AVX: 4, SSE2: 2, otherwise 1).  Packs are only meant to live
+  in registers; data in memory is stored as plain reals and loaded/stored
+  unaligned, so that no container needs over-aligned allocation.
+*/
+struct RealPack
+{
+  static_assert(std::is_same<real, double>::value, "RealPack assumes real is double");
+
+#if FE_SIMD_AVX
+  static constexpr int width = 4;
+  __m256d v;
+
+  static RealPack zero() { return { _mm256_setzero_pd() }; }
+  static RealPack broadcast(const real a) { return { _mm256_set1_pd(a) }; }
+  static RealPack load(const real* p) { return { _mm256_loadu_pd(p) }; }
+  void store(real* p) const { _mm256_storeu_pd(p, v); }
+
+  friend RealPack operator+(const RealPack a, const RealPack b) { return { _mm256_add_pd(a.v, b.v) }; }
+  friend RealPack operator*(const RealPack a, const RealPack b) { return { _mm256_mul_pd(a.v, b.v) }; }
+#elif FE_SIMD_SSE2
+  static constexpr int width = 2;
+  __m128d v;
+
+  static RealPack zero() { return { _mm_setzero_pd() }; }
+  static RealPack broadcast(const real a) { return { _mm_set1_pd(a) }; }
+  static RealPack load(const real* p) { return { _mm_loadu_pd(p) }; }
+  void store(real* p) const { _mm_storeu_pd(p, v); }
+
+  friend RealPack operator+(const RealPack a, const RealPack b) { return { _mm_add_pd(a.v, b.v) }; }
+  friend RealPack operator*(const RealPack a, const RealPack b) { return { _mm_mul_pd(a.v, b.v) }; }
+#else
+  static constexpr int width = 1;
+  real v;
+
+  static RealPack zero() { return { 0.0 }; }
+  static RealPack broadcast(const real a) { return { a }; }
+  static RealPack load(const real* p) { return { *p }; }
+  void store(real* p) const { *p = v; }
+
+  friend RealPack operator+(const RealPack a, const RealPack b) { return { a.v + b.v }; }
+  friend RealPack operator*(const RealPack a, const RealPack b) { return { a.v * b.v }; }
+#endif
+
+  RealPack& operator+=(const RealPack other)
+  {
+    *this = *this + other;
+    return *this;
+  }
+};
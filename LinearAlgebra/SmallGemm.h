@@ -0,0 +1,97 @@
+#pragma once
+#include "Precompilied.h"
+#include "SimdPack.h"
+
+/*
+  Microkernels for the small dense products that make up element operators.
+
+  Each kernel works on a batch of RealPack::width independent problems
+  (typically one per element) stored interleaved: every scalar entry is
+  followed by the same entry of the other problems in the batch, so entry
+  (r, c) of a rows x cols matrix belonging to lane l lives at
+
+    data[(r * cols + c) * RealPack::width + l].
+
+  With this layout every arithmetic operation is a full-width SIMD
+  operation regardless of how small the matrices are, and there is no
+  remainder handling.  Unused lanes only need to hold finite values.
+
+  The template parameters M and N are the compile-time matrix dimensions,
+  0 means the dimension is only known at runtime.
+*/
+
+/*
+  Computes C = A^T * diag(w) * B for a batch of interleaved problems.
+
+  \param A: q x m matrix, typically the test functions at the quadrature points.
+  \param w: Vector of length q, typically the weighted coefficient at the quadrature points.
+  \param B: q x n matrix, typically the trial functions at the quadrature points.
+  \param C: m x n output matrix.
+*/
+template<int M, int N>
+void interleavedGemmTWN(const real* A, const real* w, const real* B, real* C, const int q, const int m, const int n)
+{
+  constexpr int W = RealPack::width;
+  const int rows = M > 0 ? M : m;
+  const int cols = N > 0 ? N : n;
+
+  for (int i = 0; i < rows; ++i)
+  {
+    // Columns of C are processed in blocks of 4 so that each
+    // weighted test function value is reused from a register
+    int j = 0;
+    for (; j + 4 <= cols; j += 4)
+    {
+      RealPack c0 = RealPack::zero();
+      RealPack c1 = RealPack::zero();
+      RealPack c2 = RealPack::zero();
+      RealPack c3 = RealPack::zero();
+      for (int k = 0; k < q; ++k)
+      {
+        const RealPack wa = RealPack::load(w + k * W) * RealPack::load(A + (k * rows + i) * W);
+        const real* b = B + (k * cols + j) * W;
+        c0 += wa * RealPack::load(b);
+        c1 += wa * RealPack::load(b + W);
+        c2 += wa * RealPack::load(b + 2 * W);
+        c3 += wa * RealPack::load(b + 3 * W);
+      }
+      real* c = C + (i * cols + j) * W;
+      c0.store(c);
+      c1.store(c + W);
+      c2.store(c + 2 * W);
+      c3.store(c + 3 * W);
+    }
+    for (; j < cols; ++j)
+    {
+      RealPack c0 = RealPack::zero();
+      for (int k = 0; k < q; ++k)
+      {
+        const RealPack wa = RealPack::load(w + k * W) * RealPack::load(A + (k * rows + i) * W);
+        c0 += wa * RealPack::load(B + (k * cols + j) * W);
+      }
+      c0.store(C + (i * cols + j) * W);
+    }
+  }
+}
+
+/*
+  Computes c = A^T * w for a batch of interleaved problems.
+
+  \param A: q x m matrix, typically the test functions at the quadrature points.
+  \param w: Vector of length q, typically the weighted function at the quadrature points.
+  \param c: Output vector of length m.
+*/
+template<int M>
+void interleavedGemvTW(const real* A, const real* w, real* c, const int q, const int m)
+{
+  constexpr int W = RealPack::width;
+  const int rows = M > 0 ? M : m;
+
+  for (int i = 0; i < rows; ++i)
+  {
+    RealPack c0 = RealPack::zero();
+    for (int k = 0; k < q; ++k)
+      c0 += RealPack::load(w + k * W) * RealPack::load(A + (k * rows + i) * W);
+    c0.store(c + i * W);
+  }
+}
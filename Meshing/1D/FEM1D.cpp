@@ -2,10 +2,23 @@
 #include "FEM1D.h"
 #include "Functions/LagrangeShapeFunctions1D.h"
 
-FEM1D::FEM1D(const Mesh1D& FEmesh, const int order)
+std::vector<real> refNodes1D(const int polynomialOrder, const NodeDistribution1D nodeDistribution)
+{
+  const int& p = polynomialOrder;
+  if (nodeDistribution == NodeDistribution1D::GaussLobatto)
+    return gaussLobatto1DNodesRef(p + 1);
+
+  std::vector<real> refNodes = std::vector<real>(p + 1);
+  for (int i = 0; i < p + 1; ++i)
+    refNodes[i] = -1.0 + 2.0 * i / p;
+  return refNodes;
+}
+
+FEM1D::FEM1D(const Mesh1D& FEmesh, const int order, const NodeDistribution1D nodes)
   : mesh(FEmesh),
   meshSize(mesh.size),
   polynomialOrder(order),
+  nodeDistribution(nodes),
   Ng(mesh.size* order + 1),
   Nu(Ng - mesh.numBoundaryNodes)
 {
@@ -15,6 +28,8 @@ FEM1D::FEM1D(const Mesh1D& FEmesh, const int order)
   ASSERT(p > 0, "Polynomial order must be positive");
   ASSERT(mesh.numBoundaryNodes >= 0, "Boundary conditions have not been set up in mesh");
 
+  const std::vector<real> refNodes = refNodes1D(p, nodeDistribution);
+
   // Create arrays
   FENodes = new FENode1D[Ng];
   connectivityMatrix.resize(meshSize);
@@ -29,7 +44,10 @@ FEM1D::FEM1D(const Mesh1D& FEmesh, const int order)
     const real xR = mesh(elem, EdgeType::Right).x;
     for (int i = 0; i < p; ++i)
     {
-      FENodes[elem * p + i].x = xL + i * (xR - xL) / p;
+      if (nodeDistribution == NodeDistribution1D::Uniform)
+        FENodes[elem * p + i].x = xL + i * (xR - xL) / p;
+      else
+        FENodes[elem * p + i].x = xL + (1.0 + refNodes[i]) * (xR - xL) / 2;
       connectivityMatrix[elem][i] = elem * p + i;
     }
     connectivityMatrix[elem][p] = (elem + 1) * p;
@@ -44,10 +62,13 @@ FEM1D::FEM1D(const Mesh1D& FEmesh, const int order)
   FENodes[meshSize * p].BC = mesh(meshSize - 1, EdgeType::Right).BC;
   if ((int)mesh(meshSize - 1, EdgeType::Right).BC >= 0)
     boundaryIndices.emplace_back(meshSize * p);
+
+  // Group elements for parallel assembly
+  elementColors = colorElements(meshSize, p + 1, Ng, [this](const int K, const int j) { return connectivityMatrix[K][j]; });
 }
 
-FEM1D::FEM1D(const Mesh1D& FEmesh, const int order, real1DFunction initialCondition)
-  : FEM1D(FEmesh, order)
+FEM1D::FEM1D(const Mesh1D& FEmesh, const int order, real1DFunction initialCondition, const NodeDistribution1D nodes)
+  : FEM1D(FEmesh, order, nodes)
 {
   const auto& f = initialCondition;
 
@@ -60,9 +81,11 @@ FEM1D::FEM1D(FEM1D&& other) noexcept
   : mesh(other.mesh),
   meshSize(other.meshSize),
   polynomialOrder(other.polynomialOrder),
+  nodeDistribution(other.nodeDistribution),
   Ng(other.Ng),
   Nu(other.Nu),
-  boundaryIndices(std::move(other.boundaryIndices))
+  boundaryIndices(std::move(other.boundaryIndices)),
+  elementColors(std::move(other.elementColors))
 {
   FENodes = other.FENodes;
   connectivityMatrix = std::move(other.connectivityMatrix);
@@ -178,24 +201,59 @@ real FEM1D::evaluate(const real x, const int elementIndex, const int derivativeO
 
 void FEM1D::plot(const int n, const int derivativeOrder) const
 {
-  plot("Out.txt", true, n, derivativeOrder);
+  plot("Out.txt", n, derivativeOrder);
+  waitAndRemove("Out.txt");
 }
 
-void FEM1D::plot(const std::string fileName, bool removeAfter, const int n, const int derivativeOrder) const
+void FEM1D::plot(const std::string& fileName, const int n, const int derivativeOrder) const
 {
-  std::ofstream file(fileName);
-  for (int K = 0; K < meshSize; ++K)
-    for (int i = 0; i < n; ++i)
+  writeElementSamples(fileName, n, derivativeOrder, [](TextChunk& chunk, const real x, const real u)
+  {
+    chunk.writeLine({ x, u });
+  });
+}
+
+void FEM1D::writeElementSamples(const std::string& fileName, const int n, const int derivativeOrder,
+                                const std::function<void(TextChunk&, real, real)>& format) const
+{
+  const int& p = polynomialOrder;
+  ASSERT(n > 0, "Number of plot points must be positive");
+
+  // Tabulate shape functions at the sample points on the reference element [-1, 1],
+  // on which the FE nodes of every element are at the same place
+  const std::vector<real> allRefNodes = refNodes1D(p, nodeDistribution);
+  std::vector<real> table = std::vector<real>(n * (p + 1));
+  for (int j = 0; j < p + 1; ++j)
+  {
+    std::vector<real> refNodes;
+    for (int i = 0; i < p + 1; ++i)
+      if (i != j)
+        refNodes.push_back(allRefNodes[i]);
+    const real& t_j = allRefNodes[j];
+
+    for (int k = 0; k < n; ++k)
+      table[k * (p + 1) + j] = refLagrangePolynomial1D(-1.0 + 2.0 * k / n, t_j, refNodes, derivativeOrder);
+  }
+
+  writeChunked(fileName, meshSize, ElementGrainSize, [&](const int begin, const int end, TextChunk& chunk)
+  {
+    for (int K = begin; K < end; ++K)
     {
       const real& xL = mesh(K, EdgeType::Left).x;
       const real& xR = mesh(K, EdgeType::Right).x;
-      const real x = xL + i * (xR - xL) / n;
 
-      file << x << ", " << evaluate(x, K, derivativeOrder) << std::endl;
+      // A factor of 2 / (xR - xL) is acquired with each derivative
+      real multiplier = 1.0;
+      for (int i = 0; i < derivativeOrder; ++i)
+        multiplier *= 2.0 / (xR - xL);
+
+      for (int k = 0; k < n; ++k)
+      {
+        real sum = 0.0;
+        for (int j = 0; j < p + 1; ++j)
+          sum += FENodes[connectivityMatrix[K][j]].u * table[k * (p + 1) + j];
+        format(chunk, xL + k * (xR - xL) / n, multiplier * sum);
+      }
     }
-  file.close();
-  std::cout << "Data written to \"" << fileName << "\".  Press any key to continue" << std::endl;
-  std::cin.get();
-  if (removeAfter)
-    remove("Out.txt");
+  });
 }
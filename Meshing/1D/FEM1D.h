@@ -3,6 +3,28 @@
 #include "Mesh1D.h"
 #include "LinearAlgebra/Vector.h"
 #include "Functions/Gauss-LegendreNodes.h"
+#include "Meshing/ElementColoring.h"
+#include "Utilities/ChunkedWriter.h"
+
+/*
+  Placement of the FE nodes within each element.
+
+  Uniform:      Evenly spaced.
+  GaussLobatto: At the nodes of the Gauss-Lobatto rule with p + 1 nodes, so that
+                quadrature at the FE nodes is exact up to degree 2p - 1.  The mass
+                matrix then lumps to the Gauss-Lobatto weights (see FE_LumpedMassMatrix1D),
+                and interpolation is better conditioned for high orders.
+*/
+enum class NodeDistribution1D
+{
+  Uniform,
+  GaussLobatto
+};
+
+/*
+  \returns the coordinates of the FE nodes of an element mapped onto [-1, 1].
+*/
+std::vector<real> refNodes1D(const int polynomialOrder, const NodeDistribution1D nodeDistribution);
 
 class FEM1D
 {
@@ -10,10 +32,12 @@ public:
   const Mesh1D& mesh;
   const int meshSize;
   const int polynomialOrder;
+  const NodeDistribution1D nodeDistribution;
   const int Ng; // Number of FE nodes
   const int Nu; // Number of non-boundary FE nodes
   std::vector<int> boundaryIndices{};  // Indices of all boundary nodes, must be ordered!
   FENode1D* FENodes; // Stores all finite element nodes
+  std::vector<std::vector<int>> elementColors{};  // Elements grouped so that no two elements in a group share an FE node
 
   FEM1D() = delete;
 
@@ -21,7 +45,7 @@ public:
     Generates a finite element method using a given mesh and a
     polynomial order.
   */
-  FEM1D(const Mesh1D& FEmesh, const int order);
+  FEM1D(const Mesh1D& FEmesh, const int order, const NodeDistribution1D nodes = NodeDistribution1D::Uniform);
 
   /*
     Generates a finite element method using a given mesh, a
@@ -29,7 +53,7 @@ public:
 
     Will use Lagrange interpolation to approximate the initial condition function.
   */
-  FEM1D(const Mesh1D& mesh, const int order, real1DFunction initialCondition);
+  FEM1D(const Mesh1D& mesh, const int order, real1DFunction initialCondition, const NodeDistribution1D nodes = NodeDistribution1D::Uniform);
 
   /*
     Move constructor.
@@ -88,7 +112,8 @@ public:
 
   /*
     Outputs a file called "Out.txt" that when graphed gives the
-    d-th derivative of the FE interpolation.
+    d-th derivative of the FE interpolation, and waits for the user
+    to press a key before removing it.
 
     \param n: Number of points to plot per element.
 
@@ -96,7 +121,22 @@ public:
   */
   void plot(const int n, const int derivativeOrder = 0) const;
 
-  void plot(const std::string fileName, bool removeAfter, const int n, const int derivativeOrder = 0) const;
+  /*
+    Same as above, but writes to the given file and returns immediately.
+    The file is left on disk.
+  */
+  void plot(const std::string& fileName, const int n, const int derivativeOrder = 0) const;
+
+  /*
+    Samples the d-th derivative of the FE interpolation at n evenly spaced
+    points per element, starting at the left edge, and writes a line
+    format(chunk, x, u) for each sample point to the given file.
+
+    Shape functions are tabulated once on the reference element, and elements
+    are sampled in parallel, so format must be safe to call concurrently.
+  */
+  void writeElementSamples(const std::string& fileName, const int n, const int derivativeOrder,
+                           const std::function<void(TextChunk&, real, real)>& format) const;
 
 private:
   /*
@@ -0,0 +1,34 @@
+#include "Precompilied.h"
+#include "BoundaryConditions2D.h"
+
+BoundaryConditions2D::BoundaryConditions2D(const int numNodes)
+  : nodeBCs(numNodes, BC_Type::Interior),
+    cornerNodes(numNodes, false)
+{
+}
+
+BoundaryConditions2D::BoundaryConditions2D(const Mesh2D& mesh)
+  : BoundaryConditions2D(mesh.numNodes)
+{
+  ASSERT(mesh.numBoundaryNodes >= 0, "Boundary conditions have not been set up in mesh");
+
+  for (int i = 0; i < mesh.numNodes; ++i)
+  {
+    const MeshNode2D A = mesh.node(i);
+    set(i, A.BC);
+    cornerNodes[i] = A.isCorner;
+  }
+}
+
+void BoundaryConditions2D::set(const int nodeIndex, const BC_Type boundaryCondition)
+{
+  // Debug
+  ASSERT(nodeIndex >= 0, "Node index must be non-negative");
+  ASSERT(nodeIndex < (int)nodeBCs.size(), "Node index must be less than the number of nodes");
+
+  if ((int)nodeBCs[nodeIndex] >= 0)
+    --numBoundaryNodes;
+  nodeBCs[nodeIndex] = boundaryCondition;
+  if ((int)boundaryCondition >= 0)
+    ++numBoundaryNodes;
+}
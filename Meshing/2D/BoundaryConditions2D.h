@@ -0,0 +1,38 @@
+#pragma once
+#include "Precompilied.h"
+#include "Mesh2D.h"
+#include "Meshing/BoundayEnums.h"
+
+/*
+  Boundary conditions on the nodes of a Mesh2D, kept apart from the mesh.
+
+  Boundary conditions belong to an FE space rather than to the mesh: in a
+  mixed problem the velocity may be prescribed on the boundary while the
+  pressure is not.  With the conditions in a separate layer, FEM2D objects
+  with different boundary conditions can share one mesh, and with it its
+  topology, element geometry and point location structures.
+*/
+class BoundaryConditions2D
+{
+public:
+  std::vector<BC_Type> nodeBCs;     // Boundary condition of each mesh node
+  std::vector<bool> cornerNodes;    // Whether each mesh node is a corner of the domain
+  int numBoundaryNodes = 0;         // Number of nodes with an essential, Dirichlet or Neumann condition
+
+  BoundaryConditions2D() = delete;
+
+  /*
+    Creates a layer in which all nodes of a mesh with numNodes nodes are interior nodes.
+  */
+  BoundaryConditions2D(const int numNodes);
+
+  /*
+    Creates a layer holding the boundary conditions stored on the nodes of a mesh.
+  */
+  BoundaryConditions2D(const Mesh2D& mesh);
+
+  /*
+    Sets the boundary condition of a node.
+  */
+  void set(const int nodeIndex, const BC_Type boundaryCondition);
+};
@@ -0,0 +1,86 @@
+#include "Precompilied.h"
+#include "ElementGrid2D.h"
+#include "Mesh2D.h"
+
+ElementGrid2D::ElementGrid2D(const Mesh2D& FEmesh)
+  : mesh(FEmesh)
+{
+  // Find bounding box of mesh
+  const MeshNode2D first = mesh.node(0);
+  xMin = xMax = first.x;
+  yMin = yMax = first.y;
+  for (int n = 1; n < mesh.numNodes; ++n)
+  {
+    const MeshNode2D A = mesh.node(n);
+    xMin = std::min(xMin, A.x);
+    xMax = std::max(xMax, A.x);
+    yMin = std::min(yMin, A.y);
+    yMax = std::max(yMax, A.y);
+  }
+
+  // Choose about one bucket per element, with buckets as square as possible
+  const real width = std::max(xMax - xMin, TOLERANCE);
+  const real height = std::max(yMax - yMin, TOLERANCE);
+  const real bucketSize = std::sqrt(width * height / mesh.size);
+  nx = std::max(1, std::min(mesh.size, (int)(width / bucketSize)));
+  ny = std::max(1, std::min(mesh.size, (int)(height / bucketSize)));
+  dx = width / nx;
+  dy = height / ny;
+
+  // Count elements per bucket, then fill buckets
+  offsets = std::vector<int>(nx * ny + 1, 0);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<int> fill = pass == 0 ? std::vector<int>() : std::vector<int>(offsets.begin(), offsets.end() - 1);
+    for (int K = 0; K < mesh.size; ++K)
+    {
+      const MeshNode2D& A1 = mesh(K, 0);
+      const MeshNode2D& A2 = mesh(K, 1);
+      const MeshNode2D& A3 = mesh(K, 2);
+      const int iMin = bucketX(std::min({ A1.x, A2.x, A3.x }));
+      const int iMax = bucketX(std::max({ A1.x, A2.x, A3.x }));
+      const int jMin = bucketY(std::min({ A1.y, A2.y, A3.y }));
+      const int jMax = bucketY(std::max({ A1.y, A2.y, A3.y }));
+
+      for (int j = jMin; j <= jMax; ++j)
+        for (int i = iMin; i <= iMax; ++i)
+        {
+          const int b = j * nx + i;
+          if (pass == 0)
+            ++offsets[b + 1];
+          else
+            elements[fill[b]++] = K;
+        }
+    }
+
+    if (pass == 0)
+    {
+      for (int b = 0; b < nx * ny; ++b)
+        offsets[b + 1] += offsets[b];
+      elements = std::vector<int>(offsets[nx * ny]);
+    }
+  }
+}
+
+int ElementGrid2D::locate(const real x, const real y) const
+{
+  const real tolerance = TOLERANCE * std::max(xMax - xMin, yMax - yMin);
+  if (x < xMin - tolerance || x > xMax + tolerance || y < yMin - tolerance || y > yMax + tolerance)
+    return -1;
+
+  const int b = bucketY(y) * nx + bucketX(x);
+  for (int n = offsets[b]; n < offsets[b + 1]; ++n)
+    if (mesh.isInElement(x, y, elements[n]))
+      return elements[n];
+  return -1;
+}
+
+int ElementGrid2D::bucketX(const real x) const
+{
+  return std::max(0, std::min(nx - 1, (int)std::floor((x - xMin) / dx)));
+}
+
+int ElementGrid2D::bucketY(const real y) const
+{
+  return std::max(0, std::min(ny - 1, (int)std::floor((y - yMin) / dy)));
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Precompilied.h"
+
+class Mesh2D;
+
+/*
+  A uniform grid of buckets over the bounding box of a mesh, used to
+  locate the element that contains a point.
+
+  Each bucket lists the elements whose bounding box overlaps it.  The
+  grid has roughly as many buckets as the mesh has elements, so for
+  meshes without extreme variations in element size, a query only
+  tests a handful of elements.
+*/
+class ElementGrid2D
+{
+public:
+  ElementGrid2D(const Mesh2D& mesh);
+
+  /*
+    \returns the index of an element containing (x, y),
+    or -1 if (x, y) is not inside the mesh.
+  */
+  int locate(const real x, const real y) const;
+
+private:
+  const Mesh2D& mesh;
+  real xMin, xMax, yMin, yMax;
+  int nx, ny;
+  real dx, dy;
+  std::vector<int> offsets;   // Elements of bucket b are elements[offsets[b]] ... elements[offsets[b + 1] - 1]
+  std::vector<int> elements;
+
+  int bucketX(const real x) const;
+  int bucketY(const real y) const;
+};
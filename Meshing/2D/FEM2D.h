@@ -1,7 +1,13 @@
 #pragma once
 #include "Precompilied.h"
 #include "Mesh2D.h"
+#include "BoundaryConditions2D.h"
 #include "LinearAlgebra/Matrix.h"
+#include "Functions/ReferenceBasis2D.h"
+#include "Functions/ElementKernels2D.h"
+#include "Meshing/ElementColoring.h"
+#include "Utilities/TaskScheduler.h"
+#include "Utilities/ChunkedWriter.h"
 
 /*
   2D finite element structure.
@@ -14,59 +20,80 @@ class FEM2D
 public:
   const Mesh2D& mesh;
   const int polynomialOrder;
+  const BasisType basisType;
   const int Ng;                        // Number of FE nodes
   std::vector<int> boundaryIndices{};  // Indices of all boundary nodes, must be ordered!
   FENode2D<N>* FENodes;
+  std::vector<std::vector<int>> elementColors{};  // Elements grouped so that no two elements in a group share an FE node
 
   FEM2D() = delete;
 
   /*
     Generates a finite element method using a given mesh and a
-    polynomial order.
+    polynomial order, with the boundary conditions stored in the mesh.
   */
-  FEM2D(const Mesh2D& FEmesh, const int order)
+  FEM2D(const Mesh2D& FEmesh, const int order, const BasisType basis = BasisType::Lagrange)
+    : FEM2D(FEmesh, order, BoundaryConditions2D(FEmesh), basis)
+  {
+  }
+
+  /*
+    Generates a finite element method using a given mesh, a
+    polynomial order, and boundary conditions on the mesh nodes.
+
+    Any number of FEM structures with different boundary conditions can share one mesh.
+
+    With a hierarchical basis, the FE nodes on edges and in the interior
+    are placed as for Lagrange elements, but hold the coefficients of the
+    edge and bubble modes instead of values (see interpolate).
+  */
+  FEM2D(const Mesh2D& FEmesh, const int order, const BoundaryConditions2D& boundaryConditions, const BasisType basis = BasisType::Lagrange)
     : mesh(FEmesh),
     polynomialOrder(order),
+    basisType(basis),
     Ng(mesh.numNodes + (order - 1) * mesh.numEdges + (order - 1) * (order - 2) * mesh.size / 2),
-    connectivityMatrix(mesh.size, (order + 2)* (order + 1) / 2)
+    connectivityMatrix(mesh.size, numLocalNodes2D(order))
   {
     const int& p = polynomialOrder;
 
     // Debug
     ASSERT(N > 0, "Number of variables must be positive");
     ASSERT(p > 0, "Polynomial order must be positive");
-    ASSERT(mesh.numBoundaryNodes >= 0, "Boundary conditions have not been set up in mesh");
+    ASSERT((int)boundaryConditions.nodeBCs.size() == mesh.numNodes, "Boundary conditions do not match mesh");
 
     FENodes = new FENode2D<N>[Ng];
+    if (basisType == BasisType::Hierarchical)
+      edgeFlips = std::vector<unsigned char>(mesh.size, 0);
 
     // Handle vertices first
     for (int n = 0; n < mesh.numNodes; ++n)
     {
+      const MeshNode2D A = mesh.node(n);
 #pragma warning(suppress: 6386)
-      FENodes[n].x = mesh.meshNodes[n].x;
-      FENodes[n].y = mesh.meshNodes[n].y;
-      FENodes[n].BC = mesh.meshNodes[n].BC;
-      FENodes[n].isCorner = mesh.meshNodes[n].isCorner;
+      FENodes[n].x = A.x;
+      FENodes[n].y = A.y;
+      FENodes[n].BC = boundaryConditions.nodeBCs[n];
+      FENodes[n].isCorner = boundaryConditions.cornerNodes[n];
       if ((int)FENodes[n].BC >= 0)
         boundaryIndices.emplace_back(n);
     }
     for (int K = 0; K < mesh.size; ++K)
       for (int v = 0; v < 3; ++v)
-        connectivityMatrix[K][v] = mesh.connectivityMatrix[K][v];
+        connectivityMatrix[K][v] = mesh.elementNode(K, v);
 
     // Then handle nodes along edges
     for (int e = 0; e < mesh.numEdges; ++e)
     {
-      const int& I = mesh.edgeArray[e][0];
-      const int& J = mesh.edgeArray[e][1];
+      const int I = mesh.edgeNode(e, 0);
+      const int J = mesh.edgeNode(e, 1);
 
-      // Grab nodes that form edge
-      const MeshNode2D& A1 = mesh.meshNodes[I];
-      const MeshNode2D& A2 = mesh.meshNodes[J];
+      // Grab nodes that form edge, vertices are the first FE nodes
+      const FENode2D<N>& A1 = FENodes[I];
+      const FENode2D<N>& A2 = FENodes[J];
 
       // Check if nodes form boundary edge
       bool boundary = false;
-      if (mesh.edgeTypeMatrix[I][J] == 1)
+      if (mesh.edgeType(I, J) == 1)
         boundary = true;
 
       // Determine correct boundary condition
@@ -98,16 +125,21 @@ public:
         for (int j = i - 1; j >= 0; --j)
         {
           // Grab indices of potential edge-forming nodes
-          const int& I = mesh.connectivityMatrix[K][i];
-          const int& J = mesh.connectivityMatrix[K][j];
+          const int I = mesh.elementNode(K, i);
+          const int J = mesh.elementNode(K, j);
 
-          if (mesh.edgeTypeMatrix[I][J] > 0) // Check if they form edge
+          const int E = mesh.edgeIndex(I, J);
+          if (E >= 0) // Check if they form edge
           {
-            const int E = mesh.edgeMatrix[I][J] - 1;
-            ASSERT(E + 1 > 0, "Nodes I and J do not form an edge");
-
+            // Local edge nodes run from local vertex j to i (see refLagrangeNodes2D),
+            // which may be opposite to the direction of the mesh edge.  Hierarchical
+            // edge modes keep their order and flip sign instead (see shapeSign)
+            const bool reversed = mesh.edgeNode(E, 0) != J;
+            const bool permuted = reversed && basisType == BasisType::Lagrange;
             for (int l = 0; l < p - 1; ++l)
-              connectivityMatrix[K][3 + e * (p - 1) + l] = mesh.numNodes + E * (p - 1) + l;
+              connectivityMatrix[K][3 + e * (p - 1) + l] = mesh.numNodes + E * (p - 1) + (permuted ? p - 2 - l : l);
+            if (reversed && basisType == BasisType::Hierarchical)
+              edgeFlips[K] |= 1 << e;
             ++e;
           }
         }
@@ -117,16 +149,8 @@ public:
     int nodeIndex = mesh.numNodes + mesh.numEdges * (p - 1);
     for (int K = 0; K < mesh.size; ++K)
     {
-      const MeshNode2D& A1 = mesh(K, 0);
-      const MeshNode2D& A2 = mesh(K, 1);
-      const MeshNode2D& A3 = mesh(K, 2);
-
-      // Create transformation matrix from reference domain to K
-      Matrix B = Matrix(2);
-      B[0][0] = A2.x - A1.x;
-      B[0][1] = A3.x - A1.x;
-      B[1][0] = A2.y - A1.y;
-      B[1][1] = A3.y - A1.y;
+      // Transformation from reference domain to K
+      const ElementGeometry2D geometry = mesh.elementGeometry(K);
 
       int localNodeIndex = 3 * p;
       for (int i = 0; i < p - 2; ++i)
@@ -137,8 +161,9 @@ public:
           const real ty = (real)(j + 1.0) / p;
 
           // Transform points from reference domain to element K
-          FENodes[nodeIndex].x = B[0][0] * tx + B[0][1] * ty + A1.x;
-          FENodes[nodeIndex].y = B[1][0] * tx + B[1][1] * ty + A1.y;
+          const std::array<real, 2> point = geometry.toLocal(tx, ty);
+          FENodes[nodeIndex].x = point[0];
+          FENodes[nodeIndex].y = point[1];
 
           connectivityMatrix[K][localNodeIndex] = nodeIndex;
           ++nodeIndex;
@@ -160,6 +185,9 @@ public:
           boundaryIndices[i + 1] = tmp;
         }
     }
+
+    // Group elements for parallel assembly
+    elementColors = colorElements(mesh.size, numLocalNodes2D(p), Ng, [this](const int K, const int j) { return connectivityMatrix[K][j]; });
   }
 
   /*
@@ -171,11 +199,7 @@ public:
   FEM2D(const Mesh2D& FEmesh, const int order, real2DFunction initialCondition)
     : FEM2D(FEmesh, order)
   {
-    const auto& f = initialCondition;
-
-    // Interpolate initialCondition
-    for (int i = 0; i < Ng; ++i)
-      FENodes[i][0] = f(FENodes[i].x, FENodes[i].y);
+    interpolate(0, initialCondition);
   }
 
   /*
@@ -184,9 +208,12 @@ public:
   FEM2D(FEM2D&& other) noexcept
     : mesh(other.mesh),
     polynomialOrder(other.polynomialOrder),
+    basisType(other.basisType),
     Ng(other.Ng),
     boundaryIndices(std::move(other.boundaryIndices)),
-    connectivityMatrix(std::move(connectivityMatrix))
+    elementColors(std::move(other.elementColors)),
+    connectivityMatrix(std::move(other.connectivityMatrix)),
+    edgeFlips(std::move(other.edgeFlips))
   {
     FENodes = other.FENodes;
     other.FENodes = nullptr;
@@ -196,7 +223,42 @@ public:
 
   FEM2D& operator=(const FEM2D& other) = delete;
 
-  const Container<int>& operator[](const int elementIndex) const
+  ~FEM2D()
+  {
+    delete[] FENodes;
+  }
+
+  /*
+    \returns the boundary conditions of this FEM structure on the mesh nodes,
+    from which an FEM structure with the same boundary conditions can be made.
+  */
+  BoundaryConditions2D boundaryConditions() const
+  {
+    BoundaryConditions2D layer = BoundaryConditions2D(mesh.numNodes);
+    for (int n = 0; n < mesh.numNodes; ++n)
+    {
+      layer.set(n, FENodes[n].BC);
+      layer.cornerNodes[n] = FENodes[n].isCorner;
+    }
+    return layer;
+  }
+
+  /*
+    Copies the FE nodes, and with them the values of all variables, of
+    another FEM2D of the same order and basis on the same mesh.  Since both
+    are numbered the same way, this is a single copy of the node array.
+  */
+  void copyNodes(const FEM2D& other)
+  {
+    // Debug
+    ASSERT(&other.mesh == &mesh, "FEM structures must be on the same mesh");
+    ASSERT(other.polynomialOrder == polynomialOrder, "FEM structures must have the same polynomial order");
+    ASSERT(other.basisType == basisType, "FEM structures must have the same basis type");
+
+    std::copy(other.FENodes, other.FENodes + Ng, FENodes);
+  }
+
+  const int* operator[](const int elementIndex) const
   {
     // Debug
     ASSERT(elementIndex >= 0, "Element index must be non-negative");
@@ -216,28 +278,99 @@ public:
     ASSERT(elementIndex >= 0, "Element index must be non-negative");
     ASSERT(elementIndex < mesh.size, "Element index must be less than the number of elements");
     ASSERT(nodeIndex >= 0, "Node index must be non-negative");
-    ASSERT(nodeIndex < (polynomialOrder + 1)* (polynomialOrder + 2) / 2, "Node index must be less than the number of nodes per element");
+    ASSERT(nodeIndex < numLocalNodes2D(polynomialOrder), "Node index must be less than the number of nodes per element");
 
     return FENodes[connectivityMatrix[elementIndex][nodeIndex]];
   }
 
+  /*
+    \returns the sign of the j-th shape function of an element relative to the
+    global shape function of its FE node: -1 for hierarchical edge modes of odd
+    order on edges that run against the direction of the mesh edge, 1 otherwise.
+
+    Local coefficients are the values at the FE nodes times this sign,
+    and local vectors and matrices are scattered with it.
+  */
+  real shapeSign(const int elementIndex, const int nodeIndex) const
+  {
+    const int& p = polynomialOrder;
+    if (edgeFlips.empty() || nodeIndex < 3 || nodeIndex >= 3 * p)
+      return 1.0;
+
+    const int e = (nodeIndex - 3) / (p - 1);
+    const int k = (nodeIndex - 3) % (p - 1) + 2;
+    return (edgeFlips[elementIndex] >> e & 1) && k % 2 == 1 ? -1.0 : 1.0;
+  }
+
+  /*
+    Sets a variable to the interpolant of f, a callable of (x, y).
+
+    With a Lagrange basis, these are the values of f at the FE nodes.  With a
+    hierarchical basis, the coefficients are those of the same polynomial on each
+    element: vertex modes take the values at the vertices, edge modes then match f
+    at the nodes on their edge and bubble modes at the interior nodes.
+  */
+  template<typename Function>
+  void interpolate(const int varIndex, const Function& f)
+  {
+    const int& p = polynomialOrder;
+
+    // Debug
+    ASSERT(varIndex >= 0, "Variable index must be non-negative");
+    ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+
+    if (basisType == BasisType::Lagrange)
+    {
+      for (int i = 0; i < Ng; ++i)
+        FENodes[i][varIndex] = f(FENodes[i].x, FENodes[i].y);
+      return;
+    }
+
+    // Coefficients of the shape functions from the values at the reference nodes
+    const std::vector<std::array<real, 2>> refNodes = refLagrangeNodes2D(p);
+    const int n = numLocalNodes2D(p);
+    Matrix V = Matrix(n);
+    for (int i = 0; i < n; ++i)
+      evaluateRefHierarchicalBasis2D(p, refNodes[i][0], refNodes[i][1], 0, 0, V[i]);
+    const Matrix Vinv = inverse(V);
+
+    // Elements of one color share no FE nodes, so they are interpolated in parallel
+    for (const std::vector<int>& elements : elementColors)
+      parallelFor(0, (int)elements.size(), ElementGrainSize, [&](const int begin, const int end)
+      {
+        std::vector<real> values = std::vector<real>(n);
+        for (int c = begin; c < end; ++c)
+        {
+          const int K = elements[c];
+          const ElementGeometry2D geometry = mesh.elementGeometry(K);
+          for (int i = 0; i < n; ++i)
+          {
+            const std::array<real, 2> point = geometry.toLocal(refNodes[i][0], refNodes[i][1]);
+            values[i] = f(point[0], point[1]);
+          }
+
+          for (int j = 0; j < n; ++j)
+          {
+            real coefficient = 0.0;
+            for (int i = 0; i < n; ++i)
+              coefficient += Vinv[j][i] * values[i];
+            FENodes[connectivityMatrix[K][j]][varIndex] = shapeSign(K, j) * coefficient;
+          }
+        }
+      });
+  }
+
   /*
     \returns the numerical approximation u_h(x, y).
 
-    Note: This function is ineffiecient, as it searches for the element
-    that (x, y) belongs to.  If the element is known, use other evaluate function.
+    Note: This function has to search for the element that (x, y) belongs to.
+    If the element is known, use other evaluate function.
   */
   real evaluate(const int varIndex, const real x, const real y) const { return evaluate(varIndex, x, y, 0, 0); }
   real evaluate(const int varIndex, const real x, const real y, const int xDerivativeOrder, const int yDerivativeOrder) const
   {
     // Search for element that x is an element of
-    int K = -1;
-    for (int i = 0; i < mesh.size; ++i)
-      if (isInTriangle(x, y, i))
-      {
-        K = i;
-        break;
-      }
+    const int K = mesh.locate(x, y);
     ASSERT(K >= 0, "x must be in the domain of the mesh");
 
     // Evaluate at x
@@ -262,97 +395,218 @@ public:
     ASSERT(K < mesh.size, "Element index must be less than the number of elements");
     ASSERT(isInTriangle(x, y, K), "x must be in the element at the specified elementIndex");
 
-    real sum = 0.0;
-    for (int j = 0; j < (p + 1) * (p + 2) / 2; ++j)
+    // Evaluate all shape functions at once on the reference domain
+    const ElementGeometry2D geometry = mesh.elementGeometry(K);
+    const std::array<real, 2> t = geometry.toReference(x, y);
+    return dispatchPolynomialOrder(p, [&](auto order)
     {
-      const int& i = connectivityMatrix[K][j];
-      sum += FENodes[i][varIndex] * lagrangeShapeFunction2D(x, y, *this, K, j, xDerivativeOrder, yDerivativeOrder);
+      constexpr int P = decltype(order)::value;
+      LocalArray<real, RefLagrangeBasis2D<P>::numShapes> phi = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>(numLocalNodes2D(p));
+      evaluateShapeFunctions2D<P>(basisType, p, geometry, t[0], t[1], xDerivativeOrder, yDerivativeOrder, phi.data());
+
+      real sum = 0.0;
+      for (int j = 0; j < numLocalNodes2D(p); ++j)
+      {
+        const int& i = connectivityMatrix[K][j];
+        sum += shapeSign(K, j) * FENodes[i][varIndex] * phi[j];
+      }
+      return sum;
+    });
+  }
+
+  /*
+    \returns the numerical approximation u_h at each of the given points,
+    in the same order as the points.  Points outside of the mesh give NaN.
+
+    Meant for evaluating at many points at once.  Points are located and then
+    grouped by the element that contains them, so that the element data
+    is only set up once for all of its points, and evaluated in parallel.
+  */
+  std::vector<real> evaluate(const int varIndex, const std::vector<std::array<real, 2>>& points) const { return evaluate(varIndex, points, 0, 0); }
+  std::vector<real> evaluate(const int varIndex, const std::vector<std::array<real, 2>>& points, const int xDerivativeOrder, const int yDerivativeOrder) const
+  {
+    const int& p = polynomialOrder;
+    const int numPoints = (int)points.size();
+
+    // Debug
+    ASSERT(varIndex >= 0, "Variable index must be non-negative");
+    ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+
+    // Locate points, consecutive points are often close together
+    // so walk from the element of the previous point
+    std::vector<int> pointElements = std::vector<int>(numPoints);
+    parallelFor(0, numPoints, PointGrainSize, [&](const int begin, const int end)
+    {
+      int K = -1;
+      for (int k = begin; k < end; ++k)
+      {
+        const int L = K < 0 ? mesh.locate(points[k][0], points[k][1]) : mesh.walk(points[k][0], points[k][1], K);
+        pointElements[k] = L;
+        if (L >= 0)
+          K = L;
+      }
+    });
+
+    // Sort points by element with a counting sort, points outside of the mesh are left out
+    std::vector<int> offsets = std::vector<int>(mesh.size + 1, 0);
+    for (int k = 0; k < numPoints; ++k)
+      if (pointElements[k] >= 0)
+        ++offsets[pointElements[k] + 1];
+    for (int K = 0; K < mesh.size; ++K)
+      offsets[K + 1] += offsets[K];
+    std::vector<int> sortedPoints = std::vector<int>(offsets[mesh.size]);
+    {
+      std::vector<int> fill = std::vector<int>(offsets.begin(), offsets.end() - 1);
+      for (int k = 0; k < numPoints; ++k)
+        if (pointElements[k] >= 0)
+          sortedPoints[fill[pointElements[k]]++] = k;
     }
-    return sum;
+
+    std::vector<real> values = std::vector<real>(numPoints, std::nan(""));
+    dispatchPolynomialOrder(p, [&](auto order)
+    {
+      constexpr int P = decltype(order)::value;
+      parallelFor(0, mesh.size, ElementGrainSize, [&](const int begin, const int end)
+      {
+        LocalArray<real, RefLagrangeBasis2D<P>::numShapes> phi = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>(numLocalNodes2D(p));
+        LocalArray<real, RefLagrangeBasis2D<P>::numShapes> coefficients = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>(numLocalNodes2D(p));
+        for (int K = begin; K < end; ++K)
+        {
+          if (offsets[K] == offsets[K + 1])
+            continue;
+
+          // Set up element once for all of its points
+          const ElementGeometry2D geometry = mesh.elementGeometry(K);
+          for (int j = 0; j < numLocalNodes2D(p); ++j)
+            coefficients[j] = shapeSign(K, j) * FENodes[connectivityMatrix[K][j]][varIndex];
+
+          for (int n = offsets[K]; n < offsets[K + 1]; ++n)
+          {
+            const int k = sortedPoints[n];
+            const std::array<real, 2> t = geometry.toReference(points[k][0], points[k][1]);
+            evaluateShapeFunctions2D<P>(basisType, p, geometry, t[0], t[1], xDerivativeOrder, yDerivativeOrder, phi.data());
+
+            real sum = 0.0;
+            for (int j = 0; j < numLocalNodes2D(p); ++j)
+              sum += coefficients[j] * phi[j];
+            values[k] = sum;
+          }
+        }
+      });
+    });
+    return values;
   }
 
   /*
     Outputs a file called "Plot.txt" that when graphed gives the
-    d-th derivative of the FE interpolation.
+    d-th derivative of the FE interpolation, and waits for the user
+    to press a key before removing it.
 
     \param n: Number of points to plot per direction per element.
   */
   void plot(const int varIndex, const int n = 1) const { plot(varIndex, n, 0, 0); }
   void plot(const int varIndex, const int n, const int xDerivativeOrder, const int yDerivativeOrder) const
   {
-    std::ofstream file("Plot.txt");
+    plot("Plot.txt", varIndex, n, xDerivativeOrder, yDerivativeOrder);
+    waitAndRemove("Plot.txt");
+  }
 
-    for (int K = 0; K < mesh.size; ++K)
+  /*
+    Same as above, but writes to the given file and returns immediately.
+    The file is left on disk.
+  */
+  void plot(const std::string& fileName, const int varIndex, const int n = 1, const int xDerivativeOrder = 0, const int yDerivativeOrder = 0) const
+  {
+    // Debug
+    ASSERT(varIndex >= 0, "Variable index must be non-negative");
+    ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+
+    writeElementSamples(fileName, n, xDerivativeOrder, yDerivativeOrder, [varIndex](TextChunk& chunk, const real x, const real y, const real* values)
     {
-      const MeshNode2D& A1 = mesh(K, 0);
-      const MeshNode2D& A2 = mesh(K, 1);
-      const MeshNode2D& A3 = mesh(K, 2);
-
-      // Create transformation matrix
-      Matrix B = Matrix(2);
-      B[0][0] = A2.x - A1.x;
-      B[0][1] = A3.x - A1.x;
-      B[1][0] = A2.y - A1.y;
-      B[1][1] = A3.y - A1.y;
-
-      for (int i = 0; i <= n; ++i)
-        for (int j = 0; j <= n - i; ++j)
-        {
-          // Create reference points
-          const real tx = (real)i / n;
-          const real ty = (real)j / n;
+      chunk.writeLine({ x, y, values[varIndex] });
+    });
+  }
 
-          // Transform points from reference domain to element K
-          const real x = B[0][0] * tx + B[0][1] * ty + A1.x;
-          const real y = B[1][0] * tx + B[1][1] * ty + A1.y;
+  /*
+    Outputs a file called "Plot.txt" containing the two variables of the
+    FE interpolation as a vector field, and waits for the user to press a
+    key before removing it.
 
-          file << x << ", " << y << ", " << evaluate(varIndex, x, y, K, xDerivativeOrder, yDerivativeOrder) << std::endl;
-        }
-    }
-    file.close();
-    std::cout << "Data written to \"Plot.txt\".  Press any key to continue" << std::endl;
-    std::cin.get();
-    remove("Plot.txt");
+    \param n: Number of points to plot per direction per element.
+  */
+  void plotField(const int n = 1) const
+  {
+    plotField("Plot.txt", n);
+    waitAndRemove("Plot.txt");
   }
 
-  void plotField(const int n = 1)
+  /*
+    Same as above, but writes to the given file and returns immediately.
+    The file is left on disk.
+  */
+  void plotField(const std::string& fileName, const int n = 1) const
   {
     ASSERT(N == 2, "Field plotting only supporting for two variable FEM structres");
-    std::ofstream file("Plot.txt");
 
-    for (int K = 0; K < mesh.size; ++K)
+    writeElementSamples(fileName, n, 0, 0, [](TextChunk& chunk, const real x, const real y, const real* values)
     {
-      const MeshNode2D& A1 = mesh(K, 0);
-      const MeshNode2D& A2 = mesh(K, 1);
-      const MeshNode2D& A3 = mesh(K, 2);
-
-      // Create transformation matrix
-      Matrix B = Matrix(2);
-      B[0][0] = A2.x - A1.x;
-      B[0][1] = A3.x - A1.x;
-      B[1][0] = A2.y - A1.y;
-      B[1][1] = A3.y - A1.y;
-
-      for (int i = 0; i <= n; ++i)
-        for (int j = 0; j <= n - i; ++j)
-        {
-          // Create reference points
-          const real tx = (real)i / n;
-          const real ty = (real)j / n;
+      chunk.writeLine({ x, y, values[0], values[1] });
+    });
+  }
 
-          // Transform points from reference domain to element K
-          const real x = B[0][0] * tx + B[0][1] * ty + A1.x;
-          const real y = B[1][0] * tx + B[1][1] * ty + A1.y;
+  /*
+    Samples the specified derivative of all variables on a uniform grid
+    with n + 1 points per side on every element, and writes a line
+    format(chunk, x, y, values) for each sample point to the given file.
 
-          file << x << ", " << y << ", ";
-          file << evaluate(0, x, y, K, 0, 0) << ", ";
-          file << evaluate(1, x, y, K, 0, 0) << std::endl;
+    Shape functions are tabulated once on the reference grid and mapped onto
+    each element, and elements are sampled in parallel, so format must be
+    safe to call concurrently.  Lines appear in the file in element order.
+  */
+  template<typename Format>
+  void writeElementSamples(const std::string& fileName, const int n, const int xDerivativeOrder, const int yDerivativeOrder, const Format& format) const
+  {
+    const int& p = polynomialOrder;
+    ASSERT(n > 0, "Number of plot points must be positive");
+
+    // Uniform grid on the reference triangle
+    std::vector<std::array<real, 2>> refPoints;
+    for (int i = 0; i <= n; ++i)
+      for (int j = 0; j <= n - i; ++j)
+        refPoints.push_back({ (real)i / n, (real)j / n });
+
+    dispatchPolynomialOrder(p, [&](auto order)
+    {
+      constexpr int P = decltype(order)::value;
+      const RefBasisTable2D<P> basis = RefBasisTable2D<P>(p, refPoints, basisType);
+
+      writeChunked(fileName, mesh.size, ElementGrainSize, [&](const int begin, const int end, TextChunk& chunk)
+      {
+        std::vector<typename RefBasisTable2D<P>::Row> phi = basis.makeTable();
+        real values[N];
+        for (int K = begin; K < end; ++K)
+        {
+          const ElementGeometry2D geometry = mesh.elementGeometry(K);
+          basis.mapToElement(geometry, xDerivativeOrder, yDerivativeOrder, phi);
+
+          for (int k = 0; k < basis.numPoints; ++k)
+          {
+            for (int v = 0; v < N; ++v)
+              values[v] = 0.0;
+            for (int j = 0; j < basis.numShapes; ++j)
+            {
+              const FENode2D<N>& node = FENodes[connectivityMatrix[K][j]];
+              const real shape = shapeSign(K, j) * phi[k][j];
+              for (int v = 0; v < N; ++v)
+                values[v] += node[v] * shape;
+            }
+
+            const std::array<real, 2> point = geometry.toLocal(refPoints[k][0], refPoints[k][1]);
+            format(chunk, point[0], point[1], values);
+          }
         }
-    }
-    file.close();
-    std::cout << "Data written to \"Plot.txt\".  Press any key to continue" << std::endl;
-    std::cin.get();
-    remove("Plot.txt");
+      });
+    });
   }
 
   /*
@@ -360,33 +614,7 @@ public:
   */
   bool isInTriangle(const real x, const real y, const int elementIndex) const
   {
-    const int& K = elementIndex;
-    const MeshNode2D& A1 = mesh(K, 0);
-    const MeshNode2D& A2 = mesh(K, 1);
-    const MeshNode2D& A3 = mesh(K, 2);
-
-    // Create transformation matrix from reference domain to K
-    Matrix B = Matrix(2);
-    B[0][0] = A2.x - A1.x;  B[0][1] = A3.x - A1.x;
-    B[1][0] = A2.y - A1.y;  B[1][1] = A3.y - A1.y;
-
-    // Invert matrix
-    const real determinant = B[0][0] * B[1][1] - B[0][1] * B[1][0];
-    ASSERT(determinant != 0.0, "Transformation matrix is singular");
-    real temp = B[0][0];
-    B[0][0] = B[1][1];
-    B[1][1] = temp;
-    B[0][1] *= -1;
-    B[1][0] *= -1;
-    B /= determinant;
-
-    const real tx = B[0][0] * (x - A1.x) + B[0][1] * (y - A1.y);
-    const real ty = B[1][0] * (x - A1.x) + B[1][1] * (y - A1.y);
-
-    if (tx > -1.0 * TOLERANCE && ty > -1.0 * TOLERANCE && ty < 1.0 - tx + TOLERANCE)
-      return true;
-    else
-      return false;
+    return mesh.isInElement(x, y, elementIndex);
   }
 
 private:
@@ -396,4 +624,10 @@ private:
     the indices of the nodes that belong to the i-th element.
   */
   Array2D<int> connectivityMatrix;
+
+  /*
+    For hierarchical bases, bit e of edgeFlips[K] is set if the e-th local edge
+    of element K runs against the direction of its mesh edge.  Empty otherwise.
+  */
+  std::vector<unsigned char> edgeFlips{};
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+#include "Precompilied.h"
+#include "FEM2D.h"
+
+/*
+  Values and first derivatives of all variables of a FEM2D at a point.
+*/
+template<int N>
+struct FieldSample2D
+{
+  real value[N];
+  real xDerivative[N];
+  real yDerivative[N];
+};
+
+/*
+  Evaluates a FEM2D at a sequence of points that move only a little
+  between queries, as in root finding or particle tracking.
+
+  The probe remembers the element that contained the last point and
+  walks from there to the element containing the next one, which for
+  nearby points costs about as much as checking a single element.
+  All variables and their first derivatives are evaluated at once.
+*/
+template<int N>
+class FieldProbe2D
+{
+public:
+  FieldProbe2D() = delete;
+
+  FieldProbe2D(const FEM2D<N>& FEfem)
+    : fem(FEfem)
+  {
+  }
+
+  /*
+    \returns the values and first derivatives of all variables at (x, y).
+  */
+  FieldSample2D<N> evaluate(const real x, const real y)
+  {
+    const int& p = fem.polynomialOrder;
+
+    // Find element containing (x, y), starting from the last one
+    const int K = lastElement < 0 ? fem.mesh.locate(x, y) : fem.mesh.walk(x, y, lastElement);
+    ASSERT(K >= 0, "x must be in the domain of the mesh");
+    if (K != lastElement)
+    {
+      geometry = fem.mesh.elementGeometry(K);
+      lastElement = K;
+    }
+
+    // Evaluate all shape functions and their derivatives on the reference domain
+    const std::array<real, 2> t = geometry.toReference(x, y);
+    FieldSample2D<N> sample = FieldSample2D<N>();
+    dispatchPolynomialOrder(p, [&](auto order)
+    {
+      constexpr int P = decltype(order)::value;
+      using Values = LocalArray<real, RefLagrangeBasis2D<P>::numShapes>;
+      Values phi = Values(numLocalNodes2D(p));
+      Values phi_x = Values(numLocalNodes2D(p));
+      Values phi_y = Values(numLocalNodes2D(p));
+      evaluateShapeFunctions2D<P>(fem.basisType, p, geometry, t[0], t[1], 0, 0, phi.data());
+      evaluateShapeFunctions2D<P>(fem.basisType, p, geometry, t[0], t[1], 1, 0, phi_x.data());
+      evaluateShapeFunctions2D<P>(fem.basisType, p, geometry, t[0], t[1], 0, 1, phi_y.data());
+
+      for (int v = 0; v < N; ++v)
+      {
+        sample.value[v] = 0.0;
+        sample.xDerivative[v] = 0.0;
+        sample.yDerivative[v] = 0.0;
+      }
+      for (int j = 0; j < numLocalNodes2D(p); ++j)
+      {
+        const FENode2D<N>& node = fem(K, j);
+        const real sign = fem.shapeSign(K, j);
+        for (int v = 0; v < N; ++v)
+        {
+          const real coefficient = sign * node[v];
+          sample.value[v] += coefficient * phi[j];
+          sample.xDerivative[v] += coefficient * phi_x[j];
+          sample.yDerivative[v] += coefficient * phi_y[j];
+        }
+      }
+    });
+    return sample;
+  }
+
+  /*
+    \returns the element that contained the last point, or -1 if there has not been one.
+  */
+  int element() const { return lastElement; }
+
+private:
+  const FEM2D<N>& fem;
+  int lastElement = -1;
+  ElementGeometry2D geometry{};
+};
@@ -14,12 +14,239 @@ Mesh2D::Mesh2D(Mesh2D&& other) noexcept
     connectivityMatrix(std::move(other.connectivityMatrix)),
     edgeArray(std::move(other.edgeArray)),
     edgeTypeMatrix(std::move(other.edgeTypeMatrix)),
-    edgeMatrix(std::move(other.edgeMatrix))
+    edgeMatrix(std::move(other.edgeMatrix)),
+    elementNeighbors(std::move(other.elementNeighbors)),
+    elementRegions(std::move(other.elementRegions)),
+    congruenceClasses(other.congruenceClasses.exchange(nullptr))
 {
   meshNodes = other.meshNodes;
   other.meshNodes = nullptr;
+
+  // The element grid refers to the mesh it was built from, so it is rebuilt on first use
+  delete other.elementGrid.exchange(nullptr);
+}
+
+MeshNode2D Mesh2D::node(const int nodeIndex) const
+{
+  // Debug
+  ASSERT(nodeIndex >= 0, "Node index must be non-negative");
+  ASSERT(nodeIndex < numNodes, "Node index must be less than the number of nodes");
+
+  return meshNodes[nodeIndex];
+}
+
+int Mesh2D::elementNode(const int elementIndex, const int i) const
+{
+  return connectivityMatrix[elementIndex][i];
+}
+
+int Mesh2D::edgeNode(const int edgeIndex, const int i) const
+{
+  return edgeArray[edgeIndex][i];
+}
+
+int Mesh2D::edgeIndex(const int I, const int J) const
+{
+  return edgeMatrix[I][J] - 1;
+}
+
+int Mesh2D::edgeType(const int I, const int J) const
+{
+  return edgeTypeMatrix[I][J];
+}
+
+int Mesh2D::elementNeighbor(const int elementIndex, const int i) const
+{
+  return elementNeighbors[elementIndex][i];
+}
+
+int Mesh2D::elementRegion(const int elementIndex) const
+{
+  // Debug
+  ASSERT(elementIndex >= 0, "Element index must be non-negative");
+  ASSERT(elementIndex < size, "Element index must be less than the number of elements");
+
+  return elementRegions.empty() ? 0 : elementRegions[elementIndex];
+}
+
+ElementGeometry2D Mesh2D::elementGeometry(const int elementIndex) const
+{
+  const int& K = elementIndex;
+  const MeshNode2D& A1 = (*this)(K, 0);
+  const MeshNode2D& A2 = (*this)(K, 1);
+  const MeshNode2D& A3 = (*this)(K, 2);
+
+  ElementGeometry2D geometry;
+  geometry.x0 = A1.x;
+  geometry.y0 = A1.y;
+  geometry.B[0][0] = A2.x - A1.x;  geometry.B[0][1] = A3.x - A1.x;
+  geometry.B[1][0] = A2.y - A1.y;  geometry.B[1][1] = A3.y - A1.y;
+
+  // Invert matrix
+  geometry.determinant = geometry.B[0][0] * geometry.B[1][1] - geometry.B[0][1] * geometry.B[1][0];
+  ASSERT(geometry.determinant != 0.0, "Transformation matrix is singular");
+  geometry.Binv[0][0] = geometry.B[1][1] / geometry.determinant;
+  geometry.Binv[0][1] = -geometry.B[0][1] / geometry.determinant;
+  geometry.Binv[1][0] = -geometry.B[1][0] / geometry.determinant;
+  geometry.Binv[1][1] = geometry.B[0][0] / geometry.determinant;
+
+  return geometry;
+}
+
+bool Mesh2D::isInElement(const real x, const real y, const int elementIndex) const
+{
+  const std::array<real, 2> t = elementGeometry(elementIndex).toReference(x, y);
+  const real& tx = t[0];
+  const real& ty = t[1];
+
+  return tx > -1.0 * TOLERANCE && ty > -1.0 * TOLERANCE && ty < 1.0 - tx + TOLERANCE;
+}
+
+int Mesh2D::locate(const real x, const real y) const
+{
+  // Build grid on first use
+  ElementGrid2D* grid = elementGrid.load(std::memory_order_acquire);
+  if (grid == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(elementGridMutex);
+    grid = elementGrid.load(std::memory_order_relaxed);
+    if (grid == nullptr)
+    {
+      grid = new ElementGrid2D(*this);
+      elementGrid.store(grid, std::memory_order_release);
+    }
+  }
+  return grid->locate(x, y);
+}
+
+int Mesh2D::congruenceClass(const int elementIndex) const
+{
+  // Debug
+  ASSERT(elementIndex >= 0, "Element index must be non-negative");
+  ASSERT(elementIndex < size, "Element index must be less than the number of elements");
+
+  return findCongruenceClasses().elementClasses[elementIndex];
+}
+
+int Mesh2D::numCongruenceClasses() const
+{
+  return (int)findCongruenceClasses().representatives.size();
+}
+
+int Mesh2D::congruenceClassElement(const int classIndex) const
+{
+  return findCongruenceClasses().representatives[classIndex];
+}
+
+int Mesh2D::walk(const real x, const real y, const int startElement) const
+{
+  // Debug
+  ASSERT(startElement >= 0, "Element index must be non-negative");
+  ASSERT(startElement < size, "Element index must be less than the number of elements");
+
+  int K = startElement;
+  for (int step = 0; step < size; ++step)
+  {
+    // Barycentric coordinates of (x, y) on K, the i-th one belongs to the i-th vertex
+    const std::array<real, 2> t = elementGeometry(K).toReference(x, y);
+    const real lambda[3] = { 1.0 - t[0] - t[1], t[0], t[1] };
+    if (lambda[0] > -1.0 * TOLERANCE && lambda[1] > -1.0 * TOLERANCE && lambda[2] > -1.0 * TOLERANCE)
+      return K;
+
+    // Cross the edge opposite the vertex with the most negative coordinate
+    int i = 0;
+    for (int v = 1; v < 3; ++v)
+      if (lambda[v] < lambda[i])
+        i = v;
+
+    // Walking only fails on the boundary of non-convex meshes
+    const int neighbor = elementNeighbor(K, i);
+    if (neighbor < 0)
+      break;
+    K = neighbor;
+  }
+  return locate(x, y);
+}
+
+void Mesh2D::formElementNeighbors()
+{
+  // Record the (at most two) elements on each edge
+  Array2D<int> edgeElements = Array2D<int>(numEdges, 2);
+  for (int e = 0; e < numEdges; ++e)
+  {
+    edgeElements[e][0] = -1;
+    edgeElements[e][1] = -1;
+  }
+  for (int K = 0; K < size; ++K)
+    for (int i = 0; i < 3; ++i)
+    {
+      const int& I = connectivityMatrix[K][(i + 1) % 3];
+      const int& J = connectivityMatrix[K][(i + 2) % 3];
+      const int e = edgeMatrix[I][J] - 1;
+      ASSERT(e >= 0, "Nodes I and J do not form an edge");
+
+      edgeElements[e][edgeElements[e][0] < 0 ? 0 : 1] = K;
+    }
+
+  elementNeighbors = Array2D<int>(size, 3);
+  for (int K = 0; K < size; ++K)
+    for (int i = 0; i < 3; ++i)
+    {
+      const int& I = connectivityMatrix[K][(i + 1) % 3];
+      const int& J = connectivityMatrix[K][(i + 2) % 3];
+      const int e = edgeMatrix[I][J] - 1;
+      elementNeighbors[K][i] = edgeElements[e][0] == K ? edgeElements[e][1] : edgeElements[e][0];
+    }
+}
+
+const CongruenceClasses2D& Mesh2D::findCongruenceClasses() const
+{
+  // Find classes on first use
+  CongruenceClasses2D* classes = congruenceClasses.load(std::memory_order_acquire);
+  if (classes != nullptr)
+    return *classes;
+
+  std::lock_guard<std::mutex> lock(congruenceClassesMutex);
+  classes = congruenceClasses.load(std::memory_order_relaxed);
+  if (classes != nullptr)
+    return *classes;
+
+  classes = new CongruenceClasses2D();
+  classes->elementClasses = std::vector<int>(size, -1);
+  std::vector<ElementGeometry2D> classGeometries;
+  for (int K = 0; K < size; ++K)
+  {
+    const ElementGeometry2D geometry = elementGeometry(K);
+
+    int& c = classes->elementClasses[K];
+    for (int i = 0; i < (int)classGeometries.size() && c < 0; ++i)
+    {
+      const real (&B)[2][2] = classGeometries[i].B;
+      const real scale = std::max({ std::abs(B[0][0]), std::abs(B[0][1]), std::abs(B[1][0]), std::abs(B[1][1]) });
+      bool congruent = true;
+      for (int j = 0; j < 2; ++j)
+        for (int k = 0; k < 2; ++k)
+          if (std::abs(geometry.B[j][k] - B[j][k]) > CongruenceTolerance * scale)
+            congruent = false;
+      if (congruent)
+        c = i;
+    }
+
+    if (c < 0 && (int)classGeometries.size() < MaxCongruenceClasses)
+    {
+      c = (int)classGeometries.size();
+      classGeometries.push_back(geometry);
+      classes->representatives.push_back(K);
+    }
+  }
+
+  congruenceClasses.store(classes, std::memory_order_release);
+  return *classes;
 }
 
 Mesh2D::~Mesh2D()
 {
+  delete[] meshNodes;
+  delete elementGrid.load();
+  delete congruenceClasses.load();
 }
\ No newline at end of file
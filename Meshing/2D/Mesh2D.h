@@ -3,6 +3,46 @@
 #include "Meshing/BoundayEnums.h"
 #include "Meshing/Nodes.h"
 #include "Utilities/Array2D.h"
+#include "ElementGrid2D.h"
+
+/*
+  Affine map from the reference triangle [(0, 0), (1, 0), (0, 1)]
+  onto a mesh element, (x, y) = B * (tx, ty) + (x0, y0).
+*/
+struct ElementGeometry2D
+{
+  real x0 = 0.0;
+  real y0 = 0.0;
+  real B[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+  real Binv[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+  real determinant = 0.0;
+
+  /*
+    Maps a point on the reference triangle onto the element.
+  */
+  std::array<real, 2> toLocal(const real tx, const real ty) const
+  {
+    return { B[0][0] * tx + B[0][1] * ty + x0, B[1][0] * tx + B[1][1] * ty + y0 };
+  }
+
+  /*
+    Maps a point on the element back onto the reference triangle.
+  */
+  std::array<real, 2> toReference(const real x, const real y) const
+  {
+    return { Binv[0][0] * (x - x0) + Binv[0][1] * (y - y0), Binv[1][0] * (x - x0) + Binv[1][1] * (y - y0) };
+  }
+};
+
+/*
+  Partition of the elements of a mesh into classes of congruent elements,
+  see Mesh2D::congruenceClass.
+*/
+struct CongruenceClasses2D
+{
+  std::vector<int> elementClasses{};   // Class of each element, or -1
+  std::vector<int> representatives{};  // An element of each class
+};
 
 /*
   Interface for a general 2D mesh.
@@ -53,9 +93,23 @@ public:
   */
   Array2D<int> edgeMatrix{};
 
+  /*
+    A 2D array that stores which elements are adjacent to each other.
+
+    elementNeighbors[K][i] gives the index of the element that shares the edge
+    opposite the i-th vertex of the K-th element, or -1 if that edge is on the boundary.
+  */
+  Array2D<int> elementNeighbors{};
+
   // Stores the x,y-values and boundary conditions of all the nodes in the mesh
   MeshNode2D* meshNodes = nullptr;
 
+  /*
+    Region tag of each element, such as the material it is made of.
+    Empty if the mesh has no region tags, in which case all elements are in region 0.
+  */
+  std::vector<int> elementRegions{};
+
   Mesh2D() = delete;
 
   Mesh2D(const int n, const int nodes, const int edges);
@@ -68,5 +122,119 @@ public:
 
   virtual MeshNode2D operator()(const int elementIndex, const int nodeIndex) const = 0;
 
+  /*
+    The following give access to the nodes and topology of the mesh.
+    By default they read the arrays above, but meshes that can compute
+    them on demand may leave those arrays empty and override these instead,
+    so code that should work on any mesh must use these.
+  */
+
+  /*
+    \returns the x,y-values and boundary condition of the specified node.
+  */
+  virtual MeshNode2D node(const int nodeIndex) const;
+
+  /*
+    \returns the index of the i-th vertex of the specified element, see connectivityMatrix.
+  */
+  virtual int elementNode(const int elementIndex, const int i) const;
+
+  /*
+    \returns the index of the i-th of the two nodes of the specified edge, see edgeArray.
+  */
+  virtual int edgeNode(const int edgeIndex, const int i) const;
+
+  /*
+    \returns the index of the edge formed by nodes I and J,
+    or -1 if they do not form an edge, see edgeMatrix.
+  */
+  virtual int edgeIndex(const int I, const int J) const;
+
+  /*
+    \returns how nodes I and J are connected, see edgeTypeMatrix.
+  */
+  virtual int edgeType(const int I, const int J) const;
+
+  /*
+    \returns the index of the element that shares the edge opposite the i-th vertex
+    of the specified element, or -1 if that edge is on the boundary, see elementNeighbors.
+  */
+  virtual int elementNeighbor(const int elementIndex, const int i) const;
+
+  /*
+    \returns the region tag of the specified element, see elementRegions.
+  */
+  int elementRegion(const int elementIndex) const;
+
+  /*
+    \returns the affine map from the reference triangle onto the specified element.
+  */
+  virtual ElementGeometry2D elementGeometry(const int elementIndex) const;
+
+  /*
+    Elements whose maps from the reference triangle have the same matrix B
+    (up to a relative tolerance of CongruenceTolerance) are translates of
+    each other.  They share their element matrices for any coefficient that
+    is constant on them, so assembly computes those only once per class.
+
+    \returns the index of the congruence class of the specified element, or -1
+    if it is not in one of the first MaxCongruenceClasses classes found.
+
+    Classes are found by comparing all elements, on the first call.
+  */
+  virtual int congruenceClass(const int elementIndex) const;
+
+  /*
+    \returns the number of congruence classes.
+  */
+  virtual int numCongruenceClasses() const;
+
+  /*
+    \returns the index of an element of the specified congruence class.
+  */
+  virtual int congruenceClassElement(const int classIndex) const;
+
+  static constexpr int MaxCongruenceClasses = 8;
+  static constexpr real CongruenceTolerance = 1e-12;
+
+  /*
+    Determines if the given point (x, y) is inside the specified element.
+  */
+  bool isInElement(const real x, const real y, const int elementIndex) const;
+
+  /*
+    \returns the index of an element that contains (x, y),
+    or -1 if (x, y) is not inside the mesh.
+
+    Uses a bucket grid over the elements, which is built on the first call.
+  */
+  virtual int locate(const real x, const real y) const;
+
+  /*
+    \returns the index of an element that contains (x, y),
+    or -1 if (x, y) is not inside the mesh.
+
+    Walks from the given element towards (x, y) across element edges,
+    so this is much faster than locate when (x, y) is close to startElement.
+  */
+  int walk(const real x, const real y, const int startElement) const;
+
   virtual ~Mesh2D();
+
+protected:
+  /*
+    Forms elementNeighbors from the connectivity and edge matrices.
+  */
+  void formElementNeighbors();
+
+private:
+  mutable std::atomic<ElementGrid2D*> elementGrid{ nullptr };
+  mutable std::mutex elementGridMutex;
+  mutable std::atomic<CongruenceClasses2D*> congruenceClasses{ nullptr };
+  mutable std::mutex congruenceClassesMutex;
+
+  /*
+    \returns the congruence classes of the elements, which are found on the first call.
+  */
+  const CongruenceClasses2D& findCongruenceClasses() const;
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include "Precompilied.h"
+#include "FEM2D.h"
+
+/*
+  Copies of the solution of a FEM2D, taken so that they can be written
+  out on a background thread (see Utilities/OutputQueue.h) while the
+  FEM2D itself is already being overwritten by the next solve.
+
+  A fixed number of snapshot buffers, each a FEM2D of the same order on
+  the same mesh, is allocated up front (two gives double buffering), so
+  taking a snapshot is a single copy of the node array.  A snapshot is
+  handed out as a shared pointer that returns its buffer to the pool once
+  the last copy of it is gone.  If all buffers are still in use, taking a
+  snapshot blocks until one is returned, which limits how far the solver
+  can run ahead of the output.
+
+  The pool waits for all of its snapshots to be returned before it is destroyed.
+*/
+template<int N>
+class SnapshotPool2D
+{
+public:
+  SnapshotPool2D() = delete;
+
+  SnapshotPool2D(const FEM2D<N>& FEfem, const int numBuffers = 2)
+    : fem(FEfem)
+  {
+    ASSERT(numBuffers > 0, "Pool must have at least one buffer");
+
+    const BoundaryConditions2D boundaryConditions = fem.boundaryConditions();
+    for (int i = 0; i < numBuffers; ++i)
+      buffers.emplace_back(new FEM2D<N>(fem.mesh, fem.polynomialOrder, boundaryConditions, fem.basisType));
+    for (int i = 0; i < numBuffers; ++i)
+      freeBuffers.push_back(buffers[i].get());
+  }
+
+  SnapshotPool2D(const SnapshotPool2D& other) = delete;
+
+  SnapshotPool2D& operator=(const SnapshotPool2D& other) = delete;
+
+  ~SnapshotPool2D()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    bufferReturned.wait(lock, [this]() { return freeBuffers.size() == buffers.size(); });
+  }
+
+  /*
+    \returns a copy of the current state of the FEM2D of the pool.
+    Blocks while all buffers are in use.
+  */
+  std::shared_ptr<const FEM2D<N>> snapshot()
+  {
+    FEM2D<N>* buffer = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      bufferReturned.wait(lock, [this]() { return !freeBuffers.empty(); });
+      buffer = freeBuffers.back();
+      freeBuffers.pop_back();
+    }
+
+    buffer->copyNodes(fem);
+    return std::shared_ptr<const FEM2D<N>>(buffer, [this](const FEM2D<N>* returned)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(const_cast<FEM2D<N>*>(returned));
+      }
+      bufferReturned.notify_all();
+    });
+  }
+
+private:
+  const FEM2D<N>& fem;
+  std::vector<std::unique_ptr<FEM2D<N>>> buffers;
+  std::vector<FEM2D<N>*> freeBuffers;
+  std::mutex mutex;
+  std::condition_variable bufferReturned;
+};
@@ -1,13 +1,45 @@
 #include "Precompilied.h"
 #include "UniformRectangularMesh2D.h"
 
-UniformRectangularMesh2D::UniformRectangularMesh2D(const real xMin, const real xMax, const real yMin, const real yMax, const int nx, const int ny)
+/*
+  \returns the affine map from the reference triangle onto the triangle
+  with vertices (0, 0), (x2, y2), (x3, y3).
+*/
+static ElementGeometry2D triangleGeometry(const real x2, const real y2, const real x3, const real y3)
+{
+  ElementGeometry2D geometry;
+  geometry.B[0][0] = x2;  geometry.B[0][1] = x3;
+  geometry.B[1][0] = y2;  geometry.B[1][1] = y3;
+
+  // Invert matrix
+  geometry.determinant = geometry.B[0][0] * geometry.B[1][1] - geometry.B[0][1] * geometry.B[1][0];
+  ASSERT(geometry.determinant != 0.0, "Transformation matrix is singular");
+  geometry.Binv[0][0] = geometry.B[1][1] / geometry.determinant;
+  geometry.Binv[0][1] = -geometry.B[0][1] / geometry.determinant;
+  geometry.Binv[1][0] = -geometry.B[1][0] / geometry.determinant;
+  geometry.Binv[1][1] = geometry.B[0][0] / geometry.determinant;
+
+  return geometry;
+}
+
+UniformRectangularMesh2D::UniformRectangularMesh2D(const real xMin, const real xMax, const real yMin, const real yMax, const int nx, const int ny,
+                                                   const MeshStorage storage)
   : Mesh2D(2 * nx * ny, (nx + 1)* (ny + 1), 5 + 4 * (nx + ny - 2) + 3 * (nx - 1) * (ny - 1)),
-    xL(xMin), xR(xMax), yL(yMin), yR(yMax)
+    xL(xMin), xR(xMax), yL(yMin), yR(yMax),
+    nx(nx), ny(ny),
+    storage(storage),
+    dx((xMax - xMin) / nx), dy((yMax - yMin) / ny)
 {
   // Debug
   ASSERT(size > 0, "Invalid mesh size: A mesh must have a least one element!");
 
+  lowerGeometry = triangleGeometry(dx, 0.0, dx, dy);
+  upperGeometry = triangleGeometry(0.0, dy, dx, dy);
+
+  // Everything else is computed on demand
+  if (storage == MeshStorage::Implicit)
+    return;
+
   // Initialize data structures
   meshNodes = new MeshNode2D[numNodes];
   connectivityMatrix = Array2D<int>(size, 3);
@@ -15,9 +47,6 @@ UniformRectangularMesh2D::UniformRectangularMesh2D(const real xMin, const real x
   edgeTypeMatrix = Array2D<int>(numNodes, numNodes);
   edgeMatrix = Array2D<int>(numNodes, numNodes);
 
-  const real dx = (xMax - xMin) / nx;
-  const real dy = (yMax - yMin) / ny;
-
   // Set node coordinates
   for (int i = 0; i < ny + 1; ++i)
     for (int j = 0; j < nx + 1; ++j)
@@ -25,6 +54,7 @@ UniformRectangularMesh2D::UniformRectangularMesh2D(const real xMin, const real x
 #pragma warning(suppress: 6386)
       meshNodes[i * (nx+1) + j].x = xMin + j * dx;
       meshNodes[i * (nx+1) + j].y = yMin + i * dy;
+      meshNodes[i * (nx+1) + j].isCorner = isCornerNode(i, j);
     }
   
   // Form connectivity matrix
@@ -86,12 +116,20 @@ UniformRectangularMesh2D::UniformRectangularMesh2D(const real xMin, const real x
     edgeMatrix[edgeArray[i][0]][edgeArray[i][1]] = i + 1;
     edgeMatrix[edgeArray[i][1]][edgeArray[i][0]] = i + 1;
   }
+
+  formElementNeighbors();
 }
 
 UniformRectangularMesh2D::UniformRectangularMesh2D(UniformRectangularMesh2D&& other) noexcept
-  : Mesh2D(other.size, other.numNodes, other.numEdges),
-    xL(other.xL), xR(other.xR), yL(other.yL), yR(other.yR)
+  : Mesh2D(std::move(other)),
+    xL(other.xL), xR(other.xR), yL(other.yL), yR(other.yR),
+    nx(other.nx), ny(other.ny),
+    storage(other.storage),
+    dx(other.dx), dy(other.dy),
+    lowerGeometry(other.lowerGeometry),
+    upperGeometry(other.upperGeometry)
 {
+  std::copy(other.sideBCs, other.sideBCs + 4, sideBCs);
 }
 
 MeshNode2D UniformRectangularMesh2D::operator()(const int elementIndex, const int nodeIndex) const
@@ -102,7 +140,187 @@ MeshNode2D UniformRectangularMesh2D::operator()(const int elementIndex, const in
   ASSERT(nodeIndex >= 0, "Node index must be non-negative");
   ASSERT(nodeIndex < 3, "Node index must be less than 3 on a triangular mesh");
 
-  return meshNodes[connectivityMatrix[elementIndex][nodeIndex]];
+  return node(elementNode(elementIndex, nodeIndex));
+}
+
+MeshNode2D UniformRectangularMesh2D::node(const int nodeIndex) const
+{
+  // Debug
+  ASSERT(nodeIndex >= 0, "Node index must be non-negative");
+  ASSERT(nodeIndex < numNodes, "Node index must be less than the number of nodes");
+
+  if (storage == MeshStorage::Explicit)
+    return meshNodes[nodeIndex];
+
+  const int i = nodeIndex / (nx + 1);
+  const int j = nodeIndex % (nx + 1);
+
+  MeshNode2D A;
+  A.x = xL + j * dx;
+  A.y = yL + i * dy;
+  A.BC = nodeBoundaryCondition(i, j, sideBCs);
+  A.isCorner = isCornerNode(i, j);
+  return A;
+}
+
+int UniformRectangularMesh2D::elementNode(const int elementIndex, const int i) const
+{
+  const int& K = elementIndex;
+  const int botLeft = (K / 2 / nx) * (nx + 1) + (K / 2) % nx;
+  const int topRight = botLeft + nx + 2;
+
+  if (i == 0)
+    return botLeft;
+  if (i == 2)
+    return topRight;
+  return K % 2 == 0 ? botLeft + 1 : botLeft + nx + 1;
+}
+
+int UniformRectangularMesh2D::edgeNode(const int edgeIndex, const int i) const
+{
+  // Debug
+  ASSERT(edgeIndex >= 0, "Edge index must be non-negative");
+  ASSERT(edgeIndex < numEdges, "Edge index must be less than the number of edges");
+
+  // Below the top row, each node has edges to its right, upper and upper right
+  // neighbors, in that order, except for the last node of a row
+  const int rowEdges = 3 * nx + 1;
+  int lower, upper;
+  if (edgeIndex < ny * rowEdges)
+  {
+    const int row = edgeIndex / rowEdges;
+    const int column = edgeIndex % rowEdges / 3;
+    const int direction = column < nx ? edgeIndex % rowEdges % 3 : 1;
+    lower = row * (nx + 1) + column;
+    upper = lower + (direction == 0 ? 1 : nx + direction);
+  }
+  else
+  {
+    lower = ny * (nx + 1) + edgeIndex - ny * rowEdges;
+    upper = lower + 1;
+  }
+  return i == 0 ? lower : upper;
+}
+
+int UniformRectangularMesh2D::edgeIndex(const int I, const int J) const
+{
+  const int lower = std::min(I, J);
+  const int distance = std::max(I, J) - lower;
+  const int row = lower / (nx + 1);
+  const int column = lower % (nx + 1);
+
+  const int first = row < ny ? row * (3 * nx + 1) + 3 * column : ny * (3 * nx + 1) + column;
+  if (distance == 1 && column < nx)
+    return first;
+  if (distance == nx + 1 && row < ny)
+    return column < nx ? first + 1 : first;
+  if (distance == nx + 2 && row < ny && column < nx)
+    return first + 2;
+  return -1;
+}
+
+int UniformRectangularMesh2D::edgeType(const int I, const int J) const
+{
+  if (I == J)
+  {
+    // Count the elements around the node, the rectangles to its upper right and
+    // lower left contribute two, the others one
+    const int i = I / (nx + 1);
+    const int j = I % (nx + 1);
+    int numElements = 0;
+    if (i < ny && j < nx)
+      numElements += 2;
+    if (i < ny && j > 0)
+      numElements += 1;
+    if (i > 0 && j > 0)
+      numElements += 2;
+    if (i > 0 && j < nx)
+      numElements += 1;
+    return numElements;
+  }
+
+  if (edgeIndex(I, J) < 0)
+    return 0;
+
+  const int lower = std::min(I, J);
+  const int distance = std::max(I, J) - lower;
+  const int row = lower / (nx + 1);
+  const int column = lower % (nx + 1);
+  if (distance == 1)
+    return row == 0 || row == ny ? 1 : 2;
+  if (distance == nx + 1)
+    return column == 0 || column == nx ? 1 : 2;
+  return 2;
+}
+
+int UniformRectangularMesh2D::elementNeighbor(const int elementIndex, const int i) const
+{
+  const int& K = elementIndex;
+  const int row = K / 2 / nx;
+  const int column = K / 2 % nx;
+
+  if (i == 1)
+    return K % 2 == 0 ? K + 1 : K - 1;
+
+  if (K % 2 == 0)
+  {
+    if (i == 0)
+      return column + 1 < nx ? 2 * (row * nx + column + 1) + 1 : -1;
+    return row > 0 ? 2 * ((row - 1) * nx + column) + 1 : -1;
+  }
+  else
+  {
+    if (i == 0)
+      return row + 1 < ny ? 2 * ((row + 1) * nx + column) : -1;
+    return column > 0 ? 2 * (row * nx + column - 1) : -1;
+  }
+}
+
+ElementGeometry2D UniformRectangularMesh2D::elementGeometry(const int elementIndex) const
+{
+  // Debug
+  ASSERT(elementIndex >= 0, "Element index must be non-negative");
+  ASSERT(elementIndex < size, "Element index must be less than the number of elements");
+
+  const int& K = elementIndex;
+  ElementGeometry2D geometry = K % 2 == 0 ? lowerGeometry : upperGeometry;
+  geometry.x0 = xL + (K / 2 % nx) * dx;
+  geometry.y0 = yL + (K / 2 / nx) * dy;
+  return geometry;
+}
+
+int UniformRectangularMesh2D::congruenceClass(const int elementIndex) const
+{
+  return elementIndex % 2;
+}
+
+int UniformRectangularMesh2D::numCongruenceClasses() const
+{
+  return 2;
+}
+
+int UniformRectangularMesh2D::congruenceClassElement(const int classIndex) const
+{
+  return classIndex;
+}
+
+int UniformRectangularMesh2D::locate(const real x, const real y) const
+{
+  // Local coordinates in units of rectangles
+  const real s = (x - xL) / dx;
+  const real t = (y - yL) / dy;
+  if (s < -TOLERANCE || s > nx + TOLERANCE || t < -TOLERANCE || t > ny + TOLERANCE)
+    return -1;
+
+  // Find rectangle, points on the edge between two rectangles belong to
+  // the one with the lower index, like in a search over all elements
+  const int j = std::max(0, std::min(nx - 1, (int)std::ceil(s) - 1));
+  const int i = std::max(0, std::min(ny - 1, (int)std::ceil(t) - 1));
+
+  // Rectangles are bisected along the diagonal from bottom left to top right,
+  // with the lower right triangle coming first
+  const int K = 2 * (i * nx + j);
+  return t - i <= s - j ? K : K + 1;
 }
 
 void UniformRectangularMesh2D::setBoundaryConditions(const BC_Type boundaryCondition)
@@ -115,27 +333,60 @@ void UniformRectangularMesh2D::setBoundaryConditions(const BC_Type leftBoundaryC
                                                      const BC_Type bottomBoundaryCondition,
                                                      const BC_Type topBoundaryCondition)
 {
-  // Find edge nodes
-  for (int i = 0; i < numNodes; ++i)
-  {
-    if (meshNodes[i].x == xL)
-      meshNodes[i].BC = leftBoundaryCondition;
-    if (meshNodes[i].x == xR)
-      meshNodes[i].BC = rightBoundaryCondition;
-    if (meshNodes[i].y == yL)
-      meshNodes[i].BC = bottomBoundaryCondition;
-    if (meshNodes[i].y == yR)
-      meshNodes[i].BC = topBoundaryCondition;
-  }
+  sideBCs[0] = leftBoundaryCondition;
+  sideBCs[1] = rightBoundaryCondition;
+  sideBCs[2] = bottomBoundaryCondition;
+  sideBCs[3] = topBoundaryCondition;
 
-  // Find corner nodes
-  for (int i = 0; i < numNodes; ++i)
-    if ((meshNodes[i].x == xL || meshNodes[i].x == xR) && (meshNodes[i].y == yL || meshNodes[i].y == yR))
-      meshNodes[i].isCorner = true;
-
-  // Count number of boundary nodes
   numBoundaryNodes = 0;
-  for (int i = 0; i < numNodes; ++i)
-    if ((int)meshNodes[i].BC >= 0)
-      ++numBoundaryNodes;
+  for (int i = 0; i < ny + 1; ++i)
+    for (int j = 0; j < nx + 1; ++j)
+    {
+      const BC_Type BC = nodeBoundaryCondition(i, j, sideBCs);
+      if (storage == MeshStorage::Explicit)
+        meshNodes[i * (nx + 1) + j].BC = BC;
+      if ((int)BC >= 0)
+        ++numBoundaryNodes;
+    }
+}
+
+BoundaryConditions2D UniformRectangularMesh2D::boundaryConditions(const BC_Type boundaryCondition) const
+{
+  return boundaryConditions(boundaryCondition, boundaryCondition, boundaryCondition, boundaryCondition);
+}
+
+BoundaryConditions2D UniformRectangularMesh2D::boundaryConditions(const BC_Type leftBoundaryCondition,
+                                                                  const BC_Type rightBoundaryCondition,
+                                                                  const BC_Type bottomBoundaryCondition,
+                                                                  const BC_Type topBoundaryCondition) const
+{
+  const BC_Type sides[4] = { leftBoundaryCondition, rightBoundaryCondition, bottomBoundaryCondition, topBoundaryCondition };
+
+  BoundaryConditions2D layer = BoundaryConditions2D(numNodes);
+  for (int i = 0; i < ny + 1; ++i)
+    for (int j = 0; j < nx + 1; ++j)
+    {
+      layer.set(i * (nx + 1) + j, nodeBoundaryCondition(i, j, sides));
+      layer.cornerNodes[i * (nx + 1) + j] = isCornerNode(i, j);
+    }
+  return layer;
+}
+
+BC_Type UniformRectangularMesh2D::nodeBoundaryCondition(const int i, const int j, const BC_Type (&sides)[4]) const
+{
+  BC_Type BC = BC_Type::Interior;
+  if (j == 0)
+    BC = sides[0];
+  if (j == nx)
+    BC = sides[1];
+  if (i == 0)
+    BC = sides[2];
+  if (i == ny)
+    BC = sides[3];
+  return BC;
+}
+
+bool UniformRectangularMesh2D::isCornerNode(const int i, const int j) const
+{
+  return (j == 0 || j == nx) && (i == 0 || i == ny);
 }
@@ -1,12 +1,36 @@
 #pragma once
 #include "Precompilied.h"
 #include "Mesh2D.h"
+#include "BoundaryConditions2D.h"
 #include "Utilities/Array2D.h"
 #include "Utilities/Print.h"
 #include "Meshing/BoundayEnums.h"
 
+/*
+  How a UniformRectangularMesh2D stores its nodes and topology.
+
+  Explicit: Nodes, connectivity and edges are stored in the arrays of Mesh2D,
+            which takes memory quadratic in the number of nodes.
+  Implicit: Nothing is stored, all of it is computed on demand from the
+            (i, j) indices of nodes and rectangles.  The arrays of Mesh2D
+            stay empty, so the mesh can only be used through its accessors.
+*/
+enum class MeshStorage
+{
+  Explicit,
+  Implicit
+};
+
 /*
   A rectangular 2D mesh consisting of uniform triangular elements.
+
+  Node (i, j) is the j-th node from the left in the i-th row from the bottom
+  and has index i * (nx + 1) + j.  Rectangle (i, j) is bisected along its
+  diagonal from bottom left to top right into elements 2 * (i * nx + j)
+  (lower right) and 2 * (i * nx + j) + 1 (upper left).  Edges are numbered
+  in order of their lower node index, then of their upper node index, like
+  in any other mesh.  In either storage mode the topology and element
+  geometry are computed in closed form.
 */
 class UniformRectangularMesh2D : public Mesh2D
 {
@@ -19,8 +43,10 @@ public:
 
     \param nx: Number of elements along the x direction.
     \param ny: Number of elements along the y direction.
+    \param storage: Whether the nodes and topology are stored or computed on demand.
   */
-  UniformRectangularMesh2D(const real xMin, const real xMax, const real yMin, const real yMax, const int nx, const int ny);
+  UniformRectangularMesh2D(const real xMin, const real xMax, const real yMin, const real yMax, const int nx, const int ny,
+                           const MeshStorage storage = MeshStorage::Explicit);
 
   UniformRectangularMesh2D(const UniformRectangularMesh2D& other) = delete;
 
@@ -30,13 +56,77 @@ public:
 
   MeshNode2D operator()(const int elementIndex, const int nodeIndex) const override;
 
+  MeshNode2D node(const int nodeIndex) const override;
+
+  int elementNode(const int elementIndex, const int i) const override;
+
+  int edgeNode(const int edgeIndex, const int i) const override;
+
+  int edgeIndex(const int I, const int J) const override;
+
+  int edgeType(const int I, const int J) const override;
+
+  int elementNeighbor(const int elementIndex, const int i) const override;
+
+  /*
+    \returns the affine map from the reference triangle onto the specified element.
+    All lower right and all upper left elements are translates of each other.
+  */
+  ElementGeometry2D elementGeometry(const int elementIndex) const override;
+
+  /*
+    Lower right elements form congruence class 0 and upper left elements class 1.
+  */
+  int congruenceClass(const int elementIndex) const override;
+
+  int numCongruenceClasses() const override;
+
+  int congruenceClassElement(const int classIndex) const override;
+
+  /*
+    \returns the index of the element that contains (x, y),
+    or -1 if (x, y) is not inside the mesh.
+
+    Computed directly from the coordinates of (x, y).
+  */
+  int locate(const real x, const real y) const override;
+
   void setBoundaryConditions(const BC_Type boundaryCondition);
 
   void setBoundaryConditions(const BC_Type leftBoundaryCondition,
                              const BC_Type rightBoundaryCondition,
-                             const BC_Type topBoundaryCondition,
-                             const BC_Type bottomBoundaryCondition);
+                             const BC_Type bottomBoundaryCondition,
+                             const BC_Type topBoundaryCondition);
+
+  /*
+    \returns a boundary condition layer with the given conditions on each
+    side of the rectangle, for FE spaces that need different boundary
+    conditions on the same mesh.  The mesh itself is not modified.
+  */
+  BoundaryConditions2D boundaryConditions(const BC_Type boundaryCondition) const;
+
+  BoundaryConditions2D boundaryConditions(const BC_Type leftBoundaryCondition,
+                                          const BC_Type rightBoundaryCondition,
+                                          const BC_Type bottomBoundaryCondition,
+                                          const BC_Type topBoundaryCondition) const;
 
 private:
   const real xL, xR, yL, yR;
+  const int nx, ny;
+  const MeshStorage storage;
+  const real dx, dy;
+
+  // Maps of the lower right and upper left elements of the rectangle at the origin
+  ElementGeometry2D lowerGeometry, upperGeometry;
+
+  // Boundary conditions on the left, right, bottom and top sides, used in implicit storage
+  BC_Type sideBCs[4] = { BC_Type::Interior, BC_Type::Interior, BC_Type::Interior, BC_Type::Interior };
+
+  /*
+    \returns the boundary condition of node (i, j) for the given conditions on the
+    left, right, bottom and top sides.  Corners take the condition of the bottom or top side.
+  */
+  BC_Type nodeBoundaryCondition(const int i, const int j, const BC_Type (&sides)[4]) const;
+
+  bool isCornerNode(const int i, const int j) const;
 };
\ No newline at end of file
@@ -83,8 +83,9 @@ UnstructuredMesh2D::UnstructuredMesh2D(const std::string meshFile)
   edgeArray = Array2D<int>(numEdges, 2);
   edgeTypeMatrix = Array2D<int>(numNodes, numNodes);
   edgeMatrix = Array2D<int>(numNodes, numNodes);
+  elementRegions = std::vector<int>(size, 0);
 
-  // Set node coordinates and connectivity matrix
+  // Set node coordinates, connectivity matrix and region tags
   std::ifstream file(meshFile);
   std::string line;
   int nodeIndex = 0;
@@ -122,6 +123,8 @@ UnstructuredMesh2D::UnstructuredMesh2D(const std::string meshFile)
         std::vector<double> element = split(line, ' ');
         for (int i = 0; i < 3; ++i)
           connectivityMatrix[elementIndex][i] = (int)element[i];
+        if (element.size() > 3)
+          elementRegions[elementIndex] = (int)element[3];
 
         getline(file, line);
         ++elementIndex;
@@ -167,6 +170,8 @@ UnstructuredMesh2D::UnstructuredMesh2D(const std::string meshFile)
     edgeMatrix[edgeArray[i][0]][edgeArray[i][1]] = i + 1;
     edgeMatrix[edgeArray[i][1]][edgeArray[i][0]] = i + 1;
   }
+
+  formElementNeighbors();
 }
 
 UnstructuredMesh2D::UnstructuredMesh2D(UnstructuredMesh2D&& other) noexcept
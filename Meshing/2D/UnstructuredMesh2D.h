@@ -14,6 +14,9 @@
     2) A list of which nodes belong to which elements
     (to form connectivity matrix), beginning with the
     line ">StartElements" and ending with ">EndElements".
+    Each line may have a fourth column with the region
+    tag of the element (see Mesh2D::elementRegions),
+    elements without one are in region 0.
 
   Note: Boundary conditions have not been implemented for this mesh!
 */
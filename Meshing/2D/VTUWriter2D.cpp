@@ -0,0 +1,181 @@
+#include "Precompilied.h"
+#include "VTUWriter2D.h"
+
+// Number of tuples generated and written at a time
+static constexpr int blockSize = 4096;
+
+// VTK cell types
+static constexpr unsigned char VTK_TRIANGLE = 5;
+static constexpr unsigned char VTK_QUADRATIC_TRIANGLE = 22;
+
+/*
+  Writes an array of numTuples x numComponents values of type T to the appended
+  data section, preceded by its size in bytes.  generate(begin, end, values)
+  must fill values with tuples [begin, end).
+*/
+template<typename T, typename Generate>
+static void writeAppendedArray(std::ofstream& file, const int numTuples, const int numComponents, const Generate& generate)
+{
+  const uint64_t numBytes = (uint64_t)numTuples * numComponents * sizeof(T);
+  file.write((const char*)&numBytes, sizeof(numBytes));
+
+  std::vector<T> block = std::vector<T>(blockSize * numComponents);
+  for (int begin = 0; begin < numTuples; begin += blockSize)
+  {
+    const int end = std::min(begin + blockSize, numTuples);
+    generate(begin, end, block.data());
+    file.write((const char*)block.data(), (std::streamsize)(end - begin) * numComponents * sizeof(T));
+  }
+}
+
+/*
+  \returns the number of bytes an array takes up in the appended data section, including its size header.
+*/
+static uint64_t appendedArraySize(const int numTuples, const int numComponents, const int bytesPerValue)
+{
+  return sizeof(uint64_t) + (uint64_t)numTuples * numComponents * bytesPerValue;
+}
+
+VTUWriter2D::VTUWriter2D(const Mesh2D& gridMesh, const int order)
+  : mesh(gridMesh),
+    gridOrder(order),
+    numPoints(order == 1 ? gridMesh.numNodes : gridMesh.numNodes + gridMesh.numEdges),
+    pointElements(numPoints, -1),
+    pointLocalIndices(numPoints, -1)
+{
+  ASSERT(order == 1 || order == 2, "Grid order must be 1 or 2");
+
+  // Remember an element for every grid point, for evaluating fields of another order
+  for (int K = 0; K < mesh.size; ++K)
+    for (int j = 0; j < numLocalNodes2D(gridOrder); ++j)
+    {
+      const int k = gridPoint(K, j);
+      if (pointElements[k] < 0)
+      {
+        pointElements[k] = K;
+        pointLocalIndices[k] = j;
+      }
+    }
+}
+
+void VTUWriter2D::write(const std::string& fileName) const
+{
+  const int nodesPerCell = numLocalNodes2D(gridOrder);
+  const uint16_t one = 1;
+  const bool littleEndian = *(const char*)&one == 1;
+
+  std::ofstream file(fileName, std::ios::binary);
+  if (!file)
+    LOG("Could not open \"" + fileName + "\" for writing", LogLevel::Error);
+
+  // Offsets of the arrays in the appended data section, in the order they are written
+  uint64_t offset = 0;
+  std::vector<uint64_t> fieldOffsets;
+  for (const Field& field : fields)
+  {
+    fieldOffsets.push_back(offset);
+    offset += appendedArraySize(numPoints, field.numComponents, sizeof(real));
+  }
+  const uint64_t pointsOffset = offset;
+  offset += appendedArraySize(numPoints, 3, sizeof(real));
+  const uint64_t connectivityOffset = offset;
+  offset += appendedArraySize(mesh.size, nodesPerCell, sizeof(int32_t));
+  const uint64_t cellOffsetsOffset = offset;
+  offset += appendedArraySize(mesh.size, 1, sizeof(int32_t));
+  const uint64_t typesOffset = offset;
+
+  // Header
+  file << "<?xml version=\"1.0\"?>\n";
+  file << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << (littleEndian ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\">\n";
+  file << "  <UnstructuredGrid>\n";
+  file << "    <Piece NumberOfPoints=\"" << numPoints << "\" NumberOfCells=\"" << mesh.size << "\">\n";
+  file << "      <PointData>\n";
+  for (int i = 0; i < (int)fields.size(); ++i)
+    file << "        <DataArray type=\"Float64\" Name=\"" << fields[i].name << "\" NumberOfComponents=\"" << fields[i].numComponents << "\" format=\"appended\" offset=\"" << fieldOffsets[i] << "\"/>\n";
+  file << "      </PointData>\n";
+  file << "      <Points>\n";
+  file << "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << pointsOffset << "\"/>\n";
+  file << "      </Points>\n";
+  file << "      <Cells>\n";
+  file << "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"" << connectivityOffset << "\"/>\n";
+  file << "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"" << cellOffsetsOffset << "\"/>\n";
+  file << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << typesOffset << "\"/>\n";
+  file << "      </Cells>\n";
+  file << "    </Piece>\n";
+  file << "  </UnstructuredGrid>\n";
+  file << "  <AppendedData encoding=\"raw\">\n";
+  file << "   _";
+
+  // Appended data
+  for (const Field& field : fields)
+    writeAppendedArray<real>(file, numPoints, field.numComponents, field.sample);
+
+  writeAppendedArray<real>(file, numPoints, 3, [this](const int begin, const int end, real* values)
+  {
+    for (int k = begin; k < end; ++k)
+    {
+      real* point = values + 3 * (k - begin);
+      if (k < mesh.numNodes)
+      {
+        const MeshNode2D A = mesh.node(k);
+        point[0] = A.x;
+        point[1] = A.y;
+      }
+      else
+      {
+        const MeshNode2D A1 = mesh.node(mesh.edgeNode(k - mesh.numNodes, 0));
+        const MeshNode2D A2 = mesh.node(mesh.edgeNode(k - mesh.numNodes, 1));
+        point[0] = 0.5 * (A1.x + A2.x);
+        point[1] = 0.5 * (A1.y + A2.y);
+      }
+      point[2] = 0.0;
+    }
+  });
+
+  writeAppendedArray<int32_t>(file, mesh.size, nodesPerCell, [this, nodesPerCell](const int begin, const int end, int32_t* values)
+  {
+    for (int K = begin; K < end; ++K)
+      for (int j = 0; j < nodesPerCell; ++j)
+        values[(K - begin) * nodesPerCell + j] = gridPoint(K, j);
+  });
+
+  writeAppendedArray<int32_t>(file, mesh.size, 1, [nodesPerCell](const int begin, const int end, int32_t* values)
+  {
+    for (int K = begin; K < end; ++K)
+      values[K - begin] = (K + 1) * nodesPerCell;
+  });
+
+  const unsigned char cellType = gridOrder == 1 ? VTK_TRIANGLE : VTK_QUADRATIC_TRIANGLE;
+  writeAppendedArray<unsigned char>(file, mesh.size, 1, [cellType](const int begin, const int end, unsigned char* values)
+  {
+    for (int K = begin; K < end; ++K)
+      values[K - begin] = cellType;
+  });
+
+  file << "\n  </AppendedData>\n";
+  file << "</VTKFile>\n";
+  file.close();
+}
+
+int VTUWriter2D::gridPoint(const int elementIndex, const int localIndex) const
+{
+  const int& K = elementIndex;
+  const int& j = localIndex;
+
+  if (j < 3)
+    return mesh.elementNode(K, j);
+
+  const int I = mesh.elementNode(K, j - 3);
+  const int J = mesh.elementNode(K, (j - 2) % 3);
+  const int E = mesh.edgeIndex(I, J);
+  ASSERT(E >= 0, "Nodes I and J do not form an edge");
+  return mesh.numNodes + E;
+}
+
+std::vector<std::array<real, 2>> VTUWriter2D::gridRefPoints(const int order)
+{
+  if (order == 1)
+    return { { 0.0, 0.0 }, { 1.0, 0.0 }, { 0.0, 1.0 } };
+  else
+    return { { 0.0, 0.0 }, { 1.0, 0.0 }, { 0.0, 1.0 }, { 0.5, 0.0 }, { 0.5, 0.5 }, { 0.0, 0.5 } };
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "Precompilied.h"
+#include "FEM2D.h"
+
+/*
+  Writes a mesh and FE solutions on it to a VTK XML unstructured grid
+  (.vtu) file, which can be opened in ParaView or VisIt.
+
+  The grid is made up of the mesh elements as linear triangles (order 1),
+  or as quadratic triangles with the edge midpoints as extra points
+  (order 2), so P1 and P2 solutions are shown exactly, without the
+  redundant per-element sampling of FEM2D::plot.  Fields from any number
+  of FEM2D objects on the same mesh can be added.  Fields whose polynomial
+  order differs from that of the grid are evaluated at the grid points.
+
+  All arrays are stored as raw binary in a single appended data section.
+  Since the size of every array is known up front, the header is written
+  first and the arrays are then generated and written in small blocks, so
+  no array is ever held in memory in full.  Data is not compressed, as
+  the only compressors VTK readers understand (zlib, LZ4, LZMA) are not
+  available to this project.
+
+  Fields refer to their FEM2D objects, which must outlive the writer.
+*/
+class VTUWriter2D
+{
+public:
+  VTUWriter2D() = delete;
+
+  /*
+    \param order: Order of the grid triangles, 1 or 2.
+  */
+  VTUWriter2D(const Mesh2D& gridMesh, const int order);
+
+  VTUWriter2D(const VTUWriter2D& other) = delete;
+
+  VTUWriter2D& operator=(const VTUWriter2D& other) = delete;
+
+  /*
+    Adds a scalar field holding the specified variable of fem.
+  */
+  template<int N>
+  void addField(const std::string& name, const FEM2D<N>& fem, const int varIndex)
+  {
+    // Debug
+    ASSERT(varIndex >= 0, "Variable index must be non-negative");
+    ASSERT(varIndex < N, "Variables index must be less than the number of variables");
+
+    addComponents(name, fem, varIndex, 1, 1);
+  }
+
+  /*
+    Adds a vector field with all variables of fem as its components.
+    Two-component fields are padded with a zero third component,
+    as ParaView only treats three-component arrays as vectors.
+  */
+  template<int N>
+  void addVectorField(const std::string& name, const FEM2D<N>& fem)
+  {
+    addComponents(name, fem, 0, N, N == 2 ? 3 : N);
+  }
+
+  /*
+    Writes the grid and all fields added so far to the given file.
+  */
+  void write(const std::string& fileName) const;
+
+private:
+  struct Field
+  {
+    std::string name;
+    int numComponents;
+    std::function<void(int, int, real*)> sample;  // Writes the components at grid points [begin, end)
+  };
+
+  const Mesh2D& mesh;
+  const int gridOrder;
+  const int numPoints;
+  std::vector<int> pointElements;       // An element that contains each grid point
+  std::vector<int> pointLocalIndices;   // Local index of each grid point on that element
+  std::vector<Field> fields{};
+
+  /*
+    \returns the index of the j-th grid point of the K-th element, in
+    VTK order: the three vertices followed by the midpoints of the edges
+    (0, 1), (1, 2) and (2, 0).  This is also the local node order of FEM2D.
+  */
+  int gridPoint(const int elementIndex, const int localIndex) const;
+
+  /*
+    \returns the reference coordinates of the grid points of an element, in the same order as gridPoint.
+  */
+  static std::vector<std::array<real, 2>> gridRefPoints(const int order);
+
+  template<int N>
+  void addComponents(const std::string& name, const FEM2D<N>& fem, const int firstVar, const int numVars, const int numComponents)
+  {
+    ASSERT(&fem.mesh == &mesh, "Fields must be defined on the mesh of the grid");
+
+    Field field = Field();
+    field.name = name;
+    field.numComponents = numComponents;
+
+    // Lagrange FE nodes of the same order are numbered like the grid points (vertices, then edges)
+    if (fem.polynomialOrder == gridOrder && fem.basisType == BasisType::Lagrange)
+      field.sample = [&fem, firstVar, numVars, numComponents](const int begin, const int end, real* values)
+      {
+        for (int k = begin; k < end; ++k)
+          for (int c = 0; c < numComponents; ++c)
+            values[(k - begin) * numComponents + c] = c < numVars ? fem.FENodes[k][firstVar + c] : 0.0;
+      };
+    else
+    {
+      // Tabulate the shape functions of fem at the grid points of the reference triangle
+      dispatchPolynomialOrder(fem.polynomialOrder, [&](auto order)
+      {
+        constexpr int P = decltype(order)::value;
+        const RefBasisTable2D<P> basis = RefBasisTable2D<P>(fem.polynomialOrder, gridRefPoints(gridOrder), fem.basisType);
+
+        field.sample = [this, &fem, basis, firstVar, numVars, numComponents](const int begin, const int end, real* values)
+        {
+          for (int k = begin; k < end; ++k)
+          {
+            const int& K = pointElements[k];
+            const typename RefBasisTable2D<P>::Row& phi = basis.values[pointLocalIndices[k]];
+            for (int c = 0; c < numComponents; ++c)
+            {
+              real sum = 0.0;
+              if (c < numVars)
+                for (int j = 0; j < basis.numShapes; ++j)
+                  sum += fem.shapeSign(K, j) * fem(K, j)[firstVar + c] * phi[j];
+              values[(k - begin) * numComponents + c] = sum;
+            }
+          }
+        };
+      });
+    }
+    fields.push_back(std::move(field));
+  }
+};
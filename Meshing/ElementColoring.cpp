@@ -0,0 +1,50 @@
+#include "Precompilied.h"
+#include "ElementColoring.h"
+
+std::vector<std::vector<int>> colorElements(const int numElements, const int numLocalNodes, const int numGlobalNodes,
+                                            const std::function<int(int, int)>& globalIndex)
+{
+  // Build list of elements containing each FE node
+  std::vector<int> offsets = std::vector<int>(numGlobalNodes + 1, 0);
+  for (int K = 0; K < numElements; ++K)
+    for (int j = 0; j < numLocalNodes; ++j)
+      ++offsets[globalIndex(K, j) + 1];
+  for (int i = 0; i < numGlobalNodes; ++i)
+    offsets[i + 1] += offsets[i];
+
+  std::vector<int> nodeElements = std::vector<int>(offsets[numGlobalNodes]);
+  std::vector<int> fill = std::vector<int>(offsets.begin(), offsets.end() - 1);
+  for (int K = 0; K < numElements; ++K)
+    for (int j = 0; j < numLocalNodes; ++j)
+      nodeElements[fill[globalIndex(K, j)]++] = K;
+
+  // Give each element the smallest color not used by an already colored neighbor
+  std::vector<int> elementColor = std::vector<int>(numElements, -1);
+  std::vector<int> lastUsedBy = std::vector<int>();  // lastUsedBy[c] is the last element to see color c on a neighbor
+  std::vector<std::vector<int>> colors{};
+  for (int K = 0; K < numElements; ++K)
+  {
+    for (int j = 0; j < numLocalNodes; ++j)
+    {
+      const int i = globalIndex(K, j);
+      for (int n = offsets[i]; n < offsets[i + 1]; ++n)
+      {
+        const int c = elementColor[nodeElements[n]];
+        if (c >= 0)
+          lastUsedBy[c] = K;
+      }
+    }
+
+    int c = 0;
+    while (c < (int)colors.size() && lastUsedBy[c] == K)
+      ++c;
+    if (c == (int)colors.size())
+    {
+      colors.emplace_back();
+      lastUsedBy.push_back(-1);
+    }
+    elementColor[K] = c;
+    colors[c].push_back(K);
+  }
+  return colors;
+}
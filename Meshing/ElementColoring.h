@@ -0,0 +1,27 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Number of elements handed to a thread at a time during parallel assembly.
+*/
+constexpr int ElementGrainSize = 32;
+
+/*
+  Number of points handed to a thread at a time when evaluating at many points.
+*/
+constexpr int PointGrainSize = 1024;
+
+/*
+  \returns a partition of the elements into color classes, such that no
+  two elements of the same color share an FE node.  Elements of a single
+  color can therefore be assembled in parallel without write conflicts.
+  colors[c] lists the elements of color c in increasing order.
+
+  Uses greedy coloring, visiting elements in order.
+
+  \param numLocalNodes: Number of FE nodes per element.
+  \param numGlobalNodes: Total number of FE nodes.
+  \param globalIndex: globalIndex(K, j) gives the index of the j-th FE node of element K.
+*/
+std::vector<std::vector<int>> colorElements(const int numElements, const int numLocalNodes, const int numGlobalNodes,
+                                            const std::function<int(int, int)>& globalIndex);
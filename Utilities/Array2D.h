@@ -41,16 +41,14 @@ public:
     return *this;
   }
 
-  Container<T>& operator[](const int index)
+  T* operator[](const int index)
   {
-    container.index1 = index;
-    return container;
+    return container[index];
   }
 
-  const Container<T>& operator[](const int index) const
+  const T* operator[](const int index) const
   {
-    container.index1 = index;
-    return container;
+    return container[index];
   }
 
 private:
@@ -0,0 +1,75 @@
+#include "Precompilied.h"
+#include "ChunkedWriter.h"
+#include "TaskScheduler.h"
+
+void TextChunk::writeLine(const real* values, const int count)
+{
+  // %g with precision 6 is the default formatting of std::ostream
+  char number[32];
+  for (int i = 0; i < count; ++i)
+  {
+    if (i > 0)
+      buffer += ", ";
+    const int length = snprintf(number, sizeof(number), "%g", values[i]);
+    buffer.append(number, length);
+  }
+  buffer += '\n';
+}
+
+void TextChunk::writeLine(std::initializer_list<real> values)
+{
+  writeLine(values.begin(), (int)values.size());
+}
+
+void TextChunk::clear()
+{
+  buffer.clear();
+}
+
+const std::string& TextChunk::str() const
+{
+  return buffer;
+}
+
+void writeChunked(const std::string& fileName, const int numItems, const int grainSize,
+                  const std::function<void(int, int, TextChunk&)>& format)
+{
+  ASSERT(grainSize > 0, "Grain size must be positive");
+
+  std::ofstream file(fileName);
+  if (!file)
+    LOG("Could not open \"" + fileName + "\" for writing", LogLevel::Error);
+
+  // Format a window of chunks in parallel, then write them out in order.
+  // Chunks are reused between windows so their buffers are only allocated once
+  const int numChunks = (numItems + grainSize - 1) / grainSize;
+  const int windowSize = std::min(numChunks, 8 * numThreads());
+  std::vector<TextChunk> chunks = std::vector<TextChunk>(windowSize);
+  for (int windowBegin = 0; windowBegin < numChunks; windowBegin += windowSize)
+  {
+    const int windowEnd = std::min(windowBegin + windowSize, numChunks);
+    parallelFor(windowBegin, windowEnd, 1, [&](const int begin, const int end)
+    {
+      for (int c = begin; c < end; ++c)
+      {
+        TextChunk& chunk = chunks[c - windowBegin];
+        chunk.clear();
+        format(c * grainSize, std::min((c + 1) * grainSize, numItems), chunk);
+      }
+    });
+
+    for (int c = windowBegin; c < windowEnd; ++c)
+    {
+      const std::string& text = chunks[c - windowBegin].str();
+      file.write(text.data(), text.size());
+    }
+  }
+  file.close();
+}
+
+void waitAndRemove(const std::string& fileName)
+{
+  std::cout << "Data written to \"" << fileName << "\".  Press any key to continue" << std::endl;
+  std::cin.get();
+  remove(fileName.c_str());
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  A block of text output that is formatted in memory
+  before being written to a file in one go.
+*/
+class TextChunk
+{
+public:
+  /*
+    Appends a line of comma separated values.  Values are formatted
+    the same way as by a std::ostream with default settings.
+  */
+  void writeLine(const real* values, const int count);
+  void writeLine(std::initializer_list<real> values);
+
+  void clear();
+
+  const std::string& str() const;
+
+private:
+  std::string buffer;
+};
+
+/*
+  Writes a text file made up of numItems items (e.g. mesh elements),
+  without any interaction with the user.
+
+  The items are split into ranges of at most grainSize items and
+  format(rangeBegin, rangeEnd, chunk) is called in parallel to format
+  each range into its own chunk.  Chunks are written to the file in
+  order, so the output is the same on any number of threads.  Only a
+  few chunks per thread are held in memory at any time.
+*/
+void writeChunked(const std::string& fileName, const int numItems, const int grainSize,
+                  const std::function<void(int, int, TextChunk&)>& format);
+
+/*
+  Tells the user where data was written to and waits for a key press,
+  after which the file is removed.  Used by the interactive plot functions.
+*/
+void waitAndRemove(const std::string& fileName);
@@ -8,12 +8,10 @@ template<typename T>
 struct Container
 {
 public:
-  mutable int index1;
-
   Container() = delete;
 
   Container(const int size1, const int size2)
-    : M(size2), index1(0)
+    : M(size2)
   {
     data = new T[size1 * size2];
   }
@@ -21,7 +19,7 @@ public:
   Container(const Container& other) = delete;
 
   Container(Container&& other) noexcept
-    : M(other.M), index1(other.index1)
+    : M(other.M)
   {
     data = other.data;
     other.data = nullptr;
@@ -34,7 +32,6 @@ public:
     if (&other != this)
     {
       M = other.M;
-      index1 = other.index1;
 
       delete[] data;
       data = other.data;
@@ -43,14 +40,20 @@ public:
     return *this;
   }
 
-  T& operator[](const int index2)
+  /*
+    \returns a pointer to the start of the specified row.
+
+    Does not modify the container, so concurrent access from several
+    threads is safe as long as they do not write to the same entries.
+  */
+  T* operator[](const int index1)
   {
-    return data[index1 * M + index2];
+    return data + index1 * M;
   }
 
-  const T& operator[](const int index2) const
+  const T* operator[](const int index1) const
   {
-    return data[index1 * M + index2];
+    return data + index1 * M;
   }
 
   ~Container()
@@ -0,0 +1,119 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  An array for element-local data.
+
+  When Size > 0 the entries live on the stack and loops over them have
+  compile-time trip counts, which allows the compiler to fully unroll
+  and vectorize them.  Size = 0 means the size is only known at runtime,
+  in which case the entries are heap-allocated.
+*/
+template<typename T, int Size>
+class LocalArray
+{
+public:
+  LocalArray(const int n = Size)
+  {
+    ASSERT(n == Size, "Runtime size does not match compile-time size");
+    for (int i = 0; i < Size; ++i)
+      entries[i] = T();
+  }
+
+  T& operator[](const int index) { return entries[index]; }
+  const T& operator[](const int index) const { return entries[index]; }
+
+  T* data() { return entries; }
+  const T* data() const { return entries; }
+
+  static constexpr int size() { return Size; }
+
+private:
+  T entries[Size];
+};
+
+template<typename T>
+class LocalArray<T, 0>
+{
+public:
+  LocalArray(const int n = 0)
+    : entries(n)
+  {
+  }
+
+  T& operator[](const int index) { return entries[index]; }
+  const T& operator[](const int index) const { return entries[index]; }
+
+  T* data() { return entries.data(); }
+  const T* data() const { return entries.data(); }
+
+  int size() const { return (int)entries.size(); }
+
+private:
+  std::vector<T> entries;
+};
+
+/*
+  A Rows x Cols matrix for element-local data, stored row-major.
+
+  Follows the same conventions as LocalArray, a dimension of 0 means
+  both dimensions are only known at runtime.
+*/
+template<typename T, int Rows, int Cols>
+class LocalMatrix
+{
+public:
+  LocalMatrix(const int rows = Rows, const int cols = Cols)
+  {
+    ASSERT(rows == Rows && cols == Cols, "Runtime size does not match compile-time size");
+    setZero();
+  }
+
+  T* operator[](const int row) { return entries + row * Cols; }
+  const T* operator[](const int row) const { return entries + row * Cols; }
+
+  void setZero()
+  {
+    for (int i = 0; i < Rows * Cols; ++i)
+      entries[i] = T();
+  }
+
+  T* data() { return entries; }
+  const T* data() const { return entries; }
+
+  static constexpr int rows() { return Rows; }
+  static constexpr int columns() { return Cols; }
+
+private:
+  T entries[Rows * Cols];
+};
+
+template<typename T>
+class LocalMatrix<T, 0, 0>
+{
+public:
+  LocalMatrix(const int rows = 0, const int cols = 0)
+    : n(rows), m(cols), entries(rows * cols)
+  {
+  }
+
+  T* operator[](const int row) { return entries.data() + row * m; }
+  const T* operator[](const int row) const { return entries.data() + row * m; }
+
+  void setZero()
+  {
+    for (int i = 0; i < n * m; ++i)
+      entries[i] = T();
+  }
+
+  T* data() { return entries.data(); }
+  const T* data() const { return entries.data(); }
+
+  int rows() const { return n; }
+  int columns() const { return m; }
+
+private:
+  int n;
+  int m;
+  std::vector<T> entries;
+};
@@ -0,0 +1,62 @@
+#include "Precompilied.h"
+#include "OutputQueue.h"
+
+OutputQueue::OutputQueue(const int queueCapacity)
+  : capacity(queueCapacity)
+{
+  ASSERT(capacity > 0, "Queue capacity must be positive");
+
+  writer = std::thread([this]() { writerLoop(); });
+}
+
+OutputQueue::~OutputQueue()
+{
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobAdded.notify_all();
+  writer.join();
+}
+
+void OutputQueue::submit(std::function<void()> job)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this]() { return numUnfinishedJobs < capacity; });
+    jobs.push_back(std::move(job));
+    ++numUnfinishedJobs;
+  }
+  jobAdded.notify_one();
+}
+
+void OutputQueue::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  jobFinished.wait(lock, [this]() { return numUnfinishedJobs == 0; });
+}
+
+void OutputQueue::writerLoop()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobAdded.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty())
+        return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+
+    job();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --numUnfinishedJobs;
+    }
+    jobFinished.notify_all();
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Runs output jobs, such as writing solution files, in order on a
+  background thread, so that the thread submitting them can go on with
+  the next solve or time step while the previous results are written.
+
+  At most capacity jobs are waiting or running at any time.  Submitting
+  a job to a full queue blocks until the oldest job has finished, so a
+  producer that outpaces the disk is slowed down rather than piling up
+  memory.  Jobs must not depend on data that the producer modifies
+  afterwards; solution data is usually handed over as a snapshot
+  (see Meshing/2D/SnapshotPool2D.h).
+*/
+class OutputQueue
+{
+public:
+  OutputQueue(const int queueCapacity = 2);
+
+  OutputQueue(const OutputQueue& other) = delete;
+
+  OutputQueue& operator=(const OutputQueue& other) = delete;
+
+  /*
+    Waits for all submitted jobs to finish before returning.
+  */
+  ~OutputQueue();
+
+  /*
+    Queues a job to be run on the background thread.
+    Blocks while the queue is full.
+  */
+  void submit(std::function<void()> job);
+
+  /*
+    Waits until all submitted jobs have finished.
+  */
+  void flush();
+
+private:
+  const int capacity;
+  std::deque<std::function<void()>> jobs;
+  int numUnfinishedJobs = 0;
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable jobAdded;
+  std::condition_variable jobFinished;
+  std::thread writer;
+
+  void writerLoop();
+};
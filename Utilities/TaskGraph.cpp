@@ -0,0 +1,127 @@
+#include "Precompilied.h"
+#include "TaskGraph.h"
+
+TaskGraph::TaskGraph(const std::string& graphName)
+  : name(graphName)
+{
+}
+
+int TaskGraph::add(const std::string& taskName, std::function<void()> f, const std::vector<int>& dependencies)
+{
+  const int index = (int)nodes.size();
+
+  Node node = Node();
+  node.name = taskName;
+  node.function = std::move(f);
+  node.dependencies = dependencies;
+  node.remainingDependencies.reset(new std::atomic<int>(0));
+  nodes.push_back(std::move(node));
+
+  for (const int d : dependencies)
+  {
+    // Debug
+    ASSERT(d >= 0 && d < index, "Dependencies must be added to the graph first");
+
+    nodes[d].successors.push_back(index);
+  }
+  return index;
+}
+
+void TaskGraph::run()
+{
+  for (Node& node : nodes)
+    *node.remainingDependencies = (int)node.dependencies.size();
+
+  runStart = std::chrono::steady_clock::now();
+  {
+    TaskGroup group;
+    for (int i = 0; i < (int)nodes.size(); ++i)
+      if (nodes[i].dependencies.empty())
+        group.run([this, i, &group]() { execute(i, group); });
+    group.wait();
+  }
+
+#pragma warning(suppress: 4996)
+  const char* trace = std::getenv("FE_TASK_TRACE");
+  if (trace != nullptr && std::string(trace) == "1")
+    printTrace();
+}
+
+void TaskGraph::execute(const int nodeIndex, TaskGroup& group)
+{
+  Node& node = nodes[nodeIndex];
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  node.function();
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  node.start = std::chrono::duration<real, std::milli>(start - runStart).count();
+  node.end = std::chrono::duration<real, std::milli>(end - runStart).count();
+  node.thread = std::this_thread::get_id();
+
+  // Launch successors whose inputs are now all ready
+  for (const int s : node.successors)
+    if (--(*nodes[s].remainingDependencies) == 0)
+      group.run([this, s, &group]() { execute(s, group); });
+}
+
+std::vector<int> TaskGraph::criticalPath() const
+{
+  // Nodes are stored in a valid execution order, so one forward pass
+  // finds the longest chain of dependent tasks ending at each node
+  const int numNodes = (int)nodes.size();
+  std::vector<real> pathLength = std::vector<real>(numNodes, 0.0);
+  std::vector<int> predecessor = std::vector<int>(numNodes, -1);
+  for (int i = 0; i < numNodes; ++i)
+  {
+    for (const int d : nodes[i].dependencies)
+      if (pathLength[d] > pathLength[i])
+      {
+        pathLength[i] = pathLength[d];
+        predecessor[i] = d;
+      }
+    pathLength[i] += nodes[i].end - nodes[i].start;
+  }
+
+  int last = -1;
+  for (int i = 0; i < numNodes; ++i)
+    if (last < 0 || pathLength[i] > pathLength[last])
+      last = i;
+
+  std::vector<int> path{};
+  for (int i = last; i >= 0; i = predecessor[i])
+    path.push_back(i);
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+void TaskGraph::printTrace(std::ostream& stream) const
+{
+  // Number threads in order of appearance
+  std::vector<std::thread::id> threads{};
+  auto threadNumber = [&threads](const std::thread::id id)
+  {
+    for (int t = 0; t < (int)threads.size(); ++t)
+      if (threads[t] == id)
+        return t;
+    threads.push_back(id);
+    return (int)threads.size() - 1;
+  };
+
+  real totalTime = 0.0;
+  stream << "Task trace for " << name << ":" << std::endl;
+  for (const Node& node : nodes)
+  {
+    stream << "  " << node.name << ": " << node.start << "ms - " << node.end << "ms on thread " << threadNumber(node.thread) << std::endl;
+    totalTime = std::max(totalTime, node.end);
+  }
+
+  real criticalTime = 0.0;
+  stream << "Critical path:";
+  for (const int i : criticalPath())
+  {
+    stream << " " << nodes[i].name;
+    criticalTime += nodes[i].end - nodes[i].start;
+  }
+  stream << std::endl << "  " << criticalTime << "ms of " << totalTime << "ms total" << std::endl;
+}
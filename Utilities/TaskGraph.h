@@ -0,0 +1,72 @@
+#pragma once
+#include "Precompilied.h"
+#include "TaskScheduler.h"
+
+/*
+  A set of coarse-grained tasks with dependencies between them,
+  executed on the TaskScheduler.
+
+  Each task is started as soon as all of the tasks it depends on have
+  finished, so independent tasks (e.g. the assembly of different
+  operators in a solve) run concurrently.  Tasks may themselves use
+  parallelFor and friends.
+
+  Start and end times of every task are recorded, so the critical path,
+  the chain of dependent tasks that bounds the total run time, can be
+  inspected after a run.  If the environment variable FE_TASK_TRACE is
+  set to 1, the trace is printed to the console after every run.
+*/
+class TaskGraph
+{
+public:
+  TaskGraph(const std::string& graphName);
+
+  TaskGraph(const TaskGraph& other) = delete;
+
+  TaskGraph& operator=(const TaskGraph& other) = delete;
+
+  /*
+    Adds a task to the graph.
+
+    \param dependencies: Indices of tasks that must finish before this one starts.
+    Since these must already be in the graph, tasks are added in a valid execution order.
+    \returns the index of the new task.
+  */
+  int add(const std::string& taskName, std::function<void()> f, const std::vector<int>& dependencies = {});
+
+  /*
+    Runs all tasks of the graph and returns once they have finished.
+  */
+  void run();
+
+  /*
+    \returns the indices of the tasks on the critical path of the last run,
+    in execution order.
+  */
+  std::vector<int> criticalPath() const;
+
+  /*
+    Prints the start and end time of each task in the last run,
+    followed by the critical path.
+  */
+  void printTrace(std::ostream& stream = std::cout) const;
+
+private:
+  struct Node
+  {
+    std::string name;
+    std::function<void()> function;
+    std::vector<int> dependencies;
+    std::vector<int> successors;
+    std::unique_ptr<std::atomic<int>> remainingDependencies;
+    real start = 0.0;  // In milliseconds since the start of the run
+    real end = 0.0;
+    std::thread::id thread;
+  };
+
+  std::string name;
+  std::vector<Node> nodes;
+  std::chrono::steady_clock::time_point runStart;
+
+  void execute(const int nodeIndex, TaskGroup& group);
+};
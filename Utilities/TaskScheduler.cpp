@@ -0,0 +1,204 @@
+#include "Precompilied.h"
+#include "TaskScheduler.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Index of the queue owned by the current thread, -1 for threads that are not workers
+static thread_local int currentQueue = -1;
+
+static int environmentInt(const char* name, const int defaultValue)
+{
+#pragma warning(suppress: 4996)
+  const char* value = std::getenv(name);
+  if (value == nullptr || *value == '\0')
+    return defaultValue;
+  return std::atoi(value);
+}
+
+static void pinThread(std::thread& thread, const int hardwareThread)
+{
+#if defined(_WIN32)
+  SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)1 << (hardwareThread % (8 * sizeof(DWORD_PTR))));
+#elif defined(__linux__)
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(hardwareThread % CPU_SETSIZE, &cpuSet);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#endif
+}
+
+TaskScheduler::TaskScheduler(const int numThreads, const bool pinThreads)
+{
+  ASSERT(numThreads > 0, "Scheduler must have at least one thread");
+
+  const int numWorkers = numThreads - 1;
+  for (int i = 0; i < numWorkers + 1; ++i)
+    queues.emplace_back(new WorkQueue());
+
+  const int numHardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+  for (int i = 0; i < numWorkers; ++i)
+  {
+    workers.emplace_back([this, i]() { workerLoop(i); });
+    if (pinThreads)
+      pinThread(workers.back(), (i + 1) % numHardwareThreads);
+  }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+
+  // The program may be exiting from a worker (e.g. through LOG with an error),
+  // which cannot join itself
+  for (std::thread& worker : workers)
+    if (currentQueue >= 0)
+      worker.detach();
+    else
+      worker.join();
+}
+
+int TaskScheduler::size() const
+{
+  return (int)workers.size() + 1;
+}
+
+TaskScheduler& TaskScheduler::global()
+{
+  static TaskScheduler scheduler(std::max(1, environmentInt("FE_NUM_THREADS", (int)std::thread::hardware_concurrency())),
+                                 environmentInt("FE_PIN_THREADS", 0) == 1);
+  return scheduler;
+}
+
+void TaskScheduler::spawn(Task* task)
+{
+  WorkQueue& queue = currentQueue >= 0 ? *queues[currentQueue] : *queues.back();
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+
+  // A sleeping worker checks numQueuedTasks while holding sleepMutex,
+  // so notifying under the same mutex cannot be missed
+  ++numQueuedTasks;
+  if (numSleepingWorkers > 0)
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wakeUp.notify_one();
+  }
+}
+
+TaskScheduler::Task* TaskScheduler::popOrSteal(const int queueIndex)
+{
+  // Newest task from own queue first
+  if (queueIndex >= 0)
+  {
+    WorkQueue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      Task* task = queue.tasks.back();
+      queue.tasks.pop_back();
+      return task;
+    }
+  }
+
+  // Otherwise oldest task from any other queue, starting with the next one
+  const int numQueues = (int)queues.size();
+  const int start = queueIndex >= 0 ? queueIndex + 1 : 0;
+  for (int i = 0; i < numQueues; ++i)
+  {
+    const int victim = (start + i) % numQueues;
+    if (victim == queueIndex)
+      continue;
+
+    WorkQueue& queue = *queues[victim];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      Task* task = queue.tasks.front();
+      queue.tasks.pop_front();
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+bool TaskScheduler::runOneTask(const int queueIndex)
+{
+  if (numQueuedTasks == 0)
+    return false;
+
+  Task* task = popOrSteal(queueIndex);
+  if (task == nullptr)
+    return false;
+  --numQueuedTasks;
+
+  task->function();
+  --(*task->pending);
+  delete task;
+  return true;
+}
+
+void TaskScheduler::workerLoop(const int workerIndex)
+{
+  currentQueue = workerIndex;
+  while (!stopping)
+  {
+    if (runOneTask(workerIndex))
+      continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    ++numSleepingWorkers;
+    wakeUp.wait(lock, [this]() { return stopping || numQueuedTasks > 0; });
+    --numSleepingWorkers;
+  }
+}
+
+// --------------------------------------------------------- //
+
+TaskGroup::TaskGroup(TaskScheduler& taskScheduler)
+  : scheduler(taskScheduler)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  wait();
+}
+
+void TaskGroup::run(std::function<void()> f)
+{
+  // Nothing to run tasks on but the current thread
+  if (scheduler.workers.empty())
+  {
+    f();
+    return;
+  }
+
+  ++pending;
+  scheduler.spawn(new TaskScheduler::Task{ std::move(f), &pending });
+}
+
+void TaskGroup::wait()
+{
+  while (pending > 0)
+    if (!scheduler.runOneTask(currentQueue))
+      std::this_thread::yield();
+}
+
+// --------------------------------------------------------- //
+
+int numThreads()
+{
+  return TaskScheduler::global().size();
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include "Precompilied.h"
+
+/*
+  Work-stealing task scheduler shared by the whole library.
+
+  Each worker thread owns a deque of tasks.  Tasks spawned by a worker
+  are pushed onto and popped from the back of its own deque, so that
+  recently spawned (cache-warm) work runs first, while idle workers
+  steal from the front of other deques, which holds the largest
+  remaining pieces of work.  Threads that wait for tasks to finish
+  execute other tasks in the meantime, so parallel loops may be nested
+  freely.
+
+  All concurrency policy of the library lives here.  The scheduler is
+  configured from the environment on first use:
+
+    FE_NUM_THREADS: Number of threads taking part in parallel work,
+                    including the calling thread.  Defaults to the number
+                    of hardware threads.  A value of 1 runs everything
+                    serially on the calling thread.
+    FE_PIN_THREADS: If set to 1, worker i is pinned to hardware thread i + 1
+                    (the calling thread is left alone).  Only supported on
+                    Windows and Linux, ignored elsewhere.
+*/
+class TaskScheduler
+{
+public:
+  /*
+    Creates a scheduler that runs tasks on numThreads threads in total,
+    the thread that waits for a task group being one of them.
+  */
+  TaskScheduler(const int numThreads, const bool pinThreads);
+
+  TaskScheduler(const TaskScheduler& other) = delete;
+
+  TaskScheduler& operator=(const TaskScheduler& other) = delete;
+
+  ~TaskScheduler();
+
+  /*
+    \returns the number of threads that take part in parallel work.
+  */
+  int size() const;
+
+  /*
+    \returns the scheduler shared by the whole library.
+  */
+  static TaskScheduler& global();
+
+private:
+  friend class TaskGroup;
+
+  struct Task
+  {
+    std::function<void()> function;
+    std::atomic<int>* pending;
+  };
+
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<Task*> tasks;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<WorkQueue>> queues;  // One per worker, plus one for external threads at the end
+  std::atomic<int> numQueuedTasks{ 0 };
+  std::atomic<int> numSleepingWorkers{ 0 };
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  std::atomic<bool> stopping{ false };
+
+  void spawn(Task* task);
+
+  /*
+    Runs one queued task, if one can be found.
+
+    \returns true if a task was run.
+  */
+  bool runOneTask(const int queueIndex);
+
+  Task* popOrSteal(const int queueIndex);
+
+  void workerLoop(const int workerIndex);
+};
+
+/*
+  A set of tasks that can be waited on together.
+
+  The destructor waits for all tasks that have not been waited on yet,
+  so a task group never outlives its tasks.
+*/
+class TaskGroup
+{
+public:
+  TaskGroup(TaskScheduler& taskScheduler = TaskScheduler::global());
+
+  TaskGroup(const TaskGroup& other) = delete;
+
+  TaskGroup& operator=(const TaskGroup& other) = delete;
+
+  ~TaskGroup();
+
+  /*
+    Schedules f to be run on any thread of the scheduler.
+  */
+  void run(std::function<void()> f);
+
+  /*
+    Waits until all tasks of this group have finished,
+    running queued tasks of any group in the meantime.
+  */
+  void wait();
+
+private:
+  TaskScheduler& scheduler;
+  std::atomic<int> pending{ 0 };
+};
+
+/*
+  \returns the number of threads that take part in parallel work.
+*/
+int numThreads();
+
+/*
+  Calls f(rangeBegin, rangeEnd) on disjoint subranges of [begin, end)
+  of at most grainSize indices, in parallel.  Returns once the whole
+  range has been processed.
+
+  The range is split recursively in halves, so idle threads steal
+  large pieces of work first.
+*/
+template<typename Function>
+void parallelFor(const int begin, const int end, const int grainSize, const Function& f)
+{
+  ASSERT(grainSize > 0, "Grain size must be positive");
+
+  if (end - begin <= grainSize || numThreads() == 1)
+  {
+    for (int rangeBegin = begin; rangeBegin < end; rangeBegin += grainSize)
+      f(rangeBegin, std::min(rangeBegin + grainSize, end));
+    return;
+  }
+
+  // Keep split points on multiples of the grain size
+  const int numChunks = (end - begin + grainSize - 1) / grainSize;
+  const int mid = begin + (numChunks / 2) * grainSize;
+
+  TaskGroup group;
+  group.run([&]() { parallelFor(begin, mid, grainSize, f); });
+  parallelFor(mid, end, grainSize, f);
+  group.wait();
+}
+
+/*
+  \returns combine applied over map(rangeBegin, rangeEnd) for disjoint
+  subranges of [begin, end) of at most grainSize indices, computed in parallel.
+
+  Subranges are combined pairwise in a fixed tree that only depends on the
+  range and the grain size, so the result is the same on any number of
+  threads, even for operations such as floating point addition that are
+  not associative.
+
+  \param identity: Value returned for an empty range.
+*/
+template<typename T, typename Map, typename Combine>
+T parallelReduce(const int begin, const int end, const int grainSize, const T& identity, const Map& map, const Combine& combine)
+{
+  ASSERT(grainSize > 0, "Grain size must be positive");
+
+  if (end <= begin)
+    return identity;
+  if (end - begin <= grainSize)
+    return map(begin, end);
+
+  const int numChunks = (end - begin + grainSize - 1) / grainSize;
+  const int mid = begin + (numChunks / 2) * grainSize;
+
+  T left = identity;
+  TaskGroup group;
+  group.run([&]() { left = parallelReduce(begin, mid, grainSize, identity, map, combine); });
+  const T right = parallelReduce(mid, end, grainSize, identity, map, combine);
+  group.wait();
+  return combine(left, right);
+}